@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <sched.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+
+/** The configuration of a `Harness`, parsed from the command line of a benchmark. */
+struct BenchmarkOptions
+{
+    enum class Format { CSV, JSON };
+
+    std::size_t warmup = 1; ///< the number of unmeasured runs before the measured ones
+    std::size_t repetitions = 5; ///< the number of measured runs
+    int cpu = -1; ///< the CPU to pin the thread creating the harness to, or -1 to not pin it
+    bool flush_caches = false; ///< whether to evict the caches before every run
+    Format format = Format::CSV;
+
+    /** Parses the options `[--warmup N] [--repetitions N] [--pin CPU] [--flush-caches] [--format csv|json]` from
+     * \p argv, following the name of the program. */
+    static std::optional<BenchmarkOptions> Parse(int argc, const char * const *argv)
+    {
+        BenchmarkOptions options;
+        for (int i = 1; i != argc; ++i) {
+            const bool has_value = i + 1 != argc;
+            if (std::strcmp(argv[i], "--flush-caches") == 0) {
+                options.flush_caches = true;
+            } else if (std::strcmp(argv[i], "--warmup") == 0 and has_value) {
+                options.warmup = std::strtoul(argv[++i], nullptr, 10);
+            } else if (std::strcmp(argv[i], "--repetitions") == 0 and has_value) {
+                options.repetitions = std::max(1UL, std::strtoul(argv[++i], nullptr, 10));
+            } else if (std::strcmp(argv[i], "--pin") == 0 and has_value) {
+                options.cpu = std::atoi(argv[++i]);
+            } else if (std::strcmp(argv[i], "--format") == 0 and has_value) {
+                ++i;
+                if (std::strcmp(argv[i], "csv") == 0)
+                    options.format = Format::CSV;
+                else if (std::strcmp(argv[i], "json") == 0)
+                    options.format = Format::JSON;
+                else
+                    return std::nullopt;
+            } else {
+                return std::nullopt;
+            }
+        }
+        return options;
+    }
+
+    /** Parses the options from \p argv like `Parse()`, but exits with a usage message if they are invalid. */
+    static BenchmarkOptions ParseOrExit(int argc, const char * const *argv)
+    {
+        auto options = Parse(argc, argv);
+        if (not options) {
+            std::cerr << "USAGE:\n    " << argv[0]
+                      << " [--warmup N] [--repetitions N] [--pin CPU] [--flush-caches] [--format csv|json]\n\n"
+                      << "Runs every benchmark N times after warmup runs and writes one line per benchmark: "
+                         "`<bench>,<name>,<median µs>,<min µs>,<p95 µs>,<p99 µs>,<repetitions>,<fields>...` for "
+                         "csv, or a JSON object with all samples for json." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return *options;
+    }
+};
+
+/** The durations of the measured runs of a benchmark in µs, in ascending order. */
+struct Samples
+{
+    std::vector<double> us;
+
+    double min() const { return us.front(); }
+    double max() const { return us.back(); }
+    /** Returns the nearest-rank \p p-percentile, e.g. the median for `p = .5`. */
+    double percentile(double p) const
+    {
+        const std::size_t rank = std::ceil(p * us.size());
+        return us[std::clamp<std::size_t>(rank, 1, us.size()) - 1];
+    }
+    double median() const { return percentile(.5); }
+};
+
+/** Measures benchmarks with warmup runs and repetitions and reports their distribution, optionally pinned to one CPU
+ * and with the caches evicted before every run.
+ *
+ * In CSV format, every benchmark is reported as a line `<bench>,<name>,<median>,<min>,<p95>,<p99>,<repetitions>`
+ * followed by the values of its additional fields; in JSON format as one JSON object per line, with the samples and
+ * the additional fields as members.  Values that are not measured, e.g. sizes, are reported as a line
+ * `<bench>,<name>,<fields>...` respectively as an object without samples. */
+struct Harness
+{
+    /** An additional value reported with a benchmark, e.g. a checksum of its result. */
+    struct Field
+    {
+        std::string name;
+        std::string value;
+
+        Field(std::string name, std::string value) : name(std::move(name)), value(std::move(value)) { }
+        template<typename T>
+        Field(std::string name, const T &value) : name(std::move(name))
+        {
+            std::ostringstream oss;
+            oss << value;
+            this->value = oss.str();
+        }
+
+        /** Returns a field with \p value in hexadecimal, as checksums and costs are reported. */
+        static Field Hex(std::string name, uint64_t value)
+        {
+            std::ostringstream oss;
+            oss << std::hex << value;
+            return Field(std::move(name), oss.str());
+        }
+    };
+
+    const BenchmarkOptions options;
+
+    private:
+    std::ostream &out_;
+    std::vector<uint8_t> flush_buffer_; ///< larger than the last-level cache, written to evict the caches
+
+    public:
+    explicit Harness(BenchmarkOptions options, std::ostream &out = std::cout)
+        : options(options), out_(out)
+    {
+        if (options.cpu >= 0) {
+            /* Pin the calling thread only.  Threads created afterwards inherit the pinning, so that the workers of a
+             * `ThreadPool` created after the harness all run on this one CPU: create pools before the harness. */
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(options.cpu, &set);
+            if (sched_setaffinity(0, sizeof(set), &set) != 0)
+                std::cerr << "cannot pin to CPU " << options.cpu << ": " << std::strerror(errno) << std::endl;
+        }
+        if (options.flush_caches) {
+            const long llc_size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+            flush_buffer_.resize(llc_size > 0 ? 4 * llc_size : 64UL << 20);
+        }
+    }
+
+    Harness(const Harness&) = delete;
+    Harness & operator=(const Harness&) = delete;
+
+    /** Runs \p fn `options.warmup` times and then measures `options.repetitions` runs of it. */
+    template<typename Fn>
+    Samples measure(Fn &&fn) { return measure(fn, options.warmup, options.repetitions); }
+
+    /** Runs \p fn \p warmup times and then measures \p repetitions runs of it, e.g. fewer than configured for
+     * benchmarks too expensive to repeat. */
+    template<typename Fn>
+    Samples measure(Fn &&fn, std::size_t warmup, std::size_t repetitions)
+    {
+        using namespace std::chrono;
+
+        Samples samples;
+        for (std::size_t i = 0; i != warmup; ++i)
+            fn();
+        for (std::size_t i = 0; i != std::max<std::size_t>(1, repetitions); ++i) {
+            if (options.flush_caches)
+                flush_caches();
+            const auto t_begin = steady_clock::now();
+            fn();
+            const auto t_end = steady_clock::now();
+            samples.us.push_back(duration_cast<nanoseconds>(t_end - t_begin).count() / 1e3);
+        }
+        std::sort(samples.us.begin(), samples.us.end());
+        return samples;
+    }
+
+    /** Reports the \p samples of the benchmark \p name of \p bench together with the additional \p fields. */
+    void report(std::string_view bench, std::string_view name, const Samples &samples,
+                const std::vector<Field> &fields = {})
+    {
+        if (options.format == BenchmarkOptions::Format::CSV) {
+            out_ << bench << ',' << name << ',' << samples.median() << ',' << samples.min() << ','
+                 << samples.percentile(.95) << ',' << samples.percentile(.99) << ',' << samples.us.size();
+            for (auto &field : fields)
+                out_ << ',' << field.value;
+            out_ << '\n';
+        } else {
+            begin_object(bench, name);
+            out_ << ",\"unit\":\"us\",\"repetitions\":" << samples.us.size() << ",\"warmup\":" << options.warmup
+                 << ",\"min\":" << samples.min() << ",\"median\":" << samples.median()
+                 << ",\"p95\":" << samples.percentile(.95) << ",\"p99\":" << samples.percentile(.99)
+                 << ",\"max\":" << samples.max() << ",\"samples\":[";
+            for (std::size_t i = 0; i != samples.us.size(); ++i)
+                out_ << (i ? "," : "") << samples.us[i];
+            out_ << ']';
+            end_object(fields);
+        }
+    }
+
+    /** Reports the values \p fields of \p name of \p bench, which are not measured. */
+    void report(std::string_view bench, std::string_view name, const std::vector<Field> &fields)
+    {
+        if (options.format == BenchmarkOptions::Format::CSV) {
+            out_ << bench << ',' << name;
+            for (auto &field : fields)
+                out_ << ',' << field.value;
+            out_ << '\n';
+        } else {
+            begin_object(bench, name);
+            end_object(fields);
+        }
+    }
+
+    private:
+    void flush_caches()
+    {
+        for (std::size_t i = 0; i < flush_buffer_.size(); i += 64)
+            ++flush_buffer_[i];
+        asm volatile("" : : "r"(flush_buffer_.data()) : "memory"); // keep the writes
+    }
+
+    void begin_object(std::string_view bench, std::string_view name)
+    {
+        out_ << "{\"bench\":";
+        quote(bench);
+        out_ << ",\"name\":";
+        quote(name);
+    }
+
+    void end_object(const std::vector<Field> &fields)
+    {
+        for (auto &field : fields) {
+            out_ << ',';
+            quote(field.name);
+            out_ << ':';
+            quote(field.value);
+        }
+        out_ << "}\n";
+    }
+
+    void quote(std::string_view str)
+    {
+        out_ << '"';
+        for (char c : str) {
+            if (c == '"' or c == '\\')
+                out_ << '\\';
+            out_ << c;
+        }
+        out_ << '"';
+    }
+};
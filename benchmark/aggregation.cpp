@@ -0,0 +1,111 @@
+#include "HashAggregation.hpp"
+#include "Harness.hpp"
+#include "ThreadPool.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+
+
+#ifndef NDEBUG
+constexpr std::size_t NUM_COPIES = 10;
+#else
+constexpr std::size_t NUM_COPIES = 200;
+#endif
+
+
+/** Sums `size` per value of \p key over `NUM_COPIES` copies of the packages in the layout \p layout, natively on
+ * \p serial and on \p parallel and by a mutable query. */
+void run_benchmark(Harness &harness, ThreadPool &serial, ThreadPool &parallel, const char *layout, const char *key)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(true, devnull, std::cerr);
+
+    C.default_data_layout(layout);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    T.layout(C.data_layout());
+    for (std::size_t i = 0; i != NUM_COPIES; ++i)
+        m::load_from_CSV(diag, T, "resource/arch-packages.csv", std::numeric_limits<std::size_t>::max(), true, false);
+    if (diag.num_errors())
+        return;
+
+    const std::string prefix = std::string(layout) + '_' + key + '_';
+    auto report = [&](const char *name, const Samples &samples, std::size_t num_groups, int64_t total) {
+        harness.report("aggregation", prefix + name, samples, {
+            { "groups", num_groups },
+            Harness::Field::Hex("total", total),
+        });
+    };
+
+    HashAggregation aggregation;
+    for (auto [name, pool] : { std::pair{ "native", &serial }, std::pair{ "native_parallel", &parallel } }) {
+        if (pool == &parallel and parallel.num_threads() == 1)
+            break; // a single hardware thread, measured already
+        std::size_t num_groups = 0;
+        int64_t total = 0;
+        const auto samples = harness.measure([&]() {
+            const auto groups = aggregation(*pool, T, key, "size");
+            num_groups = groups.size();
+            total = 0;
+            for (auto &group : groups)
+                total += group.sum;
+        });
+        report(name, samples, num_groups, total);
+    }
+
+    std::ostringstream oss;
+    oss << "SELECT " << key << ", SUM(size) FROM packages GROUP BY " << key << ';';
+    auto stmt = m::statement_from_string(diag, oss.str());
+    auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
+    std::size_t num_groups = 0;
+    int64_t total = 0;
+    const auto samples = harness.measure([&]() {
+        num_groups = 0;
+        total = 0;
+        auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &t) {
+            ++num_groups;
+            total += t[1].as_i();
+        });
+        m::execute_query(diag, *query, std::move(callback));
+    });
+    report("mutable", samples, num_groups, total);
+}
+
+int main(int argc, char **argv)
+{
+    const auto options = BenchmarkOptions::ParseOrExit(argc, argv);
+    /* Create the pools before the harness pins this thread, lest their workers share its CPU. */
+    ThreadPool serial(1), parallel;
+    Harness harness(options);
+
+    auto &C = m::Catalog::Get();
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+
+    /* The packages have 3 repositories, 84 packagers and about 11'000 package names and ids. */
+    for (auto layout : { "row_naive", "row_optimized", "PAX4k" }) {
+        for (auto key : { "repo", "packager", "pkg_name", "id" })
+            run_benchmark(harness, serial, parallel, layout, key);
+    }
+}
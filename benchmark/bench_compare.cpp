@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+void usage(std::ostream &out, const char *name)
+{
+    out << "USAGE:\n"
+        << "    " << name << " store <RESULTS-DIR> <COMMIT> [<RESULTS.json>...]\n"
+        << "    " << name << " compare <RESULTS-DIR> <BASELINE-COMMIT> <COMMIT> [--threshold <PERCENT>] "
+           "[--alpha <P>]\n\n"
+        << "store appends the results of benchmarks run with `--format json`, read from the files or from stdin, to "
+           "RESULTS-DIR/COMMIT.json.\n"
+        << "compare tests every benchmark stored for both commits with a one-sided Mann-Whitney U test on their "
+           "samples.  A benchmark regressed if its median got slower by more than PERCENT (default 5) and the test "
+           "rejects that it did not get slower at level P (default 0.01).  Exits with failure if any benchmark "
+           "regressed." << std::endl;
+}
+
+/** The samples of a benchmark, as reported by `Harness` in JSON format. */
+struct Result
+{
+    std::string bench;
+    std::string name;
+    std::vector<double> samples; ///< in µs
+};
+
+/** Parses the JSON object in \p line written by `Harness`, i.e. one without nested objects whose members are strings,
+ * numbers, or arrays of numbers.  Returns nothing if \p line is no such object. */
+std::optional<Result> parse_result(std::string_view line)
+{
+    Result result;
+    std::size_t pos = 0;
+    auto skip_space = [&]() {
+        while (pos != line.size() and std::isspace(static_cast<unsigned char>(line[pos])))
+            ++pos;
+    };
+    auto expect = [&](char c) {
+        skip_space();
+        if (pos == line.size() or line[pos] != c)
+            return false;
+        ++pos;
+        return true;
+    };
+    auto parse_string = [&]() -> std::optional<std::string> {
+        if (not expect('"'))
+            return std::nullopt;
+        std::string str;
+        for (; pos != line.size() and line[pos] != '"'; ++pos) {
+            if (line[pos] == '\\' and ++pos == line.size())
+                return std::nullopt;
+            str += line[pos];
+        }
+        if (not expect('"'))
+            return std::nullopt;
+        return str;
+    };
+    auto parse_number = [&]() -> std::optional<double> {
+        skip_space();
+        const char *begin = line.data() + pos;
+        char *end;
+        const double value = std::strtod(begin, &end);
+        if (end == begin)
+            return std::nullopt;
+        pos += end - begin;
+        return value;
+    };
+
+    if (not expect('{'))
+        return std::nullopt;
+    do {
+        auto key = parse_string();
+        if (not key or not expect(':'))
+            return std::nullopt;
+        skip_space();
+        if (pos != line.size() and line[pos] == '"') {
+            auto value = parse_string();
+            if (not value)
+                return std::nullopt;
+            if (*key == "bench")
+                result.bench = *value;
+            else if (*key == "name")
+                result.name = *value;
+        } else if (expect('[')) {
+            std::vector<double> values;
+            if (not expect(']')) {
+                do {
+                    auto value = parse_number();
+                    if (not value)
+                        return std::nullopt;
+                    values.push_back(*value);
+                } while (expect(','));
+                if (not expect(']'))
+                    return std::nullopt;
+            }
+            if (*key == "samples")
+                result.samples = std::move(values);
+        } else if (not parse_number()) {
+            return std::nullopt;
+        }
+    } while (expect(','));
+    if (not expect('}') or result.bench.empty() or result.name.empty())
+        return std::nullopt;
+    return result;
+}
+
+/** Returns the samples per benchmark, i.e. per pair of bench and name, stored in \p path.  The samples of repeated
+ * runs of a benchmark are merged. */
+std::map<std::pair<std::string, std::string>, std::vector<double>> load(const std::filesystem::path &path)
+{
+    std::map<std::pair<std::string, std::string>, std::vector<double>> results;
+    std::ifstream in(path);
+    if (not in) {
+        std::cerr << "cannot read " << path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    for (std::string line; std::getline(in, line); ) {
+        if (auto result = parse_result(line); result and not result->samples.empty()) {
+            auto &samples = results[{ result->bench, result->name }];
+            samples.insert(samples.end(), result->samples.begin(), result->samples.end());
+        }
+    }
+    return results;
+}
+
+/** Returns the one-sided p-value of the Mann-Whitney U test that the values \p x are not stochastically greater than
+ * the values \p y, i.e. the probability of a U statistic at least as large as observed if both are drawn from the same
+ * distribution.  The exact distribution of U is used for up to 50 values per side, the normal approximation with
+ * correction for ties beyond. */
+double mann_whitney_greater(const std::vector<double> &x, const std::vector<double> &y)
+{
+    const std::size_t m = x.size(), n = y.size();
+
+    /* U counts the pairs in which the value of x is greater, ties counting half. */
+    double u = 0;
+    for (double a : x) {
+        for (double b : y)
+            u += a > b ? 1 : a == b ? .5 : 0;
+    }
+
+    if (m <= 50 and n <= 50) {
+        /* P(U = k) for i values of x and j of y follows from whether the largest of all values is one of x, which
+         * then exceeds all j values of y, or one of y.  Rows are computed for i = 0, 1, ..., m. */
+        const std::size_t max_u = m * n;
+        std::vector<std::vector<double>> previous(n + 1), current(n + 1);
+        for (std::size_t i = 0; i <= m; ++i) {
+            for (std::size_t j = 0; j <= n; ++j) {
+                auto &p = current[j];
+                p.assign(max_u + 1, 0);
+                if (i == 0 or j == 0) {
+                    p[0] = 1;
+                    continue;
+                }
+                const double p_x = double(i) / (i + j);
+                for (std::size_t k = 0; k <= i * j; ++k) {
+                    p[k] = (1 - p_x) * current[j - 1][k];
+                    if (k >= j)
+                        p[k] += p_x * previous[j][k - j];
+                }
+            }
+            std::swap(previous, current);
+        }
+        double p_value = 0;
+        for (std::size_t k = std::ceil(u); k <= max_u; ++k)
+            p_value += previous[n][k];
+        return std::min(1., p_value);
+    }
+
+    /* Normal approximation, with the variance corrected for ties. */
+    std::vector<double> all(x);
+    all.insert(all.end(), y.begin(), y.end());
+    std::sort(all.begin(), all.end());
+    double ties = 0;
+    for (std::size_t i = 0; i != all.size(); ) {
+        std::size_t j = i;
+        while (j != all.size() and all[j] == all[i])
+            ++j;
+        const double t = j - i;
+        ties += t * t * t - t;
+        i = j;
+    }
+    const double N = m + n;
+    const double mean = m * n / 2.;
+    const double variance = m * n / 12. * ((N + 1) - ties / (N * (N - 1)));
+    if (variance <= 0)
+        return 1;
+    const double z = (u - mean - .5) / std::sqrt(variance); // with continuity correction
+    return .5 * std::erfc(z / std::sqrt(2.));
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const std::size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+int store(const std::filesystem::path &dir, const std::string &commit, const std::vector<const char*> &files)
+{
+    std::filesystem::create_directories(dir);
+    const auto path = dir / (commit + ".json");
+    std::ofstream out(path, std::ios::app);
+    std::size_t num_results = 0;
+    auto copy = [&](std::istream &in) {
+        for (std::string line; std::getline(in, line); ) {
+            if (parse_result(line)) {
+                out << line << '\n';
+                ++num_results;
+            }
+        }
+    };
+    if (files.empty()) {
+        copy(std::cin);
+    } else {
+        for (auto file : files) {
+            std::ifstream in(file);
+            if (not in) {
+                std::cerr << "cannot read " << file << std::endl;
+                return EXIT_FAILURE;
+            }
+            copy(in);
+        }
+    }
+    if (not out) {
+        std::cerr << "cannot write " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cerr << "stored " << num_results << " results in " << path << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int compare(const std::filesystem::path &dir, const std::string &baseline_commit, const std::string &commit,
+            double threshold, double alpha)
+{
+    const auto baseline = load(dir / (baseline_commit + ".json"));
+    const auto current = load(dir / (commit + ".json"));
+
+    std::size_t num_regressions = 0, num_improvements = 0;
+    std::cout << std::left << std::setw(48) << "benchmark" << std::right
+              << std::setw(15) << "baseline µs" << std::setw(15) << "current µs"
+              << std::setw(10) << "change" << std::setw(10) << "p" << "  verdict\n";
+    for (auto &[key, samples] : current) {
+        auto it = baseline.find(key);
+        if (it == baseline.end())
+            continue;
+        const double before = median(it->second), after = median(samples);
+        const double change = before > 0 ? (after - before) / before : 0;
+        const double p_slower = mann_whitney_greater(samples, it->second);
+        const double p_faster = mann_whitney_greater(it->second, samples);
+
+        const char *verdict = "";
+        if (change > threshold and p_slower < alpha) {
+            verdict = "REGRESSED";
+            ++num_regressions;
+        } else if (change < -threshold and p_faster < alpha) {
+            verdict = "improved";
+            ++num_improvements;
+        }
+        std::cout << std::left << std::setw(48) << (key.first + ',' + key.second) << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(14) << before << std::setw(14) << after
+                  << std::showpos << std::setw(9) << 100 * change << '%' << std::noshowpos
+                  << std::setprecision(4) << std::setw(10) << std::min(p_slower, p_faster) << "  " << verdict
+                  << std::defaultfloat << '\n';
+    }
+    for (auto &[key, _] : baseline) {
+        if (not current.contains(key))
+            std::cout << key.first << ',' << key.second << ": missing in " << commit << '\n';
+    }
+    for (auto &[key, _] : current) {
+        if (not baseline.contains(key))
+            std::cout << key.first << ',' << key.second << ": missing in " << baseline_commit << '\n';
+    }
+
+    std::cout << '\n' << commit << " vs. " << baseline_commit << ": " << num_regressions << " regressed and "
+              << num_improvements << " improved by more than " << 100 * threshold << "% at p < " << alpha << '\n';
+    return num_regressions ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int main(int argc, const char **argv)
+{
+    if (argc >= 4 and std::strcmp(argv[1], "store") == 0)
+        return store(argv[2], argv[3], std::vector<const char*>(argv + 4, argv + argc));
+
+    if (argc >= 5 and argc % 2 == 1 and std::strcmp(argv[1], "compare") == 0) {
+        double threshold = .05, alpha = .01;
+        for (int i = 5; i != argc; i += 2) {
+            if (std::strcmp(argv[i], "--threshold") == 0) {
+                threshold = std::strtod(argv[i + 1], nullptr) / 100;
+            } else if (std::strcmp(argv[i], "--alpha") == 0) {
+                alpha = std::strtod(argv[i + 1], nullptr);
+            } else {
+                usage(std::cerr, argv[0]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        return compare(argv[2], argv[3], argv[4], threshold, alpha);
+    }
+
+    usage(std::cerr, argv[0]);
+    exit(EXIT_FAILURE);
+}
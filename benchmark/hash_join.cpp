@@ -0,0 +1,68 @@
+#include "Harness.hpp"
+#include "RadixJoin.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+#ifndef NDEBUG
+constexpr std::size_t MAX_NUM_ROWS = 1e6;
+#else
+constexpr std::size_t MAX_NUM_ROWS = 1e8;
+#endif
+
+
+/** Joins `T.id`, a permutation of the row ids of `T`, with a foreign key column of as many rows referencing it, by a
+ * plain hash join and by a radix join on \p serial and on \p parallel. */
+void run_benchmark(Harness &harness, ThreadPool &serial, ThreadPool &parallel, std::size_t num_rows)
+{
+    std::vector<int32_t> ids(num_rows), fids(num_rows);
+    std::iota(ids.begin(), ids.end(), 0);
+    std::mt19937_64 g(42);
+    std::shuffle(ids.begin(), ids.end(), g);
+    std::uniform_int_distribution<int32_t> dist(0, num_rows - 1);
+    for (auto &fid : fids)
+        fid = dist(g);
+
+    const std::string suffix = '_' + std::to_string(num_rows);
+    std::size_t num_matches = 0;
+    {
+        const auto samples = harness.measure([&]() {
+            num_matches = hash_join(ids.data(), ids.size(), fids.data(), fids.size()).size();
+        });
+        harness.report("hash_join", "plain" + suffix, samples, { { "matches", num_matches }, { "passes", 0 } });
+    }
+
+    /* Partition regardless of whether the hash table fits into the LLC, to also show the overhead of partitioning. */
+    RadixJoinConfig config = RadixJoinConfig::Detect();
+    config.llc_bytes = 0;
+    const std::size_t num_passes = config.passes(num_rows).size();
+
+    for (auto [name, pool] : { std::pair{ "radix", &serial }, std::pair{ "radix_parallel", &parallel } }) {
+        if (pool == &parallel and parallel.num_threads() == 1)
+            break; // a single hardware thread, measured already
+        const auto samples = harness.measure([&]() {
+            num_matches = radix_join(*pool, config, ids.data(), ids.size(), fids.data(), fids.size()).size();
+        });
+        harness.report("hash_join", name + suffix, samples, {
+            { "matches", num_matches },
+            { "passes", num_passes },
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto options = BenchmarkOptions::ParseOrExit(argc, argv);
+    /* Create the pools before the harness pins this thread, lest their workers share its CPU. */
+    ThreadPool serial(1), parallel;
+    Harness harness(options);
+
+    for (std::size_t num_rows = 1e5; num_rows <= MAX_NUM_ROWS; num_rows *= 10)
+        run_benchmark(harness, serial, parallel, num_rows);
+}
@@ -0,0 +1,129 @@
+#include "Harness.hpp"
+#include "LayoutColumn.hpp"
+#include "ResultWriter.hpp"
+#include "SecondaryIndex.hpp"
+#include "ThreadPool.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+
+#ifndef NDEBUG
+constexpr std::size_t NUM_COPIES = 10;
+#else
+constexpr std::size_t NUM_COPIES = 200;
+#endif
+
+
+/** Answers `SELECT id, pkg_name, size FROM packages WHERE size > <threshold>` over `NUM_COPIES` copies of the packages
+ * in the layout \p layout, for thresholds selecting each fraction of \p selectivities, by a range scan of an index on
+ * `size` and by a full scan in mutable.  The index is built on \p pool and the results are written to `/dev/null`. */
+void run_benchmark(Harness &harness, ThreadPool &pool, const char *layout, const std::vector<double> &selectivities,
+                   int devnull_fd)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(true, devnull, std::cerr);
+    C.default_data_layout(layout);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    T.layout(C.data_layout());
+    for (std::size_t i = 0; i != NUM_COPIES; ++i)
+        m::load_from_CSV(diag, T, "resource/arch-packages.csv", std::numeric_limits<std::size_t>::max(), true, false);
+    if (diag.num_errors())
+        return;
+
+    /*----- Build the index, once, since it is in sync afterwards. -----*/
+    IndexRegistry indexes;
+    indexes.add(T, C.pool("size"));
+    const auto build_samples = harness.measure([&]() { indexes.sync(pool); }, 0, 1);
+    harness.report("index_scan", std::string(layout) + "_build", build_samples, { { "rows", T.store().num_rows() } });
+
+    /* Find the thresholds from the sizes, sorted in descending order. */
+    const LayoutColumn size = LayoutColumn::Of(T, "size");
+    std::vector<int64_t> sizes(T.store().num_rows());
+    for (std::size_t row = 0; row != sizes.size(); ++row)
+        sizes[row] = load_integer(size.at(row), size.size);
+    std::sort(sizes.begin(), sizes.end(), std::greater<>());
+
+    ResultWriter out(devnull_fd);
+    for (auto selectivity : selectivities) {
+        const std::size_t rank = std::min(sizes.size() - 1, std::size_t(selectivity * sizes.size()));
+        std::ostringstream oss;
+        oss << "SELECT id, pkg_name, size FROM packages WHERE size > " << sizes[rank] << ';';
+        auto stmt = m::statement_from_string(diag, oss.str());
+        auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
+
+        std::ostringstream prefix;
+        prefix << layout << '_' << selectivity * 100 << "%_";
+        auto report = [&](const char *variant, const Samples &samples, std::size_t num_results) {
+            harness.report("index_scan", prefix.str() + variant, samples, { { "results", num_results } });
+        };
+
+        {
+            std::size_t num_results = 0;
+            const auto samples = harness.measure([&]() {
+                auto scan = indexes.route(*query);
+                num_results = scan ? (*scan)(out) : 0;
+                out.flush();
+            });
+            report("index", samples, num_results);
+        }
+
+        {
+            std::size_t num_results = 0;
+            const auto samples = harness.measure([&]() {
+                num_results = 0;
+                auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &t) {
+                    ++num_results;
+                    out.tuple(S, t);
+                });
+                m::execute_query(diag, *query, std::move(callback));
+                out.flush();
+            });
+            report("scan", samples, num_results);
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto options = BenchmarkOptions::ParseOrExit(argc, argv);
+    /* Create the pool before the harness pins this thread, lest its workers share its CPU. */
+    ThreadPool pool;
+    Harness harness(options);
+
+    auto &C = m::Catalog::Get();
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+
+    const int devnull_fd = open("/dev/null", O_WRONLY);
+    const std::vector<double> selectivities{ .0001, .001, .01, .1 };
+    for (auto layout : { "row_naive", "row_optimized", "PAX4k" })
+        run_benchmark(harness, pool, layout, selectivities, devnull_fd);
+    close(devnull_fd);
+}
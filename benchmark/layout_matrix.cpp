@@ -0,0 +1,119 @@
+#include "Harness.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+#ifndef NDEBUG
+const std::vector<int32_t> NUM_ROWS{ 10'000, 100'000 };
+#else
+const std::vector<int32_t> NUM_ROWS{ 10'000, 1'000'000 };
+#endif
+const std::vector<std::size_t> NUM_ATTRS{ 4, 8, 16, 32, 64 };
+const std::vector<double> SELECTIVITIES{ .0001, .001, .01, .1, .5, 1 };
+
+
+/** Measures `SELECT a0, ..., a<p-1> FROM t WHERE a<n-1> < <threshold>` over tables of `INT(4)` attributes in the
+ * layout \p layout, for every table width n of `NUM_ATTRS`, row count of `NUM_ROWS`, number p of projected attributes
+ * from 1 to n in powers of two, and fraction of `SELECTIVITIES` of the rows selected by the threshold.  The predicate
+ * is on the last attribute, which is projected only for p = n.
+ *
+ * Every query is reported with the fields `layout,attributes,rows,projected,selectivity,results,checksum`, i.e. one
+ * CSV line per cell of the matrix. */
+void run_benchmark(Harness &harness, const char *layout)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(true, devnull, std::cerr);
+    C.default_data_layout(layout);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+
+    for (auto num_attrs : NUM_ATTRS) {
+        for (auto num_rows : NUM_ROWS) {
+            std::ostringstream table_name;
+            table_name << 't' << num_attrs << '_' << num_rows;
+            auto &T = DB.add_table(C.pool(table_name.str().c_str()));
+            for (std::size_t j = 0; j != num_attrs; ++j)
+                T.push_back(C.pool(("a" + std::to_string(j)).c_str()), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+            T.store(C.create_store(T));
+            T.layout(C.data_layout());
+
+            /* Attribute j of row i is i + j, except for the last one, a permutation of the row ids to filter on. */
+            {
+                m::StoreWriter W(T.store());
+                m::Tuple tup(W.schema());
+                for (int32_t i = 0; i != num_rows; ++i) {
+                    for (std::size_t j = 0; j != num_attrs - 1; ++j)
+                        tup.set(j, int32_t(i + j));
+                    tup.set(num_attrs - 1, int32_t(int64_t(i) * 7919 % num_rows)); // 7919 is prime
+                    W.append(tup);
+                }
+            }
+
+            for (std::size_t num_projected = 1; num_projected <= num_attrs; num_projected *= 2) {
+                for (auto selectivity : SELECTIVITIES) {
+                    std::ostringstream sql;
+                    sql << "SELECT ";
+                    for (std::size_t j = 0; j != num_projected; ++j)
+                        sql << (j ? ", a" : "a") << j;
+                    sql << " FROM " << table_name.str() << " WHERE a" << num_attrs - 1 << " < "
+                        << int64_t(selectivity * num_rows) << ';';
+                    auto stmt = m::statement_from_string(diag, sql.str());
+                    auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
+
+                    std::size_t num_results = 0;
+                    uint64_t checksum = 0;
+                    const auto samples = harness.measure([&]() {
+                        num_results = 0;
+                        checksum = 0;
+                        auto op = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &t) {
+                            ++num_results;
+                            for (std::size_t j = 0; j != num_projected; ++j)
+                                checksum += t.get(j).as_i();
+                        });
+                        m::execute_query(diag, *query, std::move(op));
+                    });
+
+                    std::ostringstream name;
+                    name << layout << "_a" << num_attrs << "_r" << num_rows << "_p" << num_projected << "_s"
+                         << selectivity * 100 << '%';
+                    harness.report("layout_matrix", name.str(), samples, {
+                        { "layout", layout },
+                        { "attributes", num_attrs },
+                        { "rows", num_rows },
+                        { "projected", num_projected },
+                        { "selectivity", selectivity },
+                        { "results", num_results },
+                        Harness::Field::Hex("checksum", checksum),
+                    });
+                }
+            }
+
+            /* Free the table's memory before filling the next one. */
+            T.store(C.create_store(T));
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Harness harness(BenchmarkOptions::ParseOrExit(argc, argv));
+
+    auto &C = m::Catalog::Get();
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+
+    for (auto layout : { "row_naive", "row_optimized", "PAX4k" })
+        run_benchmark(harness, layout);
+    m::Catalog::Destroy();
+}
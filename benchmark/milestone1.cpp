@@ -1,21 +1,139 @@
+#include "Harness.hpp"
+#include "LayoutColumn.hpp"
 #include "data_layouts.hpp"
 #include <cassert>
-#include <chrono>
-#include <iomanip>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <mutable/util/macro.hpp>
-#include <sstream>
+#include <random>
+#include <string>
+#include <vector>
 
 
 #ifndef NDEBUG
 constexpr int32_t NUM_TUPLES_RW = 5e5;
+constexpr std::size_t NUM_POINT_UPDATES = 1e5;
 #else
 constexpr int32_t NUM_TUPLES_RW = 5e6;
+constexpr std::size_t NUM_POINT_UPDATES = 1e6;
 #endif
 
 
+/** Adds the attributes of the wide table with mixed types, chosen to evaluate padding and alignment, to \p table. */
+void add_wide_attributes(m::Table &table)
+{
+    auto &C = m::Catalog::Get();
+    table.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    table.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("c_c3"), m::Type::Get_Char(m::Type::TY_Vector, 3));
+    table.push_back(C.pool("d_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("e_d"),  m::Type::Get_Double(m::Type::TY_Vector));
+    table.push_back(C.pool("f_i1"), m::Type::Get_Integer(m::Type::TY_Vector, 1));
+    table.push_back(C.pool("g_f"),  m::Type::Get_Float(m::Type::TY_Vector));
+    table.push_back(C.pool("h_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
+    table.push_back(C.pool("i_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("j_i2"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
+    table.push_back(C.pool("k_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
+    table.push_back(C.pool("l_i2"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
+}
+
+/** Sets the values of the tuple \p i of the wide table in \p tup. */
+void fill_wide(m::Tuple &tup, int32_t i)
+{
+    static char c3[] = "abc";
+    static char c5[] = "abcde";
+    tup.set(0,  i);
+    tup.set(1,  bool(i & 1));
+    tup.set(2,  m::Value(static_cast<void*>(c3)));
+    tup.set(3,  bool(i & 2));
+    tup.set(4,  i * .5);
+    tup.set(5,  int64_t(int8_t(i)));
+    tup.set(6,  i * .25f);
+    tup.set(7,  m::Value(static_cast<void*>(c5)));
+    tup.set(8,  bool(i & 4));
+    tup.set(9,  int64_t(int16_t(i)));
+    tup.set(10, bool(i & 8));
+    tup.set(11, int64_t(int16_t(i << 1)));
+}
+
+/** Sets the values `(i, 2*i, 2*i, 2*i)` of the tuple \p i of a narrow table, of four `INT(4)` attributes, in
+ * \p tup. */
+void fill_narrow(m::Tuple &tup, int32_t i)
+{
+    tup.set(0, i);
+    tup.set(1, i<<1);
+    tup.set(2, i<<1);
+    tup.set(3, i<<1);
+}
+
+/** Measures appending `NUM_TUPLES_RW` tuples, set by \p fill, to an empty store of \p table, and then updating the
+ * integral attributes of `NUM_POINT_UPDATES` random tuples in place.  mutable cannot execute `UPDATE` statements, so
+ * updates write the values directly to the locations in the store that the table's layout defines. */
+template<typename Fill>
+void benchmark_writes(Harness &harness, m::Table &table, const std::string &name, Fill fill)
+{
+    auto &C = m::Catalog::Get();
+    table.layout(C.data_layout().make(table.schema()));
+    const auto &layout = table.layout();
+    const double bytes_per_tuple = layout.stride_in_bits() / 8. / layout.child().num_tuples();
+
+    /* Append to a fresh store in every run, the tuples included, as when loading data. */
+    const auto append_samples = harness.measure([&]() {
+        table.store(C.create_store(table));
+        m::StoreWriter W(table.store());
+        m::Tuple tup(W.schema());
+        for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
+            fill(tup, i);
+            W.append(tup);
+        }
+    });
+    const double append_s = append_samples.median() / 1e6;
+    harness.report("milestone1", "append_" + name, append_samples, {
+        { "tuples_per_s", std::round(NUM_TUPLES_RW / append_s) },
+        { "bytes_per_s", std::round(NUM_TUPLES_RW * bytes_per_tuple / append_s) },
+    });
+
+    /* Update the integral attributes of random tuples of the last store appended to. */
+    std::vector<LayoutColumn> columns;
+    std::size_t bytes_per_update = 0;
+    for (auto &attr : table) {
+        if (attr.type->is_integral()) {
+            columns.push_back(LayoutColumn::Of(table, attr));
+            bytes_per_update += columns.back().size;
+        }
+    }
+    std::mt19937_64 g(42);
+    std::uniform_int_distribution<std::size_t> dist(0, table.store().num_rows() - 1);
+    std::vector<std::size_t> rows(NUM_POINT_UPDATES);
+    for (auto &row : rows)
+        row = dist(g);
+
+    uint64_t checksum = 0;
+    const auto update_samples = harness.measure([&]() {
+        int64_t value = 0;
+        for (auto row : rows) {
+            ++value;
+            for (auto &column : columns)
+                std::memcpy(const_cast<uint8_t*>(column.at(row)), &value, column.size); // little endian
+        }
+    });
+    for (auto row : rows) {
+        for (auto &column : columns)
+            checksum = (checksum << 3UL) ^ load_integer(column.at(row), column.size);
+    }
+    const double update_s = update_samples.median() / 1e6;
+    harness.report("milestone1", "update_" + name, update_samples, {
+        { "ns_per_update", std::round(update_s * 1e9 / NUM_POINT_UPDATES) },
+        { "bytes_per_s", std::round(NUM_POINT_UPDATES * bytes_per_update / update_s) },
+        Harness::Field::Hex("checksum", checksum),
+    });
+}
+
+
 template<typename Layout>
-void benchmark_store(const char *name)
+void benchmark_store(Harness &harness, const char *name)
 {
     /* Clear the catalog before starting a new benchmark. */
     m::Catalog::Clear();
@@ -41,25 +159,15 @@ void benchmark_store(const char *name)
     {
         /* Create a wide table to evaluate padding and alignment. */
         auto &tbl_wide = DB.add_table(C.pool("wide"));
-        tbl_wide.push_back(C.pool("a_i4"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
-        tbl_wide.push_back(C.pool("b_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("c_c3"), m::Type::Get_Char(m::Type::TY_Vector, 3));
-        tbl_wide.push_back(C.pool("d_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("e_d"),  m::Type::Get_Double(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("f_i1"), m::Type::Get_Integer(m::Type::TY_Vector, 1));
-        tbl_wide.push_back(C.pool("g_f"),  m::Type::Get_Float(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("h_c5"), m::Type::Get_Char(m::Type::TY_Vector, 5));
-        tbl_wide.push_back(C.pool("i_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("j_i2"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
-        tbl_wide.push_back(C.pool("k_b"),  m::Type::Get_Boolean(m::Type::TY_Vector));
-        tbl_wide.push_back(C.pool("l_i2"), m::Type::Get_Integer(m::Type::TY_Vector, 2));
+        add_wide_attributes(tbl_wide);
         tbl_wide.store(C.create_store(tbl_wide));
 
         tbl_wide.store(C.create_store(tbl_wide));
         tbl_wide.layout(C.data_layout().make(tbl_wide.schema()));
         auto &layout = tbl_wide.layout();
 
-        std::cout << "milestone1,size," << name << ',' << (layout.stride_in_bits() / layout.child().num_tuples()) << '\n';
+        harness.report("milestone1", std::string("size_") + name,
+                       { { "bits_per_tuple", layout.stride_in_bits() / layout.child().num_tuples() } });
     }
 
     /* Evaluate read/write performance - full table scan. */
@@ -79,11 +187,7 @@ void benchmark_store(const char *name)
         m::Tuple tup(table.schema());
 
         for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
-            /* Set tuple data (i, 2*i). */
-            tup.set(0, i);
-            tup.set(1, i<<1);
-            tup.set(2, i<<1);
-            tup.set(3, i<<1);
+            fill_narrow(tup, i);
             W.append(tup);
         }
 
@@ -91,22 +195,19 @@ void benchmark_store(const char *name)
         auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
 
         uint64_t checksum = 0;
-        auto op = std::make_unique<m::CallbackOperator>([&checksum](const m::Schema&, const m::Tuple &T) {
-                checksum += T.get(0).as_i() * 3;
-                checksum += T.get(1).as_i() * 5;
-                checksum += T.get(2).as_i() * 7;
-                checksum += T.get(3).as_i() * 11;
+        const auto samples = harness.measure([&]() {
+            checksum = 0;
+            auto op = std::make_unique<m::CallbackOperator>([&checksum](const m::Schema&, const m::Tuple &T) {
+                    checksum += T.get(0).as_i() * 3;
+                    checksum += T.get(1).as_i() * 5;
+                    checksum += T.get(2).as_i() * 7;
+                    checksum += T.get(3).as_i() * 11;
+            });
+            m::execute_query(diag, *query, std::move(op));
         });
 
-        using namespace std::chrono;
-        auto t_read_begin = steady_clock::now();
-        m::execute_query(diag, *query, std::move(op));
-        auto t_read_end = steady_clock::now();
-
-        std::cout << "milestone1,full_scan," << name << ','
-                  << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << ','
-                  << std::hex << checksum << std::dec
-                  << '\n';
+        harness.report("milestone1", std::string("full_scan_") + name, samples,
+                       { Harness::Field::Hex("checksum", checksum) });
     }
 
     /* Evaluate read/write performance - partial table scan. */
@@ -126,11 +227,7 @@ void benchmark_store(const char *name)
         m::Tuple tup(W.schema());
 
         for (int32_t i = 0; i != NUM_TUPLES_RW; ++i) {
-            /* Set tuple data (i, 2*i). */
-            tup.set(0, i);
-            tup.set(1, i<<1);
-            tup.set(2, i<<1);
-            tup.set(3, i<<1);
+            fill_narrow(tup, i);
             W.append(tup);
         }
 
@@ -138,27 +235,39 @@ void benchmark_store(const char *name)
         auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
 
         uint64_t checksum = 0;
-        auto op = std::make_unique<m::CallbackOperator>([&checksum](const m::Schema&, const m::Tuple &T) {
-                checksum += T.get(0).as_i() * 3;
-                checksum += T.get(1).as_i() * 5;
+        const auto samples = harness.measure([&]() {
+            checksum = 0;
+            auto op = std::make_unique<m::CallbackOperator>([&checksum](const m::Schema&, const m::Tuple &T) {
+                    checksum += T.get(0).as_i() * 3;
+                    checksum += T.get(1).as_i() * 5;
+            });
+            m::execute_query(diag, *query, std::move(op));
         });
 
-        using namespace std::chrono;
-        auto t_read_begin = steady_clock::now();
-        m::execute_query(diag, *query, std::move(op));
-        auto t_read_end = steady_clock::now();
+        harness.report("milestone1", std::string("partial_scan_") + name, samples,
+                       { Harness::Field::Hex("checksum", checksum) });
+    }
+
+    /* Evaluate write performance - appends and point updates, of a narrow and of the wide table. */
+    {
+        auto &narrow = DB.add_table(C.pool("append_narrow"));
+        narrow.push_back(C.pool("key"),    m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        narrow.push_back(C.pool("value0"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        narrow.push_back(C.pool("value1"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        narrow.push_back(C.pool("value2"), m::Type::Get_Integer(m::Type::TY_Vector, 4));
+        benchmark_writes(harness, narrow, std::string("narrow_") + name, fill_narrow);
 
-        std::cout << "milestone1,partial_scan," << name << ','
-                  << duration_cast<milliseconds>(t_read_end - t_read_begin).count() << ','
-                  << std::hex << checksum << std::dec
-                  << '\n';
+        auto &wide = DB.add_table(C.pool("append_wide"));
+        add_wide_attributes(wide);
+        benchmark_writes(harness, wide, std::string("wide_") + name, fill_wide);
     }
 }
 
-int main()
+int main(int argc, char **argv)
 {
-    benchmark_store<MyNaiveRowLayoutFactory>("row_naive");
-    benchmark_store<MyOptimizedRowLayoutFactory>("row_optimized");
-    benchmark_store<MyPAX4kLayoutFactory>("pax");
+    Harness harness(BenchmarkOptions::ParseOrExit(argc, argv));
+    benchmark_store<MyNaiveRowLayoutFactory>(harness, "row_naive");
+    benchmark_store<MyOptimizedRowLayoutFactory>(harness, "row_optimized");
+    benchmark_store<MyPAX4kLayoutFactory>(harness, "pax");
     m::Catalog::Destroy();
 }
@@ -1,11 +1,12 @@
 #include "BTree.hpp"
+#include "Harness.hpp"
 #include <algorithm>
-#include <chrono>
+#include <cmath>
 #include <cstdint>
-#include <iomanip>
-#include <iostream>
+#include <optional>
 #include <random>
 #include <sstream>
+#include <string>
 #include <vector>
 
 
@@ -105,6 +106,7 @@ std::vector<Key> draw_lookup_keys(const std::vector<Key> &keys, const std::vecto
 
 template<typename Key, typename Value, std::size_t NODE_SIZE, typename Generator>
 void benchmark(
+    Harness &harness,
     const char *name,
     const std::vector<Key> &keys,
     const std::vector<std::pair<Key, Value>> &data,
@@ -112,42 +114,39 @@ void benchmark(
     Generator g
 ) {
     using tree_type = BTree<Key, Value, NODE_SIZE>;
-    using namespace std::chrono;
 
-    /*----- Bulkload data. -----*/
-    const auto t_bulkload_begin = steady_clock::now();
-    const auto tree = tree_type::Bulkload(data.cbegin(), data.cend());
-    const auto t_bulkload_end = steady_clock::now();
-
-    std::cout << "milestone2,bulkload_" << name << ','
-              << duration_cast<milliseconds>(t_bulkload_end - t_bulkload_begin).count()
-              << '\n';
+    /*----- Bulkload data.  Once only, as the trees are never freed. -----*/
+    std::optional<tree_type> bulkloaded;
+    const auto bulkload_samples = harness.measure([&]() {
+        bulkloaded.emplace(tree_type::Bulkload(data.cbegin(), data.cend()));
+    }, 0, 1);
+    const auto &tree = *bulkloaded;
+    harness.report("milestone2", std::string("bulkload_") + name, bulkload_samples);
 
     /*----- Benchmark `find()`. -----*/
     uint64_t checksum;
     for (const float hit_ratio : {.05f, .95f,}) {
         const auto lookup_keys = draw_lookup_keys(keys, misses, hit_ratio, num_point_lookups, g);
-        checksum = 0;
-
-        const auto t_lookup_begin = steady_clock::now();
-        for (auto k : lookup_keys) {
-            const auto it = tree.find(k);
-            const uint64_t v = (it == tree.cend()) ? 1UL : (*it).second();
-            checksum = (checksum << 3UL) ^ v;
-
-        }
-        const auto t_lookup_end = steady_clock::now();
 
-        const auto ns = duration_cast<nanoseconds>(t_lookup_end - t_lookup_begin).count();
-        std::cout << "milestone2,find_" << name << '_' << unsigned(100 * hit_ratio) << ','
-                  << std::round(ns / double(num_point_lookups)) << ','
-                  << std::hex << checksum << std::dec
-                  << '\n';
+        const auto samples = harness.measure([&]() {
+            checksum = 0;
+            for (auto k : lookup_keys) {
+                const auto it = tree.find(k);
+                const uint64_t v = (it == tree.cend()) ? 1UL : (*it).second();
+                checksum = (checksum << 3UL) ^ v;
+            }
+        });
+
+        harness.report("milestone2", std::string("find_") + name + '_' + std::to_string(unsigned(100 * hit_ratio)),
+                       samples, {
+                           { "ns_per_lookup", std::round(samples.median() * 1e3 / num_point_lookups) },
+                           Harness::Field::Hex("checksum", checksum),
+                       });
     }
 }
 
 template<typename Key, typename Value, typename Generator>
-void benchmark_all_node_sizes(const char *name, Generator g)
+void benchmark_all_node_sizes(Harness &harness, const char *name, Generator g)
 {
     std::ostringstream oss;
 
@@ -167,7 +166,7 @@ void benchmark_all_node_sizes(const char *name, Generator g)
 #define BENCHMARK(NODE_SIZE) { \
     oss.str(""); \
     oss << name << '_' << NODE_SIZE; \
-    benchmark<Key, Value, NODE_SIZE>(oss.str().c_str(), keys, data, misses, g); \
+    benchmark<Key, Value, NODE_SIZE>(harness, oss.str().c_str(), keys, data, misses, g); \
 }
     BENCHMARK(64);
     BENCHMARK(512);
@@ -176,10 +175,11 @@ void benchmark_all_node_sizes(const char *name, Generator g)
 }
 
 
-int main()
+int main(int argc, char **argv)
 {
+    Harness harness(BenchmarkOptions::ParseOrExit(argc, argv));
 #define BENCHMARK(KEY, VALUE) \
-    benchmark_all_node_sizes<KEY, VALUE>(#KEY "__" #VALUE, std::mt19937(0))
+    benchmark_all_node_sizes<KEY, VALUE>(harness, #KEY "__" #VALUE, std::mt19937(0))
     BENCHMARK(int32_t, int32_t);
 #undef BENCHMARK
 }
@@ -1,15 +1,24 @@
+#include "Harness.hpp"
 #include "milestone3_utils.hpp"
 #include "MyPlanEnumerator.hpp"
+#include "PipelineExecutor.hpp"
+#include "PlanSerialization.hpp"
 #include "nullstream.hpp"
 #include <cmath>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <memory>
 #include <mutable/mutable.hpp>
 #include <mutable/Options.hpp>
+#include <numeric>
+#include <optional>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 #include <utility>
+#include <vector>
 
 
 using namespace m;
@@ -17,13 +26,57 @@ using namespace m;
 using PlanTable = m::PlanTableLargeAndSparse;
 
 
-void run_benchmark(const char *name,
+/** A configuration of `MyPlanEnumerator` to benchmark, reported with `suffix` appended to the query name. */
+struct Variant
+{
+    const char *suffix;
+    void (*configure)(MyPlanEnumerator&);
+};
+
+/** Generates a table per data source of \p G with 100 times the cardinality the plan table \p PT assumes for that
+ * data source.  Column `id` numbers the rows and every column `fid_<ALIAS>` holds uniformly distributed row ids of
+ * the data source `<ALIAS>`, such that the joins of the query are foreign key joins. */
+std::vector<ColumnarTable> generate_tables(const QueryGraph &G, const PlanTable &PT, const CardinalityEstimator &CE)
+{
+    std::vector<ColumnarTable> tables(G.num_sources());
+    auto num_rows_of = [&](const char *alias) -> std::size_t {
+        for (auto ds : G.sources()) {
+            if (ds->alias() and std::strcmp(ds->alias(), alias) == 0)
+                return tables[ds->id()].num_rows;
+        }
+        return 1;
+    };
+
+    for (auto ds : G.sources())
+        tables[ds->id()].num_rows = 100 * CE.predict_cardinality(*PT[SmallBitset(1UL << ds->id())].model);
+
+    std::mt19937_64 g(42);
+    for (auto ds : G.sources()) {
+        auto &table = as<const BaseTable>(*ds).table();
+        auto &columns = tables[ds->id()];
+        for (std::size_t i = 0; i != table.num_attrs(); ++i) {
+            std::vector<int64_t> column(columns.num_rows);
+            if (std::strncmp(table[i].name, "fid_", 4) == 0) {
+                std::uniform_int_distribution<int64_t> dist(0, num_rows_of(table[i].name + 4) - 1);
+                for (auto &value : column)
+                    value = dist(g);
+            } else {
+                std::iota(column.begin(), column.end(), 0);
+            }
+            columns.generate(i, std::move(column));
+        }
+    }
+    return tables;
+}
+
+void run_benchmark(Harness &harness,
+                   ThreadPool &pool,
+                   const char *name,
                    std::filesystem::path schema,
                    std::filesystem::path query,
-                   std::filesystem::path cardinalities)
+                   std::filesystem::path cardinalities,
+                   const Variant &variant)
 {
-    using namespace std::chrono;
-
     Catalog::Clear();
     Catalog &C = Catalog::Get();
     NullStream devnull;
@@ -51,34 +104,152 @@ void run_benchmark(const char *name,
 
     auto G = QueryGraph::Build(*stmt);
     MyPlanEnumerator PE;
+    variant.configure(PE);
     auto &CF = C.cost_function(); // get default cost function (C_out)
     Optimizer O(PE, CF);
 
-    /* Perform optimization. */
-    const auto t_begin = steady_clock::now();
-    auto [plan, PT] = O.optimize_with_plantable<PlanTable>(*G);
-    const auto t_end = steady_clock::now();
+    /* Perform optimization, keeping the plan table of the last run. */
+    std::optional<PlanTable> optimized;
+    const auto samples = harness.measure([&]() {
+        optimized.reset();
+        optimized.emplace(O.optimize_with_plantable<PlanTable>(*G).second);
+    });
+    auto &PT = *optimized;
 
     // PT.dump();
 
     const std::size_t cost = PT.get_final().cost;
-    const auto ns = duration_cast<nanoseconds>(t_end - t_begin).count();
-    std::cout << "milestone3," << name << ','
-              << ns / 1e3 << ',' // µs
-              << std::hex << cost << std::dec
-              << '\n';
+    std::vector<Harness::Field> fields{ Harness::Field::Hex("cost", cost) };
+    if (PE.order_tracking != MyPlanEnumerator::OrderTracking::Off)
+        fields.emplace_back("physical_cost", PE.physical_cost);
+    if (PE.plan_table_budget) {
+        fields.emplace_back("peak_bytes", PE.bounded_result.peak_bytes);
+        fields.emplace_back("exact", PE.bounded_result.exact);
+    }
+    harness.report("milestone3", std::string(name) + variant.suffix, samples, fields);
+
+    /* Load the plan of the default configuration from its binary serialization instead of optimizing. */
+    if (*variant.suffix == '\0') {
+        std::stringstream serialized;
+        SerializedPlan::from_plan_table(PT, C.get_database_in_use().cardinality_estimator(), 0).write(serialized);
+        const std::size_t num_bytes = serialized.str().size();
+
+        std::size_t stored_cost = 0;
+        const auto samples = harness.measure([&]() {
+            std::istringstream in(serialized.str());
+            auto stored = SerializedPlan::read(in);
+            M_insist(stored and not stored->check(*G), "the plan must be readable");
+            ReplayPlanEnumerator RE(*stored);
+            Optimizer O_stored(RE, CF);
+            auto [_, PT_stored] = O_stored.optimize_with_plantable<PlanTable>(*G);
+            stored_cost = PT_stored.get_final().cost;
+        });
+
+        harness.report("milestone3", std::string(name) + "_import", samples, {
+            Harness::Field::Hex("cost", stored_cost),
+            { "bytes", num_bytes },
+        });
+    }
+
+    /* Execute the plan of the default configuration on generated tables, materializing every join, in pipelines and
+     * adaptively. */
+    if (*variant.suffix == '\0') {
+        auto &CE = C.get_database_in_use().cardinality_estimator();
+        const auto tables = generate_tables(*G, PT, CE);
+        std::vector<const ColumnarTable*> inputs;
+        for (auto &table : tables)
+            inputs.push_back(&table);
+
+        /* A query the executors do not support fails the benchmark instead of reporting wrong results. */
+        const PlanExecutor executor = [&]() {
+            try {
+                return PlanExecutor(*G, inputs);
+            } catch (std::invalid_argument &e) {
+                std::cerr << name << ": cannot execute the plan: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }();
+        std::size_t num_tuples = 0;
+        const auto exec_samples = harness.measure([&]() { num_tuples = executor(PT).num_tuples; });
+        harness.report("milestone3", std::string(name) + "_execute", exec_samples, {
+            Harness::Field::Hex("cost", cost),
+            { "tuples", num_tuples },
+        });
+
+        PipelineExecutor pipelined(*G, inputs);
+        const auto pipe_samples = harness.measure([&]() { num_tuples = pipelined(pool, PT, CE).num_tuples; });
+        harness.report("milestone3", std::string(name) + "_pipelined", pipe_samples, {
+            Harness::Field::Hex("cost", cost),
+            { "tuples", num_tuples },
+        });
+
+        /* Optimize and execute again, re-optimizing whenever an intermediate result is off from its estimate,
+         * which the estimates for the generated tables are.  Every run starts without feedback. */
+        std::size_t adaptive_cost = 0, num_replans = 0;
+        const auto adaptive_samples = harness.measure([&]() {
+            FeedbackCardinalityEstimator feedback(CE);
+            MyPlanEnumerator adaptive_PE;
+            variant.configure(adaptive_PE);
+            adaptive_PE.cardinality_estimator = &feedback;
+            PipelineExecutor adaptive(*G, inputs);
+            auto PT_adaptive = get_plan_table<PlanTable>(*G, feedback);
+            adaptive_PE(enumerate_tag{}, PT_adaptive, *G, CF);
+            num_tuples = adaptive(pool, PT_adaptive, feedback, adaptive_PE, CF).num_tuples;
+            adaptive_cost = PT_adaptive.get_final().cost;
+            num_replans = adaptive.num_replans;
+        });
+        harness.report("milestone3", std::string(name) + "_adaptive", adaptive_samples, {
+            Harness::Field::Hex("cost", adaptive_cost),
+            { "tuples", num_tuples },
+            { "replans", num_replans },
+        });
+    }
+
+    /* Incrementally re-optimize the default configuration as if the cardinality of the first join changed. */
+    if (*variant.suffix == '\0' and G->num_joins() != 0) {
+        SmallBitset changed;
+        for (auto ds : G->joins().front()->sources())
+            changed.at(ds->id()) = true;
+
+        const auto samples = harness.measure([&]() { PE.reoptimize(PT, *G, CF, { changed }); });
+        harness.report("milestone3", std::string(name) + "_reoptimize", samples, {
+            Harness::Field::Hex("cost", std::size_t(PT.get_final().cost)),
+        });
+    }
 }
 
-int main(int argc, char**)
+int main(int argc, char **argv)
 {
-    /* Check the number of parameters. */
-    if (argc != 1)
-        exit(EXIT_FAILURE);
+    const auto options = BenchmarkOptions::ParseOrExit(argc, argv);
+    /* Create the pool of the pipelined executions before the harness pins this thread, lest its workers share its
+     * CPU. */
+    ThreadPool pool;
+    Harness harness(options);
 
     std::filesystem::path schema("resource/schema.sql");
 
+    /* The default configuration is compared to the generic enumeration without the kernel for small queries and to
+     * enumeration after simplification of the join graph to a small budget and to enumeration in a plan table of at
+     * most 1 MiB, reporting its peak memory and whether the plan is exact.  The physical costs with the cheapest
+     * physical plan per subproblem and with interesting orders show how much interesting orders improve the final
+     * plan. */
+    const Variant variants[] = {
+        { "", [](MyPlanEnumerator&) { } },
+        { "_generic", [](MyPlanEnumerator &PE) { PE.specialize_small_queries = false; } },
+        { "_simplified", [](MyPlanEnumerator &PE) { PE.simplification_budget = 1000; } },
+        { "_bounded", [](MyPlanEnumerator &PE) { PE.plan_table_budget = 1UL << 20; } },
+        { "_physical", [](MyPlanEnumerator &PE) {
+            PE.order_tracking = MyPlanEnumerator::OrderTracking::CheapestOnly;
+        } },
+        { "_orders", [](MyPlanEnumerator &PE) {
+            PE.order_tracking = MyPlanEnumerator::OrderTracking::Pareto;
+        } },
+    };
+
 #define RUN(NAME) \
-    run_benchmark(NAME, schema, "resource/" NAME ".query.sql", "resource/" NAME ".cardinalities.json");
+    for (auto &variant : variants) \
+        run_benchmark(harness, pool, NAME, schema, "resource/" NAME ".query.sql", \
+                      "resource/" NAME ".cardinalities.json", variant);
     RUN("chain-12");
     RUN("cycle-12");
     RUN("star-10");
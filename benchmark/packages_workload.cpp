@@ -0,0 +1,176 @@
+#include "Harness.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+
+#ifndef NDEBUG
+const std::vector<std::size_t> SCALES{ 1, 10 };
+#else
+const std::vector<std::size_t> SCALES{ 1, 10, 100, 1000 };
+#endif
+
+/** The mix of queries of the workload, by name. */
+const std::vector<std::pair<const char*, const char*>> QUERIES{
+    /* resource/query.sql */
+    { "filter_large",   "SELECT id, pkg_name, size / 1024 / 1024, \"MiB\" FROM packages "
+                        "WHERE size > 1024 * 1024 * 1024;" },
+    { "filter_license", "SELECT id, pkg_name, pkg_ver FROM packages WHERE licenses = \"GPL\";" },
+    { "projection",     "SELECT pkg_name, pkg_ver, size FROM packages;" },
+    { "group_repo",     "SELECT repo, COUNT(*), SUM(size), MAX(size) FROM packages GROUP BY repo;" },
+    { "group_packager", "SELECT packager, COUNT(*) FROM packages GROUP BY packager;" },
+    { "range_size",     "SELECT id, pkg_name, size FROM packages WHERE size >= 100000 AND size < 200000;" },
+};
+
+
+/** Splits the CSV \p line into its fields, which keep their quotes. */
+std::vector<std::string_view> split_csv(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    for (std::size_t pos = 0; ; ++pos) {
+        const std::size_t begin = pos;
+        bool is_quoted = false;
+        for (; pos != line.size() and (is_quoted or line[pos] != ','); ++pos) {
+            if (line[pos] == '"')
+                is_quoted = not is_quoted; // an escaped quote `""` toggles twice
+        }
+        fields.push_back(line.substr(begin, pos - begin));
+        if (pos == line.size())
+            return fields;
+    }
+}
+
+/** Writes the packages of \p in replicated \p scale times to \p out.  The first copy is the original data.  Every
+ * further row is a copy of a random original row, which preserves the distributions of and correlations between repos,
+ * licenses and packagers, with a fresh id and its size scaled by a log-normal factor. */
+void replicate_packages(std::istream &in, std::ostream &out, std::size_t scale)
+{
+    constexpr std::size_t ID = 0, SIZE = 6;
+
+    std::string header;
+    std::getline(in, header);
+    out << header << '\n';
+    std::vector<std::string> rows;
+    for (std::string line; std::getline(in, line); )
+        rows.push_back(std::move(line));
+
+    std::mt19937_64 g(42);
+    std::uniform_int_distribution<std::size_t> pick(0, rows.size() - 1);
+    std::lognormal_distribution<double> size_factor(0, .5);
+    std::size_t id = 0;
+    for (std::size_t copy = 0; copy != scale; ++copy) {
+        for (std::size_t i = 0; i != rows.size(); ++i, ++id) {
+            auto fields = split_csv(copy ? rows[pick(g)] : rows[i]);
+            const int64_t size = std::stoll(std::string(fields[SIZE]));
+            for (std::size_t f = 0; f != fields.size(); ++f) {
+                if (f)
+                    out << ',';
+                if (f == ID)
+                    out << id;
+                else if (f == SIZE)
+                    out << (copy ? int64_t(std::round(size * size_factor(g))) : size);
+                else
+                    out << fields[f];
+            }
+            out << '\n';
+        }
+    }
+}
+
+/** Loads the packages from \p path into the layout \p layout and measures every query of `QUERIES`.  Every query is
+ * reported with its latency, the number of packages scanned per second, and the number of results. */
+void run_benchmark(Harness &harness, const char *layout, const std::filesystem::path &path, std::size_t scale)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(true, devnull, std::cerr);
+    C.default_data_layout(layout);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    T.layout(C.data_layout());
+
+    const auto load_samples = harness.measure([&]() {
+        m::load_from_CSV(diag, T, path, std::numeric_limits<std::size_t>::max(), true, false);
+    }, 0, 1);
+    if (diag.num_errors())
+        return;
+    const std::size_t num_rows = T.store().num_rows();
+    const std::string suffix = std::string("_") + layout + "_x" + std::to_string(scale);
+    harness.report("packages_workload", "load" + suffix, load_samples, {
+        { "rows", num_rows },
+        { "rows_per_s", std::round(num_rows / (load_samples.median() / 1e6)) },
+    });
+
+    for (auto [name, sql] : QUERIES) {
+        auto stmt = m::statement_from_string(diag, sql);
+        auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
+
+        std::size_t num_results = 0;
+        const auto samples = harness.measure([&]() {
+            num_results = 0;
+            auto op = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple&) { ++num_results; });
+            m::execute_query(diag, *query, std::move(op));
+        });
+
+        const double median_s = samples.median() / 1e6;
+        harness.report("packages_workload", name + suffix, samples, {
+            { "rows", num_rows },
+            { "rows_per_s", std::round(num_rows / median_s) },
+            { "queries_per_s", 1 / median_s },
+            { "results", num_results },
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Harness harness(BenchmarkOptions::ParseOrExit(argc, argv));
+
+    auto &C = m::Catalog::Get();
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+
+    for (auto scale : SCALES) {
+        /* Replicate the packages once per scale, for all layouts. */
+        const auto path = std::filesystem::temp_directory_path() / ("packages-x" + std::to_string(scale) + ".csv");
+        {
+            std::ifstream in("resource/arch-packages.csv");
+            if (not in) {
+                std::cerr << "cannot read resource/arch-packages.csv" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            std::ofstream out(path);
+            replicate_packages(in, out, scale);
+        }
+
+        for (auto layout : { "row_naive", "row_optimized", "PAX4k" })
+            run_benchmark(harness, layout, path, scale);
+        std::filesystem::remove(path);
+    }
+    m::Catalog::Destroy();
+}
@@ -0,0 +1,110 @@
+#include "UnixSocket.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+void usage(std::ostream &out, const char *name)
+{
+    out << "USAGE:\n    " << name << " <SOCKET> [--clients <N>] [--queries <N>] [--sql <QUERY.sql>]\n\n"
+        << "Connects N clients concurrently to the query server listening on SOCKET, each sending the statement in "
+           "QUERY.sql (default resource/query.sql) N times and waiting for every result before sending the next.\n"
+           "Writes a line `query_load,<clients>,<queries>,<s>,<queries per second>,<p50 µs>,<p95 µs>,<p99 µs>` of "
+           "the round trip latencies seen by the clients." << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    using namespace std::chrono;
+
+    /* Check the parameters. */
+    if (argc < 2 or argc % 2 != 0) {
+        usage(std::cerr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    std::size_t num_clients = std::max(1U, std::thread::hardware_concurrency());
+    std::size_t num_queries = 1000;
+    const char *sql_path = "resource/query.sql";
+    for (int i = 2; i != argc; i += 2) {
+        if (std::strcmp(argv[i], "--clients") == 0) {
+            num_clients = std::max(1UL, std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--queries") == 0) {
+            num_queries = std::max(1UL, std::strtoul(argv[i + 1], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--sql") == 0) {
+            sql_path = argv[i + 1];
+        } else {
+            usage(std::cerr, argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    std::ifstream in(sql_path);
+    std::stringstream sql;
+    sql << in.rdbuf();
+    if (not in or sql.str().find(';') == std::string::npos) {
+        std::cerr << "cannot read a statement from " << sql_path << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    const std::string statement = sql.str().substr(0, sql.str().find(';') + 1) + '\n';
+
+    /*----- Send the statement from all clients concurrently, one at a time per client. -----*/
+    std::vector<std::vector<double>> latencies(num_clients); // µs
+    std::vector<std::size_t> num_errors(num_clients, 0);
+    std::vector<std::thread> clients;
+    const auto t_begin = steady_clock::now();
+    for (std::size_t c = 0; c != num_clients; ++c) {
+        clients.emplace_back([&, c]() {
+            const int fd = connect_unix_socket(argv[1]);
+            if (fd < 0) {
+                num_errors[c] = num_queries;
+                return;
+            }
+            SocketStream stream(fd);
+            latencies[c].reserve(num_queries);
+            for (std::size_t q = 0; q != num_queries; ++q) {
+                const auto t_query_begin = steady_clock::now();
+                stream << statement << std::flush;
+                /* Skip the tuples of the result up to its final line. */
+                std::string line;
+                while (std::getline(stream, line) and line.rfind("query,", 0) != 0 and line.rfind("error,", 0) != 0)
+                    ;
+                if (not stream) {
+                    num_errors[c] += num_queries - q;
+                    return;
+                }
+                if (line.rfind("error,", 0) == 0)
+                    ++num_errors[c];
+                latencies[c].push_back(duration_cast<nanoseconds>(steady_clock::now() - t_query_begin).count() / 1e3);
+            }
+        });
+    }
+    for (auto &client : clients)
+        client.join();
+    const double s = duration_cast<nanoseconds>(steady_clock::now() - t_begin).count() / 1e9;
+
+    /*----- Report throughput and latency percentiles. -----*/
+    std::vector<double> all;
+    for (auto &l : latencies)
+        all.insert(all.end(), l.begin(), l.end());
+    std::size_t total_errors = 0;
+    for (auto e : num_errors)
+        total_errors += e;
+    if (all.empty()) {
+        std::cerr << "no query was answered" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&all](double p) { return all[std::min(all.size() - 1, std::size_t(p * all.size()))]; };
+
+    std::cout << "query_load," << num_clients << ',' << all.size() << ',' << s << ',' << all.size() / s << ','
+              << percentile(.5) << ',' << percentile(.95) << ',' << percentile(.99) << std::endl;
+    if (total_errors)
+        std::cerr << total_errors << " queries failed" << std::endl;
+}
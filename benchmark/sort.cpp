@@ -0,0 +1,128 @@
+#include "Harness.hpp"
+#include "ParallelSort.hpp"
+#include "ThreadPool.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+#ifndef NDEBUG
+constexpr std::size_t NUM_COPIES = 10;
+#else
+constexpr std::size_t NUM_COPIES = 200;
+#endif
+
+
+/** An `ORDER BY` to benchmark, sorting by one attribute of the packages, and its `LIMIT`, if any. */
+struct Order
+{
+    const char *name;
+    const char *attr;
+    bool descending;
+    std::size_t limit; ///< 0 for no limit
+};
+
+/** Sorts `NUM_COPIES` copies of the packages in the layout \p layout by every order of \p orders, natively on
+ * \p serial and on \p parallel and by a mutable query. */
+void run_benchmark(Harness &harness, ThreadPool &serial, ThreadPool &parallel, const char *layout,
+                   const std::vector<Order> &orders)
+{
+    m::Catalog::Clear();
+    auto &C = m::Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(true, devnull, std::cerr);
+    C.default_data_layout(layout);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    T.layout(C.data_layout());
+    for (std::size_t i = 0; i != NUM_COPIES; ++i)
+        m::load_from_CSV(diag, T, "resource/arch-packages.csv", std::numeric_limits<std::size_t>::max(), true, false);
+    if (diag.num_errors())
+        return;
+
+    const LayoutColumn id = LayoutColumn::Of(T, "id");
+    const std::size_t num_rows = T.store().num_rows();
+    ParallelSort sort;
+
+    for (auto &order : orders) {
+        const std::string prefix = std::string(layout) + '_' + order.name + '_';
+        auto report = [&](const char *variant, const Samples &samples, std::size_t num_results, int64_t first_id) {
+            harness.report("sort", prefix + variant, samples, {
+                { "results", num_results },
+                { "first_id", first_id },
+            });
+        };
+
+        const std::vector<SortKey> keys{ SortKey{ LayoutColumn::Of(T, order.attr), order.descending } };
+        for (auto [variant, pool] : { std::pair{ "native", &serial }, std::pair{ "native_parallel", &parallel } }) {
+            if (pool == &parallel and parallel.num_threads() == 1)
+                break; // a single hardware thread, measured already
+            std::vector<uint32_t> rows;
+            const auto samples = harness.measure([&]() {
+                rows = order.limit ? sort.top_k(*pool, keys, num_rows, order.limit) : sort(*pool, keys, num_rows);
+            });
+            report(variant, samples, rows.size(), rows.empty() ? -1 : load_integer(id.at(rows.front()), id.size));
+        }
+
+        std::ostringstream oss;
+        oss << "SELECT id FROM packages ORDER BY " << order.attr << (order.descending ? " DESC" : "");
+        if (order.limit)
+            oss << " LIMIT " << order.limit;
+        oss << ';';
+        auto stmt = m::statement_from_string(diag, oss.str());
+        auto query = m::as<m::ast::SelectStmt>(std::move(stmt));
+        std::size_t num_results = 0;
+        int64_t first_id = -1;
+        const auto samples = harness.measure([&]() {
+            num_results = 0;
+            first_id = -1;
+            auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &t) {
+                if (num_results++ == 0)
+                    first_id = t[0].as_i();
+            });
+            m::execute_query(diag, *query, std::move(callback));
+        });
+        report("mutable", samples, num_results, first_id);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto options = BenchmarkOptions::ParseOrExit(argc, argv);
+    /* Create the pools before the harness pins this thread, lest their workers share its CPU. */
+    ThreadPool serial(1), parallel;
+    Harness harness(options);
+
+    auto &C = m::Catalog::Get();
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+
+    const std::vector<Order> orders{
+        { "size", "size", false, 0 },
+        { "pkg_name", "pkg_name", false, 0 },
+        { "size_desc_top10", "size", true, 10 },
+        { "size_desc_top1000", "size", true, 1000 },
+    };
+    for (auto layout : { "row_naive", "row_optimized", "PAX4k" })
+        run_benchmark(harness, serial, parallel, layout, orders);
+}
@@ -90,6 +90,8 @@ public:
 
     struct Node
     {
+        virtual ~Node() = default;
+
         virtual void append_child(ref_pair<key_type, mapped_type> child) {}
         virtual void append_child(key_type key, Node *child) {}
 
@@ -119,14 +121,7 @@ public:
         // TODO: make fields private
         ref_pair<key_type, mapped_type> children[NUM_KEYS_PER_LEAF];
         int size = 0;
-        Node *next_leaf = nullptr;
-
-        ~Leaf()
-        {
-            delete[] children;
-            if (next_leaf != nullptr)
-                delete next_leaf;
-        }
+        Node *next_leaf = nullptr; ///< not owned, leaves are owned by their parents
 
         int get_size() override { return size; }
 
@@ -212,7 +207,8 @@ public:
 
         ~INode()
         {
-            delete[] children;
+            for (int i = 0; i != size; ++i)
+                delete children[i].second();
         }
 
         int get_size() override { return size; }
@@ -401,7 +397,22 @@ public:
     {
     }
 
-    ~BTree() {}
+    BTree(const BTree&) = delete;
+    BTree(BTree &&other) : root{std::exchange(other.root, nullptr)}, size_{other.size_}, height_{other.height_}
+    {
+    }
+
+    /** Frees all nodes of the tree. */
+    ~BTree() { delete root; }
+
+    BTree &operator=(const BTree&) = delete;
+    BTree &operator=(BTree &&other)
+    {
+        std::swap(root, other.root);
+        std::swap(size_, other.size_);
+        std::swap(height_, other.height_);
+        return *this;
+    }
 
     static Node *bulkload_helper(std::vector<Node *> &children, int64_t &height)
     {
@@ -646,7 +657,7 @@ public:
             left_leaf->get_start_iterator(),
             left_leaf->get_last_iterator());
 
-        while (left != end && left.first() < lo)
+        while (left != end && (*left).first() < lo)
             ++left;
 
         const_iterator right = const_iterator(
@@ -654,7 +665,7 @@ public:
             right_leaf->get_start_iterator(),
             right_leaf->get_last_iterator());
 
-        while (right != end && right.first() < hi)
+        while (right != end && (*right).first() < hi)
             ++right;
 
         return const_range(left, right);
@@ -0,0 +1,149 @@
+#include "BoundedPlanTable.hpp"
+#include "JoinPredicates.hpp"
+#include "QuerySimplification.hpp"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <utility>
+#include <vector>
+
+using namespace m;
+
+
+namespace {
+
+/** A plan found by greedy operator ordering. */
+struct GreedyPlan
+{
+    std::vector<std::pair<uint64_t, uint64_t>> joins; ///< the joins in the order they are performed
+    double cost = 0; ///< the C_out cost of the plan
+    double final_size = 0; ///< the cardinality of the final result
+};
+
+/** Greedy operator ordering (GOO): joins the two adjacent subplans with the smallest result until one is left. */
+template<typename PlanTable>
+GreedyPlan greedy_plan(PlanTable &PT, const QueryGraph &G, const CardinalityEstimator &CE)
+{
+    const JoinPredicates predicates(G);
+    UnitGraph U(G);
+
+    std::vector<std::unique_ptr<DataModel>> models(U.size());
+    auto model = [&](std::size_t u) -> const DataModel & {
+        return models[u] ? *models[u] : *PT[SmallBitset(U.sources_of(u))].model;
+    };
+
+    GreedyPlan plan;
+    while (U.size() > 1) {
+        std::unique_ptr<DataModel> best_model;
+        double best = std::numeric_limits<double>::infinity();
+        std::size_t best_u = 0, best_v = 0;
+        for (std::size_t u = 0; u != U.size(); ++u) {
+            for (uint64_t n = U.neighbours_of(u) & ~(~0UL >> (63 - u)); n; n &= n - 1) { // each edge once
+                const std::size_t v = std::countr_zero(n);
+                auto joined = CE.estimate_join(G, model(u), model(v),
+                                               predicates.between(U.sources_of(u), U.sources_of(v)));
+                const double size = CE.predict_cardinality(*joined);
+                if (size < best) {
+                    best = size;
+                    best_model = std::move(joined);
+                    best_u = u;
+                    best_v = v;
+                }
+            }
+        }
+        if (not best_model)
+            break; // the graph is not connected
+
+        plan.joins.emplace_back(U.sources_of(best_u), U.sources_of(best_v));
+        plan.cost += best;
+        plan.final_size = best;
+        models[best_u] = std::move(best_model);
+        models[best_v] = std::move(models.back()); // `merge()` moves the last unit to `best_v`
+        models.pop_back();
+        U.merge(best_u, best_v);
+    }
+    return plan;
+}
+
+/** Enters the plan for \p S in \p T into \p PT, bottom up. */
+template<typename PlanTable>
+void write_plan(PlanTable &PT, BoundedPlanTable &T, const QueryGraph &G, const CardinalityEstimator &CE,
+                const CostFunction &CF, const JoinPredicates &predicates, uint64_t S)
+{
+    if (std::has_single_bit(S))
+        return;
+    const uint64_t left = T.find(S)->left, right = S & ~left;
+    write_plan(PT, T, G, CE, CF, predicates, left);
+    write_plan(PT, T, G, CE, CF, predicates, right);
+    PT.update(G, CE, CF, SmallBitset(left), SmallBitset(right), predicates.between(left, right));
+}
+
+}
+
+template<typename PlanTable>
+BoundedEnumerationResult enumerate_bounded(PlanTable &PT, const QueryGraph &G, const CardinalityEstimator &CE,
+                                           const CostFunction &CF, std::size_t budget)
+{
+    const JoinPredicates predicates(G);
+    const std::size_t num_sources = G.num_sources();
+    const uint64_t all = ~0UL >> (64 - num_sources);
+
+    /*----- Compute an upper bound by GOO. -----*/
+    const GreedyPlan greedy = greedy_plan(PT, G, CE);
+    const double upper_bound = greedy.cost;
+
+    /*----- Enumerate connected subproblems that can beat the bound. -----*/
+    BoundedPlanTable T(budget);
+    bool exact = true;
+    for (std::size_t i = 0; i != num_sources; ++i)
+        exact = exact and T.insert(1UL << i, { 0, PT[SmallBitset(1UL << i)].cost, nullptr });
+
+    auto model = [&](uint64_t S) -> const DataModel & {
+        return std::has_single_bit(S) ? *PT[SmallBitset(S)].model : *T.find(S)->model;
+    };
+
+    exact = exact and UnitGraph(G).for_each_ccp([&](uint64_t S1, uint64_t S2) {
+        auto E1 = T.find(S1), E2 = T.find(S2);
+        if (not E1 or not E2)
+            return true; // pruned
+        const uint64_t S = S1 | S2;
+        const double remaining = S == all ? 0 : greedy.final_size; // lower bound of the cost to complete the plan
+        const double inputs = E1->cost + E2->cost;
+        if (inputs + remaining > upper_bound)
+            return true;
+
+        if (auto E = T.find(S)) {
+            const double cost = inputs + CE.predict_cardinality(*E->model);
+            if (cost < E->cost) {
+                E->left = S1;
+                E->cost = cost;
+            }
+            return true;
+        }
+
+        auto joined = CE.estimate_join(G, model(S1), model(S2), predicates.between(S1, S2));
+        const double cost = inputs + CE.predict_cardinality(*joined);
+        if (cost + remaining > upper_bound)
+            return true;
+        return T.insert(S, { S1, cost, std::move(joined) }); // abort if the budget is exceeded
+    });
+
+    /*----- Enter the final plan into `PT`. -----*/
+    if (exact and T.find(all)) {
+        write_plan(PT, T, G, CE, CF, predicates, all);
+    } else {
+        exact = false;
+        for (auto [left, right] : greedy.joins)
+            PT.update(G, CE, CF, SmallBitset(left), SmallBitset(right), predicates.between(left, right));
+    }
+
+    return { exact, upper_bound, T.peak_bytes() };
+}
+
+#define INSTANTIATE(PLAN_TABLE) \
+    template BoundedEnumerationResult enumerate_bounded<PLAN_TABLE>(PLAN_TABLE &, const QueryGraph &, \
+                                                                    const CardinalityEstimator &, \
+                                                                    const CostFunction &, std::size_t);
+INSTANTIATE(PlanTableSmallOrDense)
+INSTANTIATE(PlanTableLargeAndSparse)
+#undef INSTANTIATE
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <unordered_map>
+
+
+/** A plan table for C_out with a hard memory budget.  Only connected subproblems are stored, and only if their plan
+ * can still be part of a plan cheaper than a known upper bound: under C_out, a plan containing a subplan for `S` costs
+ * at least the cost of that subplan plus the cardinality of the final result.  When the table would exceed its
+ * budget, insertion fails and enumeration is expected to give up. */
+struct BoundedPlanTable
+{
+    struct entry_type
+    {
+        uint64_t left;
+        double cost;
+        std::unique_ptr<m::DataModel> model;
+    };
+
+    ///> an estimate of the bytes of a data model of the cardinality estimator
+    static constexpr std::size_t MODEL_BYTES = 64;
+    ///> an estimate of the bytes of one entry including the hash table node and its data model
+    static constexpr std::size_t ENTRY_BYTES = sizeof(std::pair<const uint64_t, entry_type>) + 2 * sizeof(void*) +
+                                               MODEL_BYTES;
+
+    private:
+    std::unordered_map<uint64_t, entry_type> table_;
+    std::size_t budget_;
+    std::size_t peak_bytes_ = 0;
+
+    public:
+    /** Creates a table of at most \p budget bytes.  The buckets for as many entries as fit into the budget are
+     * allocated up front, so that the table never rehashes and its bucket array is accounted for from the start. */
+    explicit BoundedPlanTable(std::size_t budget) : budget_(budget)
+    {
+        table_.reserve(budget / ENTRY_BYTES);
+        peak_bytes_ = bytes();
+    }
+
+    /** Returns the current memory consumption in bytes, including the bucket array of the hash table. */
+    std::size_t bytes() const { return table_.size() * ENTRY_BYTES + table_.bucket_count() * sizeof(void*); }
+    /** Returns the peak memory consumption in bytes. */
+    std::size_t peak_bytes() const { return peak_bytes_; }
+    std::size_t size() const { return table_.size(); }
+
+    entry_type * find(uint64_t S)
+    {
+        auto it = table_.find(S);
+        return it == table_.end() ? nullptr : &it->second;
+    }
+
+    /** Inserts or replaces the plan for \p S.  Returns `false`, without inserting, if the table would exceed its
+     * budget.  Since the buckets are reserved for the most entries the budget can hold, inserting never rehashes. */
+    bool insert(uint64_t S, entry_type entry)
+    {
+        if (auto it = table_.find(S); it != table_.end()) {
+            it->second = std::move(entry);
+            return true;
+        }
+        if (bytes() + ENTRY_BYTES > budget_)
+            return false;
+        table_.emplace(S, std::move(entry));
+        peak_bytes_ = std::max(peak_bytes_, bytes());
+        return true;
+    }
+};
+
+/** The outcome of `enumerate_bounded()`. */
+struct BoundedEnumerationResult
+{
+    bool exact; ///< whether enumeration completed within the budget, otherwise the plan is greedy
+    double upper_bound; ///< the C_out cost of the greedy plan used for pruning
+    std::size_t peak_bytes; ///< the peak memory consumption of the bounded plan table
+};
+
+/** Enumerates the plans of \p G for C_out in a `BoundedPlanTable` of at most \p budget bytes.  An upper bound is
+ * obtained first by greedy operator ordering (GOO), always joining the two adjacent subplans with the smallest
+ * result.  DPccp then enumerates all connected subproblems, pruning those that cannot beat the bound.  If the budget
+ * is exceeded, the greedy plan is completed instead.  Only the final plan is entered into \p PT. */
+template<typename PlanTable>
+BoundedEnumerationResult enumerate_bounded(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE,
+                                           const m::CostFunction &CF, std::size_t budget);
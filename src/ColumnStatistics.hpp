@@ -0,0 +1,268 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string_view>
+#include <vector>
+
+
+/** Mixes the bits of \p x such that all bits of the result depend on all bits of the input (SplitMix64 finalizer). */
+inline uint64_t mix_hash(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9UL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebUL;
+    x ^= x >> 31;
+    return x;
+}
+
+/** Hashes the bytes of \p str up to the first NUL byte (FNV-1a, then mixed). */
+inline uint64_t hash_string(std::string_view str)
+{
+    uint64_t h = 0xcbf29ce484222325UL;
+    for (char c : str) {
+        if (c == '\0')
+            break;
+        h = (h ^ uint8_t(c)) * 0x100000001b3UL;
+    }
+    return mix_hash(h);
+}
+
+/** A HyperLogLog sketch estimating the number of distinct values of a column with \tparam Precision index bits, i.e.
+ * `2^Precision` one byte registers.  The standard error is about `1.04 / sqrt(2^Precision)`. */
+template<unsigned Precision = 12>
+struct HyperLogLog
+{
+    static_assert(4 <= Precision and Precision <= 16, "unsupported precision");
+    static constexpr std::size_t NUM_REGISTERS = 1UL << Precision;
+
+    private:
+    std::array<uint8_t, NUM_REGISTERS> registers_{};
+
+    public:
+    /** Adds a value by its (well-mixed) 64 bit hash \p h. */
+    void add_hash(uint64_t h)
+    {
+        const std::size_t idx = h >> (64 - Precision);
+        const uint64_t rest = h << Precision;
+        const uint8_t rank = rest ? std::countl_zero(rest) + 1 : 64 - Precision + 1;
+        registers_[idx] = std::max(registers_[idx], rank);
+    }
+
+    void add(int64_t value) { add_hash(mix_hash(value)); }
+    void add(double value) { uint64_t bits; std::memcpy(&bits, &value, sizeof(bits)); add_hash(mix_hash(bits)); }
+    void add(std::string_view value) { add_hash(hash_string(value)); }
+
+    /** Merges sketch \p other into this sketch. */
+    void merge(const HyperLogLog &other)
+    {
+        for (std::size_t i = 0; i != NUM_REGISTERS; ++i)
+            registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+
+    /** Returns the estimated number of distinct values added. */
+    double estimate() const
+    {
+        constexpr double m = NUM_REGISTERS;
+        constexpr double alpha = 0.7213 / (1. + 1.079 / m);
+
+        double sum = 0;
+        std::size_t num_zeros = 0;
+        for (auto r : registers_) {
+            sum += std::ldexp(1., -int(r));
+            num_zeros += r == 0;
+        }
+        const double raw = alpha * m * m / sum;
+
+        /* Small range correction by linear counting. */
+        if (raw <= 2.5 * m and num_zeros != 0)
+            return m * std::log(m / num_zeros);
+        return raw;
+    }
+};
+
+/** An equi-depth histogram over a numeric column.  Every bucket covers about the same number of rows and records the
+ * number of distinct values in its range. */
+struct EquiDepthHistogram
+{
+    struct Bucket
+    {
+        double lower; ///< smallest value in the bucket
+        double upper; ///< largest value in the bucket
+        double count; ///< number of rows in the bucket
+        double distinct; ///< number of distinct values in the bucket
+    };
+
+    private:
+    std::vector<Bucket> buckets_;
+    double num_rows_ = 0;
+
+    public:
+    EquiDepthHistogram() = default;
+
+    /** Builds a histogram of at most \p num_buckets buckets from a uniform \p sample of a column of \p num_rows rows
+     * with \p num_distinct distinct values in total.  The sample is sorted in place. */
+    EquiDepthHistogram(std::vector<double> &sample, double num_rows, double num_distinct, std::size_t num_buckets = 64)
+        : num_rows_(num_rows)
+    {
+        if (sample.empty() or num_rows == 0)
+            return;
+        std::sort(sample.begin(), sample.end());
+
+        const double scale = num_rows / sample.size();
+
+        /* Scale distinct values found in the sample to the total number of distinct values. */
+        std::size_t num_sample_distinct = 1;
+        for (std::size_t i = 1; i < sample.size(); ++i)
+            num_sample_distinct += sample[i] != sample[i - 1];
+        const double distinct_scale = std::max(1., num_distinct / num_sample_distinct);
+
+        const std::size_t depth = std::max<std::size_t>(1, (sample.size() + num_buckets - 1) / num_buckets);
+        for (std::size_t begin = 0; begin < sample.size(); ) {
+            std::size_t end = std::min(begin + depth, sample.size());
+            /* Never split a value across buckets. */
+            while (end < sample.size() and sample[end] == sample[end - 1])
+                ++end;
+
+            std::size_t distinct = 1;
+            for (std::size_t i = begin + 1; i != end; ++i)
+                distinct += sample[i] != sample[i - 1];
+
+            buckets_.push_back(Bucket{ sample[begin], sample[end - 1], (end - begin) * scale,
+                                       std::min(distinct * distinct_scale, (end - begin) * scale) });
+            begin = end;
+        }
+    }
+
+    bool empty() const { return buckets_.empty(); }
+    double num_rows() const { return num_rows_; }
+    const std::vector<Bucket> & buckets() const { return buckets_; }
+
+    /** Returns the estimated fraction of rows with a value equal to \p v. */
+    double selectivity_equal(double v) const
+    {
+        if (empty())
+            return 0;
+        auto it = std::lower_bound(buckets_.begin(), buckets_.end(), v,
+                                   [](const Bucket &b, double v) { return b.upper < v; });
+        if (it == buckets_.end() or v < it->lower)
+            return 0;
+        return it->count / it->distinct / num_rows_;
+    }
+
+    /** Returns the estimated fraction of rows with a value less than (or equal to, if \p inclusive) \p v.  Values are
+     * assumed to be spread uniformly within a bucket. */
+    double selectivity_less(double v, bool inclusive) const
+    {
+        if (empty())
+            return 0;
+        double rows = 0;
+        for (auto &b : buckets_) {
+            if (b.upper < v or (inclusive and b.upper == v)) {
+                rows += b.count;
+            } else {
+                if (b.lower < v) {
+                    const double width = b.upper - b.lower;
+                    rows += b.count * (v - b.lower) / width;
+                }
+                if (inclusive and b.lower <= v)
+                    rows += b.count / b.distinct;
+                break;
+            }
+        }
+        return std::min(1., rows / num_rows_);
+    }
+
+    /** Returns the estimated fraction of rows with a value in `[lo, hi]`. */
+    double selectivity_range(double lo, double hi) const
+    {
+        if (hi < lo)
+            return 0;
+        return std::max(0., selectivity_less(hi, true) - selectivity_less(lo, false));
+    }
+
+    /** Estimates the number of result rows of the equi-join of the columns of \p a and \p b.  Within the overlap of
+     * two buckets, values are assumed to be spread uniformly and every value of the side with fewer distinct values to
+     * find a join partner (containment assumption). */
+    static double estimate_join(const EquiDepthHistogram &a, const EquiDepthHistogram &b)
+    {
+        double result = 0;
+        auto ia = a.buckets_.begin(), ib = b.buckets_.begin();
+        auto fraction = [](const Bucket &bucket, double lo, double hi) {
+            const double width = bucket.upper - bucket.lower;
+            return width == 0 ? 1. : (hi - lo) / width;
+        };
+        while (ia != a.buckets_.end() and ib != b.buckets_.end()) {
+            const double lo = std::max(ia->lower, ib->lower);
+            const double hi = std::min(ia->upper, ib->upper);
+            if (lo <= hi) {
+                const double fa = fraction(*ia, lo, hi), fb = fraction(*ib, lo, hi);
+                const double rows_a = ia->count * fa, rows_b = ib->count * fb;
+                const double distinct = std::max({ ia->distinct * fa, ib->distinct * fb, 1. });
+                result += rows_a * rows_b / distinct;
+            }
+            if (ia->upper < ib->upper)
+                ++ia;
+            else
+                ++ib;
+        }
+        return result;
+    }
+};
+
+/** Statistics of a single column, collected in a single pass over the column. */
+struct ColumnStatistics
+{
+    static constexpr std::size_t SAMPLE_SIZE = 1UL << 15;
+
+    HyperLogLog<> distinct_values;
+    EquiDepthHistogram histogram; ///< only for numeric columns
+    double num_rows = 0;
+    double num_nulls = 0;
+    bool is_numeric = false;
+
+    private:
+    std::vector<double> sample_;
+    std::mt19937_64 rng_{ 42 };
+
+    public:
+    void add_null() { ++num_rows; ++num_nulls; }
+
+    void add(double value)
+    {
+        is_numeric = true;
+        distinct_values.add(value);
+        /* Reservoir sampling of the non-NULL values, which are all the histogram describes. */
+        ++num_rows;
+        if (sample_.size() < SAMPLE_SIZE) {
+            sample_.push_back(value);
+        } else {
+            const uint64_t i = std::uniform_int_distribution<uint64_t>(0, num_rows - num_nulls - 1)(rng_);
+            if (i < SAMPLE_SIZE)
+                sample_[i] = value;
+        }
+    }
+
+    void add(std::string_view value) { ++num_rows; distinct_values.add(value); }
+
+    /** Builds the histogram after all values were added. */
+    void finalize()
+    {
+        if (is_numeric)
+            histogram = EquiDepthHistogram(sample_, num_rows - num_nulls, num_distinct());
+        sample_.clear();
+        sample_.shrink_to_fit();
+    }
+
+    /** Returns the estimated number of distinct non-NULL values, at least 1. */
+    double num_distinct() const
+    {
+        return std::clamp(distinct_values.estimate(), 1., std::max(1., num_rows - num_nulls));
+    }
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/** Forwards all estimates to another `CardinalityEstimator` and corrects them by the actual cardinalities observed
+ * during execution.  Every model remembers the data sources it describes.  The cardinality of a model is the estimate
+ * of the wrapped estimator, scaled by the ratio of actual to estimated cardinality of every observed subproblem it
+ * contains, considering the largest disjoint observed subproblems first.  Hence an observed subproblem is predicted
+ * exactly, and the error observed for it is propagated to all plans joining it. */
+struct FeedbackCardinalityEstimator : m::CardinalityEstimator
+{
+    using Subproblem = m::SmallBitset;
+
+    struct Model : m::DataModel
+    {
+        std::unique_ptr<m::DataModel> base; ///< the model of the wrapped estimator
+        uint64_t sources; ///< the data sources described by this model
+
+        Model(std::unique_ptr<m::DataModel> base, uint64_t sources) : base(std::move(base)), sources(sources) { }
+    };
+
+    private:
+    struct Observation
+    {
+        uint64_t sources;
+        double estimated; ///< the cardinality estimated by the wrapped estimator
+        double actual;
+    };
+
+    const m::CardinalityEstimator &estimator_;
+    std::vector<Observation> observations_; ///< sorted by descending number of data sources
+
+    static const Model & as_model(const m::DataModel &data) { return m::as<const Model>(data); }
+
+    static std::unique_ptr<m::DataModel> wrap(std::unique_ptr<m::DataModel> base, uint64_t sources) {
+        return std::make_unique<Model>(std::move(base), sources);
+    }
+
+    public:
+    explicit FeedbackCardinalityEstimator(const m::CardinalityEstimator &estimator) : estimator_(estimator) { }
+
+    /** Records that the result described by \p data, a model of this estimator, has \p cardinality tuples. */
+    void observe(const m::DataModel &data, std::size_t cardinality) {
+        const Model &model = as_model(data);
+        std::erase_if(observations_, [&](const Observation &o) { return o.sources == model.sources; });
+        const Observation o{ model.sources, double(estimator_.predict_cardinality(*model.base)), double(cardinality) };
+        auto pos = std::find_if(observations_.begin(), observations_.end(), [&](const Observation &other) {
+            return std::popcount(other.sources) < std::popcount(o.sources);
+        });
+        observations_.insert(pos, o);
+    }
+
+    std::size_t num_observations() const { return observations_.size(); }
+
+    std::unique_ptr<m::DataModel> empty_model() const override {
+        return wrap(estimator_.empty_model(), 0);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_scan(const m::QueryGraph &G, Subproblem P) const override {
+        return wrap(estimator_.estimate_scan(G, P), uint64_t(P));
+    }
+
+    std::unique_ptr<m::DataModel> estimate_filter(const m::QueryGraph &G, const m::DataModel &data,
+                                                  const m::cnf::CNF &filter) const override {
+        auto &model = as_model(data);
+        return wrap(estimator_.estimate_filter(G, *model.base, filter), model.sources);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_limit(const m::QueryGraph &G, const m::DataModel &data, std::size_t limit,
+                                                 std::size_t offset) const override {
+        auto &model = as_model(data);
+        return wrap(estimator_.estimate_limit(G, *model.base, limit, offset), model.sources);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_grouping(const m::QueryGraph &G, const m::DataModel &data,
+                                                    const std::vector<const m::ast::Expr*> &groups) const override {
+        auto &model = as_model(data);
+        return wrap(estimator_.estimate_grouping(G, *model.base, groups), model.sources);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_join(const m::QueryGraph &G, const m::DataModel &left,
+                                                const m::DataModel &right,
+                                                const m::cnf::CNF &condition) const override {
+        auto &l = as_model(left), &r = as_model(right);
+        return wrap(estimator_.estimate_join(G, *l.base, *r.base, condition), l.sources | r.sources);
+    }
+
+    std::size_t predict_cardinality(const m::DataModel &data) const override {
+        auto &model = as_model(data);
+        double cardinality = estimator_.predict_cardinality(*model.base);
+        uint64_t covered = 0;
+        for (auto &o : observations_) {
+            if (o.sources == model.sources)
+                return o.actual;
+            if ((o.sources & ~model.sources) == 0 and (o.sources & covered) == 0) {
+                cardinality *= o.actual / std::max(1., o.estimated);
+                covered |= o.sources;
+            }
+        }
+        return cardinality;
+    }
+
+    void print(std::ostream &out) const override {
+        out << "feedback on ";
+        estimator_.print(out);
+    }
+};
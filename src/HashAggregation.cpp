@@ -0,0 +1,196 @@
+#include "HashAggregation.hpp"
+#include "ColumnStatistics.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+using namespace m;
+
+
+namespace {
+
+/** A partial aggregate of one group.  The key refers to the memory of the store. */
+struct Aggregate
+{
+    uint64_t hash;
+    std::string_view key;
+    uint64_t count = 0; ///< 0 for empty slots
+    uint64_t num_values = 0; ///< the number of non-NULL values summed
+    int64_t sum = 0;
+
+    /** Adds the partial aggregate \p other of the same group. */
+    void merge(const Aggregate &other) {
+        count += other.count;
+        num_values += other.num_values;
+        sum += other.sum;
+    }
+};
+
+/** A hash table of aggregates with linear probing. */
+struct AggregateTable
+{
+    private:
+    std::vector<Aggregate> slots_;
+    std::size_t mask_;
+    std::size_t size_ = 0;
+
+    public:
+    /** Creates a table of \p num_slots slots, a power of two. */
+    explicit AggregateTable(std::size_t num_slots) : slots_(num_slots), mask_(num_slots - 1) { }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return slots_.size(); }
+
+    /** Adds the partial aggregate \p a to the aggregate of its group.  The table must not be full. */
+    void add(const Aggregate &a)
+    {
+        for (std::size_t i = a.hash & mask_; ; i = (i + 1) & mask_) {
+            Aggregate &slot = slots_[i];
+            if (slot.count == 0) {
+                slot = a;
+                ++size_;
+                return;
+            }
+            if (slot.hash == a.hash and slot.key == a.key) {
+                slot.merge(a);
+                return;
+            }
+        }
+    }
+
+    template<typename Fn>
+    void for_each(Fn &&fn) const
+    {
+        for (auto &slot : slots_) {
+            if (slot.count)
+                fn(slot);
+        }
+    }
+
+    void clear()
+    {
+        std::fill(slots_.begin(), slots_.end(), Aggregate{});
+        size_ = 0;
+    }
+};
+
+/** Returns the text of \p key, a value of \p column. */
+std::string key_text(const LayoutColumn &column, std::string_view key)
+{
+    if (column.is_character_sequence)
+        return std::string(key);
+    return std::to_string(load_integer(reinterpret_cast<const uint8_t*>(key.data()), column.size));
+}
+
+}
+
+std::vector<HashAggregation::Group> HashAggregation::operator()(ThreadPool &pool, const LayoutColumn &key,
+                                                                const LayoutColumn &value, std::size_t num_rows) const
+{
+    M_insist(std::has_single_bit(preaggregation_slots), "the number of slots must be a power of two");
+    M_insist(key.tuples_per_block == value.tuples_per_block, "the columns must be of the same layout");
+    M_insist(not value.is_character_sequence, "only integers can be summed");
+
+    const std::size_t num_partitions = std::size_t(1) << partition_bits;
+    auto partition_of = [this](uint64_t hash) { return partition_bits ? hash >> (64 - partition_bits) : 0; };
+
+    /*----- Pre-aggregate morsels into thread-local tables, spilling them into thread-local partitions. -----*/
+    const std::size_t num_workers = pool.num_threads();
+    const std::size_t num_morsels = (num_rows + morsel_size - 1) / morsel_size;
+    std::vector<std::vector<std::vector<Aggregate>>> spills(num_workers,
+                                                            std::vector<std::vector<Aggregate>>(num_partitions));
+    std::vector<Aggregate> null_groups(num_workers);
+    std::atomic_size_t next_morsel = 0;
+    pool.parallel_for(num_workers, 1, [&](std::size_t worker) {
+        AggregateTable table(preaggregation_slots);
+        auto &partitions = spills[worker];
+        Aggregate &null_group = null_groups[worker]; // NULL keys are grouped without hashing
+        auto spill = [&]() {
+            table.for_each([&](const Aggregate &a) { partitions[partition_of(a.hash)].push_back(a); });
+            table.clear();
+        };
+
+        for (std::size_t morsel; (morsel = next_morsel++) < num_morsels; ) {
+            const std::size_t end = std::min(num_rows, (morsel + 1) * morsel_size);
+            /* Scan the morsel block by block, values of consecutive tuples of a block being `stride` bytes apart. */
+            for (std::size_t row = morsel * morsel_size; row < end; ) {
+                const std::size_t n = std::min(end - row, key.tuples_per_block - row % key.tuples_per_block);
+                const uint8_t *k = key.at(row), *v = value.at(row);
+                for (std::size_t i = 0; i != n; ++i, k += key.stride, v += value.stride) {
+                    const bool has_value = not value.is_null(row + i);
+                    Aggregate a;
+                    a.count = 1;
+                    a.num_values = has_value;
+                    if (has_value)
+                        a.sum = load_integer(v, value.size);
+                    if (key.is_null(row + i)) {
+                        null_group.merge(a);
+                        continue;
+                    }
+                    const char *str = reinterpret_cast<const char*>(k);
+                    if (key.is_character_sequence) {
+                        a.key = std::string_view(str, strnlen(str, key.size));
+                        a.hash = hash_string(a.key);
+                    } else {
+                        a.key = std::string_view(str, key.size);
+                        a.hash = mix_hash(load_integer(k, key.size));
+                    }
+                    table.add(a);
+                    if (2 * table.size() > table.capacity())
+                        spill();
+                }
+                row += n;
+            }
+        }
+        spill();
+    });
+
+    /*----- Merge the spills of every partition. -----*/
+    std::vector<std::vector<Group>> groups(num_partitions);
+    pool.parallel_for(num_partitions, 1, [&](std::size_t p) {
+        std::size_t num_aggregates = 0;
+        for (auto &partitions : spills)
+            num_aggregates += partitions[p].size();
+
+        AggregateTable table(std::bit_ceil(std::max<std::size_t>(2 * num_aggregates, 2)));
+        for (auto &partitions : spills) {
+            for (auto &a : partitions[p])
+                table.add(a);
+            partitions[p] = {};
+        }
+
+        groups[p].reserve(table.size());
+        table.for_each([&](const Aggregate &a) {
+            auto &group = groups[p].emplace_back();
+            group.key = key_text(key, a.key);
+            group.count = a.count;
+            group.num_values = a.num_values;
+            group.sum = a.sum;
+        });
+    });
+
+    std::vector<Group> result;
+    for (auto &partition : groups)
+        result.insert(result.end(), std::make_move_iterator(partition.begin()),
+                      std::make_move_iterator(partition.end()));
+
+    Group null_group;
+    null_group.is_null = true;
+    for (auto &a : null_groups) {
+        null_group.count += a.count;
+        null_group.num_values += a.num_values;
+        null_group.sum += a.sum;
+    }
+    if (null_group.count)
+        result.push_back(std::move(null_group));
+    return result;
+}
+
+std::vector<HashAggregation::Group> HashAggregation::operator()(ThreadPool &pool, const Table &table, const char *key,
+                                                                const char *value) const
+{
+    return (*this)(pool, LayoutColumn::Of(table, key), LayoutColumn::Of(table, value), table.store().num_rows());
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "LayoutColumn.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <string>
+#include <vector>
+
+
+/** Computes `SELECT key, COUNT(*), SUM(value) FROM table GROUP BY key` natively and in parallel, reading the
+ * columns directly from the table's store.
+ *
+ * Every worker of a `ThreadPool` aggregates morsels of the table into a thread-local pre-aggregation table of fixed
+ * size, which stays in cache however many groups there are.  Whenever it is half full, its partial aggregates are
+ * spilled into thread-local radix partitions by the high bits of their keys' hashes and the table is cleared.  Few
+ * groups never spill, many groups are reduced as far as the table allows.  Finally, all threads' spills of one
+ * partition are merged into the final groups, every partition by one worker in parallel.  As in SQL, all NULL keys
+ * form one group of their own and NULL values are not summed. */
+struct HashAggregation
+{
+    struct Group
+    {
+        std::string key; ///< the key as stored for character sequences, in decimal for integers, empty if NULL
+        bool is_null = false; ///< whether this is the group of NULL keys
+        uint64_t count = 0;
+        uint64_t num_values = 0; ///< the number of non-NULL values summed; the SUM is NULL if 0
+        int64_t sum = 0;
+    };
+
+    ///> the number of slots of every thread-local pre-aggregation table, a power of two
+    std::size_t preaggregation_slots = 4096;
+    ///> the number of radix bits partial aggregates are spilled by
+    unsigned partition_bits = 6;
+    ///> the number of rows a worker aggregates at once
+    std::size_t morsel_size = 16 * 1024;
+
+    /** Groups the first \p num_rows rows of \p key and sums \p value, an integral column, per group. */
+    std::vector<Group> operator()(ThreadPool &pool, const LayoutColumn &key, const LayoutColumn &value,
+                                  std::size_t num_rows) const;
+
+    /** Groups all rows of \p table by attribute \p key and sums attribute \p value per group. */
+    std::vector<Group> operator()(ThreadPool &pool, const m::Table &table, const char *key, const char *value) const;
+};
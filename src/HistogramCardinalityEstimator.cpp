@@ -0,0 +1,227 @@
+#include "HistogramCardinalityEstimator.hpp"
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <variant>
+
+using namespace m;
+
+
+void HistogramCardinalityEstimator::add_statistics(Diagnostic &diag, const Table &table)
+{
+    TableStatistics &stats = statistics_[&table];
+    stats = TableStatistics();
+    stats.columns.resize(table.num_attrs());
+
+    /* Scan all columns of the table. */
+    std::ostringstream oss;
+    oss << "SELECT * FROM " << table.name << ';';
+    auto stmt = statement_from_string(diag, oss.str());
+    if (diag.num_errors())
+        return;
+    auto query = as<ast::SelectStmt>(std::move(stmt));
+
+    auto callback = std::make_unique<CallbackOperator>([&stats](const Schema &S, const Tuple &t) {
+        ++stats.num_rows;
+        for (std::size_t i = 0; i != S.num_entries(); ++i) {
+            ColumnStatistics &column = stats.columns[i];
+            const Type *type = S[i].type;
+            if (t.is_null(i))
+                column.add_null();
+            else if (type->is_integral() or type->is_decimal())
+                column.add(double(t[i].as_i()));
+            else if (type->is_double())
+                column.add(t[i].as_d());
+            else if (type->is_float())
+                column.add(double(t[i].as_f()));
+            else if (type->is_boolean())
+                column.add(double(t[i].as_b()));
+            else if (type->is_character_sequence()) {
+                auto str = reinterpret_cast<const char*>(t[i].as_p());
+                const std::size_t length = as<const CharacterSequence>(*type).length;
+                column.add(std::string_view(str, strnlen(str, length)));
+            }
+        }
+    });
+    execute_query(diag, *query, std::move(callback));
+
+    for (auto &column : stats.columns)
+        column.finalize();
+
+    /* Selectivities memoized so far may be based on outdated statistics. */
+    join_selectivities_.clear();
+}
+
+const ColumnStatistics * HistogramCardinalityEstimator::get_column(const ast::Designator &d) const
+{
+    auto target = d.target();
+    auto attr = std::get_if<const Attribute*>(&target);
+    if (not attr or not *attr)
+        return nullptr;
+    auto it = statistics_.find(&(*attr)->table);
+    if (it == statistics_.end())
+        return nullptr;
+    return &it->second.columns[(*attr)->id];
+}
+
+double HistogramCardinalityEstimator::selectivity(const cnf::Predicate &pred) const
+{
+    auto sel = [this](const cnf::Predicate &pred) -> double {
+        auto bin = cast<const ast::BinaryExpr>(&pred.expr());
+        if (not bin)
+            return DEFAULT_SELECTIVITY;
+        auto op = bin->op().type;
+        const ast::Expr *lhs = bin->lhs.get(), *rhs = bin->rhs.get();
+
+        /* Join predicate `A.x = B.y`. */
+        auto ld = cast<const ast::Designator>(lhs), rd = cast<const ast::Designator>(rhs);
+        if (ld and rd) {
+            if (op != TK_EQUAL)
+                return DEFAULT_SELECTIVITY;
+            auto l = get_column(*ld), r = get_column(*rd);
+            if (not l or not r)
+                return DEFAULT_EQUALITY_SELECTIVITY;
+            auto [it, inserted] = join_selectivities_.try_emplace({ std::min(l, r), std::max(l, r) }, 0);
+            if (inserted) {
+                if (l->is_numeric and r->is_numeric and not l->histogram.empty() and not r->histogram.empty()) {
+                    const double size = EquiDepthHistogram::estimate_join(l->histogram, r->histogram);
+                    it->second = size / (l->histogram.num_rows() * r->histogram.num_rows());
+                } else {
+                    it->second = 1. / std::max(l->num_distinct(), r->num_distinct());
+                }
+            }
+            return it->second;
+        }
+
+        /* Filter predicate `A.x op constant`, normalized to have the column on the left. */
+        auto lc = cast<const ast::Constant>(lhs), rc = cast<const ast::Constant>(rhs);
+        if (rd and lc) {
+            std::swap(ld, rd);
+            std::swap(lc, rc);
+            switch (op) {
+                case TK_LESS:          op = TK_GREATER;       break;
+                case TK_LESS_EQUAL:    op = TK_GREATER_EQUAL; break;
+                case TK_GREATER:       op = TK_LESS;          break;
+                case TK_GREATER_EQUAL: op = TK_LESS_EQUAL;    break;
+                default: break;
+            }
+        }
+        if (not ld or not rc)
+            return op == TK_EQUAL ? DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_SELECTIVITY;
+
+        auto column = get_column(*ld);
+        if (not column)
+            return op == TK_EQUAL ? DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_SELECTIVITY;
+
+        const auto &H = column->histogram;
+        const bool numeric = column->is_numeric and not H.empty() and rc->tok.type != TK_STRING_LITERAL;
+        const double v = numeric ? std::strtod(rc->tok.text, nullptr) : 0;
+        switch (op) {
+            case TK_EQUAL:         return numeric ? H.selectivity_equal(v) : 1. / column->num_distinct();
+            case TK_NOT_EQUAL:     return 1. - (numeric ? H.selectivity_equal(v) : 1. / column->num_distinct());
+            case TK_LESS:          return numeric ? H.selectivity_less(v, false) : DEFAULT_SELECTIVITY;
+            case TK_LESS_EQUAL:    return numeric ? H.selectivity_less(v, true) : DEFAULT_SELECTIVITY;
+            case TK_GREATER:       return numeric ? 1. - H.selectivity_less(v, true) : DEFAULT_SELECTIVITY;
+            case TK_GREATER_EQUAL: return numeric ? 1. - H.selectivity_less(v, false) : DEFAULT_SELECTIVITY;
+            default:               return DEFAULT_SELECTIVITY;
+        }
+    };
+
+    const double s = sel(pred);
+    return pred.negative() ? 1. - s : s;
+}
+
+double HistogramCardinalityEstimator::selectivity(const cnf::CNF &cnf) const
+{
+    double result = 1;
+    for (auto &clause : cnf) {
+        /* A clause is a disjunction of predicates, assumed to be independent. */
+        double none = 1;
+        for (auto &pred : clause)
+            none *= 1. - selectivity(pred);
+        result *= 1. - none;
+    }
+    return result;
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::empty_model() const
+{
+    return std::make_unique<HistogramDataModel>(Subproblem(), 0);
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::estimate_scan(const QueryGraph &G, Subproblem P) const
+{
+    M_insist(P.size() == 1, "a scan reads exactly one data source");
+    auto ds = G.sources()[std::countr_zero(uint64_t(P))];
+
+    double size = 0;
+    if (auto bt = cast<const BaseTable>(ds)) {
+        auto it = statistics_.find(&bt->table());
+        size = it != statistics_.end() ? it->second.num_rows : bt->table().store().num_rows();
+    }
+    return std::make_unique<HistogramDataModel>(P, size);
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::estimate_filter(const QueryGraph&, const DataModel &data,
+                                                                          const cnf::CNF &filter) const
+{
+    auto &model = as<const HistogramDataModel>(data);
+    return std::make_unique<HistogramDataModel>(model.subproblem, model.size * selectivity(filter));
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::estimate_limit(const QueryGraph&, const DataModel &data,
+                                                                         std::size_t limit, std::size_t offset) const
+{
+    auto &model = as<const HistogramDataModel>(data);
+    const double size = std::clamp(model.size - double(offset), 0., double(limit));
+    return std::make_unique<HistogramDataModel>(model.subproblem, size);
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::estimate_grouping(
+    const QueryGraph&, const DataModel &data, const std::vector<const ast::Expr*> &groups) const
+{
+    auto &model = as<const HistogramDataModel>(data);
+    double num_groups = 1;
+    for (auto expr : groups) {
+        auto d = cast<const ast::Designator>(expr);
+        auto column = d ? get_column(*d) : nullptr;
+        num_groups *= column ? column->num_distinct() : model.size * DEFAULT_SELECTIVITY;
+    }
+    return std::make_unique<HistogramDataModel>(model.subproblem, std::min(model.size, num_groups));
+}
+
+std::unique_ptr<DataModel> HistogramCardinalityEstimator::estimate_join(const QueryGraph &G, const DataModel &left,
+                                                                        const DataModel &right,
+                                                                        const cnf::CNF &condition) const
+{
+    auto &L = as<const HistogramDataModel>(left);
+    auto &R = as<const HistogramDataModel>(right);
+
+    double sel = 1;
+    if (condition.empty()) {
+        /* No condition given, join on all predicates between the inputs. */
+        const uint64_t l = uint64_t(L.subproblem), r = uint64_t(R.subproblem);
+        for (auto join : G.joins()) {
+            uint64_t sources = 0;
+            for (auto ds : join->sources())
+                sources |= 1UL << ds->id();
+            if ((sources & l) and (sources & r) and (sources & ~(l | r)) == 0)
+                sel *= selectivity(join->condition());
+        }
+    } else {
+        sel = selectivity(condition);
+    }
+    return std::make_unique<HistogramDataModel>(L.subproblem | R.subproblem, L.size * R.size * sel);
+}
+
+std::size_t HistogramCardinalityEstimator::predict_cardinality(const DataModel &data) const
+{
+    return std::llround(as<const HistogramDataModel>(data).size);
+}
+
+void HistogramCardinalityEstimator::print(std::ostream &out) const
+{
+    out << "HistogramCardinalityEstimator with statistics of " << statistics_.size() << " tables";
+}
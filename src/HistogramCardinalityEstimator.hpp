@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ColumnStatistics.hpp"
+#include <map>
+#include <mutable/mutable.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/** A `CardinalityEstimator` that estimates from per-column statistics, i.e. equi-depth histograms and HyperLogLog
+ * sketches, collected when the data is loaded.  Join sizes are estimated under the independence assumption as the
+ * product of the input sizes and the selectivities of all join predicates between the inputs.  The selectivities of
+ * equi-join predicates between two columns are memoized per pair of columns, so that estimating joins in the join-order
+ * DP does not repeatedly estimate from the histograms.  They depend only on the statistics and thus remain valid across
+ * queries. */
+struct HistogramCardinalityEstimator : m::CardinalityEstimator
+{
+    using Subproblem = m::SmallBitset;
+
+    struct HistogramDataModel : m::DataModel
+    {
+        Subproblem subproblem;
+        double size;
+
+        HistogramDataModel(Subproblem subproblem, double size) : subproblem(subproblem), size(size) { }
+    };
+
+    ///> selectivity of a predicate that cannot be estimated from statistics, as in System R
+    static constexpr double DEFAULT_SELECTIVITY = 1. / 3;
+    ///> selectivity of an equality predicate that cannot be estimated from statistics, as in System R
+    static constexpr double DEFAULT_EQUALITY_SELECTIVITY = 1. / 10;
+
+    private:
+    struct TableStatistics
+    {
+        double num_rows = 0;
+        std::vector<ColumnStatistics> columns;
+    };
+
+    std::unordered_map<const m::Table*, TableStatistics> statistics_;
+    ///> memoized selectivities of equi-joins between two columns, the column with the lower address first
+    mutable std::map<std::pair<const ColumnStatistics*, const ColumnStatistics*>, double> join_selectivities_;
+
+    public:
+    /** Collects the statistics of all columns of table \p table by scanning it once.  Must be called after loading the
+     * table's data and before optimizing queries on the table. */
+    void add_statistics(m::Diagnostic &diag, const m::Table &table);
+
+    /** Returns `true` iff statistics of \p table were collected. */
+    bool has_statistics(const m::Table &table) const { return statistics_.contains(&table); }
+
+    std::unique_ptr<m::DataModel> empty_model() const override;
+    std::unique_ptr<m::DataModel> estimate_scan(const m::QueryGraph &G, Subproblem P) const override;
+    std::unique_ptr<m::DataModel> estimate_filter(const m::QueryGraph &G, const m::DataModel &data,
+                                                  const m::cnf::CNF &filter) const override;
+    std::unique_ptr<m::DataModel> estimate_limit(const m::QueryGraph &G, const m::DataModel &data, std::size_t limit,
+                                                 std::size_t offset) const override;
+    std::unique_ptr<m::DataModel> estimate_grouping(const m::QueryGraph &G, const m::DataModel &data,
+                                                    const std::vector<const m::ast::Expr*> &groups) const override;
+    std::unique_ptr<m::DataModel> estimate_join(const m::QueryGraph &G, const m::DataModel &left,
+                                                const m::DataModel &right,
+                                                const m::cnf::CNF &condition) const override;
+    std::size_t predict_cardinality(const m::DataModel &data) const override;
+    void print(std::ostream &out) const override;
+
+    private:
+    /** Returns the statistics of the column \p d refers to, or `nullptr` if there are none. */
+    const ColumnStatistics * get_column(const m::ast::Designator &d) const;
+
+    /** Returns the estimated selectivity of \p pred. */
+    double selectivity(const m::cnf::Predicate &pred) const;
+    /** Returns the estimated selectivity of \p cnf. */
+    double selectivity(const m::cnf::CNF &cnf) const;
+};
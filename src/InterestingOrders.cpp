@@ -0,0 +1,243 @@
+#include "InterestingOrders.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace m;
+
+
+double PhysicalCostModel::sort_cost(double num_tuples) const
+{
+    return sort * num_tuples * std::log2(std::max(num_tuples, 2.0));
+}
+
+bool ParetoSet::insert(const OrderedPlan &P, bool cheapest_only)
+{
+    if (cheapest_only) {
+        if (not plans.empty() and plans.front().cost <= P.cost)
+            return false;
+        plans.assign(1, P);
+        return true;
+    }
+
+    auto dominates = [](const OrderedPlan &a, const OrderedPlan &b) {
+        return a.cost <= b.cost and (a.order == b.order or b.order == NO_ORDER);
+    };
+
+    for (auto &plan : plans)
+        if (dominates(plan, P))
+            return false;
+    std::erase_if(plans, [&](const OrderedPlan &plan) { return dominates(P, plan); });
+    plans.push_back(P);
+    return true;
+}
+
+const OrderedPlan * ParetoSet::find(order_type order) const
+{
+    for (auto &plan : plans)
+        if (plan.order == order)
+            return &plan;
+    return nullptr;
+}
+
+const OrderedPlan & ParetoSet::cheapest() const
+{
+    M_insist(not plans.empty(), "no plan for this subproblem");
+    return *std::min_element(plans.begin(), plans.end(), [](auto &a, auto &b) { return a.cost < b.cost; });
+}
+
+namespace {
+
+/** Returns the attributes compared by \p pred if it is an equi-join predicate `A.x = B.y`. */
+bool get_equi_join_attributes(const cnf::Predicate &pred, std::string &lhs, std::string &rhs)
+{
+    if (pred.negative())
+        return false;
+    auto bin = cast<const ast::BinaryExpr>(&pred.expr());
+    if (not bin or bin->op().type != TK_EQUAL)
+        return false;
+    auto l = cast<const ast::Designator>(bin->lhs.get());
+    auto r = cast<const ast::Designator>(bin->rhs.get());
+    if (not l or not r)
+        return false;
+    lhs = std::string(l->table_name.text) + '.' + l->attr_name.text;
+    rhs = std::string(r->table_name.text) + '.' + r->attr_name.text;
+    return true;
+}
+
+}
+
+InterestingOrderTable::InterestingOrderTable(const QueryGraph &G, const PhysicalCostModel &cost_model,
+                                             bool cheapest_only)
+    : cost_model_(cost_model)
+    , cheapest_only_(cheapest_only)
+{
+    /* Union-find over the attributes of equi-join predicates. */
+    std::unordered_map<std::string, std::size_t> attribute_ids;
+    std::vector<std::size_t> parent;
+    auto id_of = [&](const std::string &attr) {
+        auto [it, inserted] = attribute_ids.try_emplace(attr, parent.size());
+        if (inserted)
+            parent.push_back(parent.size());
+        return it->second;
+    };
+    auto find = [&](std::size_t x) {
+        while (parent[x] != x)
+            x = parent[x] = parent[parent[x]];
+        return x;
+    };
+
+    std::vector<std::pair<uint64_t, std::size_t>> equi_joins; // join sources and one of their attributes
+    for (auto join : G.joins()) {
+        uint64_t sources = 0;
+        for (auto ds : join->sources())
+            sources |= 1UL << ds->id();
+
+        std::string lhs, rhs;
+        bool found = false;
+        for (auto &clause : join->condition()) {
+            if (clause.size() == 1 and get_equi_join_attributes(clause[0], lhs, rhs)) {
+                found = true;
+                break;
+            }
+        }
+        if (not found) {
+            edges_.push_back(JoinEdge{ sources, NO_ORDER });
+            continue;
+        }
+
+        const std::size_t l = id_of(lhs), r = id_of(rhs);
+        parent[find(l)] = find(r);
+        equi_joins.emplace_back(sources, l);
+    }
+
+    /* Number the equivalence classes densely. */
+    std::unordered_map<std::size_t, order_type> class_ids;
+    for (auto [sources, attr] : equi_joins) {
+        auto [it, _] = class_ids.try_emplace(find(attr), class_ids.size());
+        edges_.push_back(JoinEdge{ sources, it->second });
+    }
+}
+
+bool InterestingOrderTable::is_interesting(order_type order, Subproblem S) const
+{
+    if (order == NO_ORDER)
+        return false;
+    const uint64_t s = uint64_t(S);
+    for (auto &e : edges_) {
+        if (e.order == order and (e.sources & s) and (e.sources & ~s))
+            return true;
+    }
+    return false;
+}
+
+template<typename PlanTable>
+void InterestingOrderTable::init(PlanTable &PT, const CardinalityEstimator &CE)
+{
+    for (std::size_t i = 0; i != PT.num_sources(); ++i) {
+        const Subproblem S(1UL << i);
+        auto &set = operator[](S);
+        set.cardinality = CE.predict_cardinality(*PT[S].model);
+
+        set.insert(OrderedPlan{ Subproblem(), Subproblem(), 0, NO_ORDER, NO_ORDER, NO_ORDER, PhysicalOperator::Scan },
+                   cheapest_only_);
+        for (auto &e : edges_) {
+            if ((e.sources >> i & 1) and is_interesting(e.order, S) and not set.find(e.order)) {
+                const double cost = cost_model_.index_scan * set.cardinality;
+                set.insert(OrderedPlan{ Subproblem(), Subproblem(), cost, e.order, NO_ORDER, NO_ORDER,
+                                        PhysicalOperator::IndexScan }, cheapest_only_);
+            }
+        }
+    }
+}
+
+template<typename PlanTable>
+void InterestingOrderTable::update(PlanTable &PT, const CardinalityEstimator &CE, Subproblem left, Subproblem right)
+{
+    const Subproblem S = left | right;
+    auto &set = operator[](S);
+    if (set.plans.empty())
+        set.cardinality = CE.predict_cardinality(*PT[S].model);
+
+    const ParetoSet &L = at(left);
+    const ParetoSet &R = at(right);
+
+    /* Keep the order of an input only while it may still be exploited by a merge join. */
+    auto result_order = [&](order_type order) { return is_interesting(order, S) ? order : NO_ORDER; };
+
+    /* Orders a merge join of `left` and `right` can be performed on. */
+    std::vector<order_type> merge_orders;
+    for (auto &e : edges_) {
+        if (e.order != NO_ORDER and (e.sources & uint64_t(left)) and (e.sources & uint64_t(right)) and
+            (e.sources & ~uint64_t(S)) == 0)
+            merge_orders.push_back(e.order);
+    }
+
+    const bool build_left = L.cardinality < R.cardinality;
+    const double build_size = build_left ? L.cardinality : R.cardinality;
+    const double probe_size = build_left ? R.cardinality : L.cardinality;
+    const double hash_cost = set.cardinality + cost_model_.hash_build * build_size + cost_model_.hash_probe * probe_size;
+    const double merge_cost = set.cardinality + cost_model_.merge * (L.cardinality + R.cardinality);
+
+    for (auto &pl : L.plans) {
+        for (auto &pr : R.plans) {
+            const double inputs = pl.cost + pr.cost;
+
+            /* Hash join, pipelining the order of the probe side. */
+            const order_type probe_order = build_left ? pr.order : pl.order;
+            set.insert(OrderedPlan{ left, right, inputs + hash_cost, result_order(probe_order), pl.order, pr.order,
+                                    PhysicalOperator::HashJoin }, cheapest_only_);
+
+            /* Sort-merge joins, sorting only the inputs that are not already sorted. */
+            for (order_type o : merge_orders) {
+                double cost = inputs + merge_cost;
+                if (pl.order != o) cost += cost_model_.sort_cost(L.cardinality);
+                if (pr.order != o) cost += cost_model_.sort_cost(R.cardinality);
+                set.insert(OrderedPlan{ left, right, cost, result_order(o), pl.order, pr.order,
+                                        PhysicalOperator::SortMergeJoin }, cheapest_only_);
+            }
+        }
+    }
+}
+
+template<typename PlanTable>
+double InterestingOrderTable::apply(PlanTable &PT, const QueryGraph &G, const CardinalityEstimator &CE,
+                                    const CostFunction &CF, const JoinPredicates &predicates) const
+{
+    const Subproblem All((1UL << PT.num_sources()) - 1);
+    auto it = table_.find(uint64_t(All));
+    if (it == table_.end() or it->second.plans.empty())
+        return 0;
+    const OrderedPlan &best = it->second.cheapest();
+    apply(PT, G, CE, CF, predicates, All, best.order);
+    return best.cost;
+}
+
+template<typename PlanTable>
+void InterestingOrderTable::apply(PlanTable &PT, const QueryGraph &G, const CardinalityEstimator &CE,
+                                  const CostFunction &CF, const JoinPredicates &predicates, Subproblem S,
+                                  order_type order) const
+{
+    const OrderedPlan *P = at(S).find(order);
+    M_insist(P, "plan of the requested order must exist");
+    if (not uint64_t(P->left))
+        return; // plan of a single source
+
+    apply(PT, G, CE, CF, predicates, P->left, P->left_order);
+    apply(PT, G, CE, CF, predicates, P->right, P->right_order);
+
+    /* Force the logical plan table to use this join, recomputing its cost with the cost function in use. */
+    PT[S].cost = std::numeric_limits<double>::infinity();
+    PT.update(G, CE, CF, P->left, P->right, predicates.between(P->left, P->right));
+}
+
+#define INSTANTIATE(PLAN_TABLE) \
+    template void InterestingOrderTable::init<PLAN_TABLE>(PLAN_TABLE &, const CardinalityEstimator &); \
+    template void InterestingOrderTable::update<PLAN_TABLE>(PLAN_TABLE &, const CardinalityEstimator &, Subproblem, \
+                                                            Subproblem); \
+    template double InterestingOrderTable::apply<PLAN_TABLE>(PLAN_TABLE &, const QueryGraph &, \
+                                                             const CardinalityEstimator &, const CostFunction &, \
+                                                             const JoinPredicates &) const;
+INSTANTIATE(PlanTableSmallOrDense)
+INSTANTIATE(PlanTableLargeAndSparse)
+#undef INSTANTIATE
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "JoinPredicates.hpp"
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <unordered_map>
+#include <vector>
+
+
+/** Identifies a sort order by the equivalence class of join attributes the data is sorted on. */
+using order_type = int32_t;
+///> the data is not sorted on any join attribute
+constexpr order_type NO_ORDER = -1;
+
+/** Per-tuple cost parameters of the physical operators considered by order-aware enumeration.  Like C_out, all costs
+ * are measured in tuples, so the cost of a plan is the cost of its result plus the work of its operators. */
+struct PhysicalCostModel
+{
+    double hash_build = 2.0; ///< per tuple inserted into a hash table
+    double hash_probe = 1.0; ///< per tuple probed against a hash table
+    double merge = 1.0; ///< per input tuple of a merge join
+    double sort = 1.0; ///< per tuple and level of a comparison sort
+    double index_scan = 0.5; ///< per tuple read in order from a B+-tree index instead of a full scan
+
+    double sort_cost(double num_tuples) const;
+};
+
+enum class PhysicalOperator : uint8_t { Scan, IndexScan, HashJoin, SortMergeJoin };
+
+/** A physical plan for a subproblem.  The plans for its inputs are identified by the order they produce. */
+struct OrderedPlan
+{
+    m::SmallBitset left;
+    m::SmallBitset right;
+    double cost;
+    order_type order; ///< the order the result is sorted on
+    order_type left_order; ///< the order of the plan chosen for `left`
+    order_type right_order; ///< the order of the plan chosen for `right`
+    PhysicalOperator op;
+};
+
+/** A small Pareto set of plans for one subproblem, holding at most one plan per order.  A plan is dominated by a
+ * cheaper plan with the same order, and an unordered plan is dominated by any cheaper ordered plan. */
+struct ParetoSet
+{
+    std::vector<OrderedPlan> plans;
+    double cardinality = 0;
+
+    /** Inserts plan \p P unless it is dominated and evicts all plans dominated by \p P.  Returns `true` iff \p P was
+     * inserted.  If \p cheapest_only is set, only the cheapest plan regardless of its order is kept. */
+    bool insert(const OrderedPlan &P, bool cheapest_only);
+
+    /** Returns the plan producing \p order, or `nullptr` if there is none. */
+    const OrderedPlan * find(order_type order) const;
+
+    /** Returns the cheapest plan of this set. */
+    const OrderedPlan & cheapest() const;
+};
+
+/** Tracks a `ParetoSet` of physical plans per subproblem next to the logical plan table.  Sort orders are equivalence
+ * classes of the attributes compared by equi-join predicates, e.g. `T0.fid_T1`, `T1.id`, and `T2.fid_T1` in
+ * `T0.fid_T1 = T1.id AND T2.fid_T1 = T1.id`.  Only orders on attributes of not yet processed join edges are
+ * *interesting* and kept. */
+struct InterestingOrderTable
+{
+    using Subproblem = m::SmallBitset;
+
+    private:
+    struct JoinEdge
+    {
+        uint64_t sources;
+        order_type order; ///< the order a merge join along this edge produces and consumes, or `NO_ORDER`
+    };
+
+    const PhysicalCostModel &cost_model_;
+    bool cheapest_only_;
+    std::vector<JoinEdge> edges_;
+    std::unordered_map<uint64_t, ParetoSet> table_;
+
+    public:
+    InterestingOrderTable(const m::QueryGraph &G, const PhysicalCostModel &cost_model, bool cheapest_only);
+
+    ParetoSet & operator[](Subproblem S) { return table_[uint64_t(S)]; }
+    const ParetoSet & at(Subproblem S) const { return table_.at(uint64_t(S)); }
+
+    /** Fills the table for the single data sources of \p PT, offering a full scan and an index scan per interesting
+     * order of each source. */
+    template<typename PlanTable>
+    void init(PlanTable &PT, const m::CardinalityEstimator &CE);
+
+    /** Considers all physical joins of the Pareto sets of \p left and \p right.  `PT[left|right]` must have a model. */
+    template<typename PlanTable>
+    void update(PlanTable &PT, const m::CardinalityEstimator &CE, Subproblem left, Subproblem right);
+
+    /** Makes \p PT describe the cheapest physical plan for all sources by re-joining its subproblems bottom up.
+     * Returns the cost of that plan under the physical cost model. */
+    template<typename PlanTable>
+    double apply(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE, const m::CostFunction &CF,
+                 const JoinPredicates &predicates) const;
+
+    private:
+    /** Returns `true` iff a join edge with \p order connects \p S to a source outside of \p S. */
+    bool is_interesting(order_type order, Subproblem S) const;
+
+    template<typename PlanTable>
+    void apply(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE, const m::CostFunction &CF,
+               const JoinPredicates &predicates, Subproblem S, order_type order) const;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+
+/** A hash table mapping 32 bit join keys to 32 bit payloads, e.g. row ids, for the build side of a hash join.  Keys
+ * may occur multiple times.
+ *
+ * Entries are stored in buckets of 8 keys followed by their 8 payloads, i.e. exactly one cache line per bucket, so a
+ * probe usually touches a single cache line and compares all keys of a bucket with one SIMD comparison.  A full bucket
+ * overflows into the next bucket, hence a probe continues until it reaches a bucket that is not full. */
+struct JoinHashTable
+{
+    static constexpr std::size_t BUCKET_SIZE = 8;
+    ///> the number of probes whose buckets are prefetched before the first of them is processed
+    static constexpr std::size_t PREFETCH_DISTANCE = 16;
+
+    struct alignas(64) Bucket
+    {
+        int32_t keys[BUCKET_SIZE];
+        uint32_t payloads[BUCKET_SIZE];
+    };
+    static_assert(sizeof(Bucket) == 64, "a bucket must fill exactly one cache line");
+
+    private:
+    std::unique_ptr<Bucket[]> buckets_;
+    std::unique_ptr<uint8_t[]> fill_; ///< the number of entries per bucket
+    uint64_t mask_; ///< the number of buckets minus one
+    std::size_t size_ = 0;
+
+    public:
+    /** Creates a table for \p capacity entries, filled to at most half of its slots. */
+    explicit JoinHashTable(std::size_t capacity)
+    {
+        const std::size_t num_buckets = num_buckets_for(capacity);
+        buckets_ = std::make_unique<Bucket[]>(num_buckets);
+        fill_ = std::make_unique<uint8_t[]>(num_buckets);
+        std::fill_n(fill_.get(), num_buckets, 0);
+        mask_ = num_buckets - 1;
+    }
+
+    static std::size_t num_buckets_for(std::size_t capacity)
+    {
+        return std::bit_ceil(std::max<std::size_t>(1, 2 * capacity / BUCKET_SIZE));
+    }
+    /** Returns the number of bytes occupied by a table for \p capacity entries. */
+    static std::size_t bytes_for(std::size_t capacity) { return num_buckets_for(capacity) * (sizeof(Bucket) + 1); }
+
+    std::size_t size() const { return size_; }
+    std::size_t num_buckets() const { return mask_ + 1; }
+
+    static uint64_t hash(int32_t key)
+    {
+        uint64_t h = uint32_t(key) * 0x9e3779b97f4a7c15UL;
+        return h ^ (h >> 32);
+    }
+
+    void insert(int32_t key, uint32_t payload)
+    {
+        for (uint64_t b = hash(key) & mask_; ; b = (b + 1) & mask_) {
+            if (fill_[b] != BUCKET_SIZE) {
+                buckets_[b].keys[fill_[b]] = key;
+                buckets_[b].payloads[fill_[b]] = payload;
+                ++fill_[b];
+                ++size_;
+                return;
+            }
+        }
+    }
+
+    /** Invokes \p fn with the payload of every entry with \p key. */
+    template<typename Fn>
+    void find(int32_t key, Fn &&fn) const { find_from(key, hash(key) & mask_, fn); }
+
+    /** Probes the table with all \p keys and invokes \p fn with the index of the probing key and the payload of every
+     * matching entry.  The buckets of the next probes are prefetched while the current probe is processed. */
+    template<typename Fn>
+    void probe(const int32_t *keys, std::size_t num_keys, Fn &&fn) const
+    {
+        uint64_t homes[PREFETCH_DISTANCE];
+        const std::size_t warmup = std::min(num_keys, PREFETCH_DISTANCE);
+        for (std::size_t i = 0; i != warmup; ++i) {
+            homes[i] = hash(keys[i]) & mask_;
+            __builtin_prefetch(&buckets_[homes[i]]);
+        }
+        for (std::size_t i = 0; i != num_keys; ++i) {
+            const uint64_t home = homes[i % PREFETCH_DISTANCE];
+            if (const std::size_t ahead = i + PREFETCH_DISTANCE; ahead < num_keys) {
+                homes[ahead % PREFETCH_DISTANCE] = hash(keys[ahead]) & mask_;
+                __builtin_prefetch(&buckets_[homes[ahead % PREFETCH_DISTANCE]]);
+            }
+            find_from(keys[i], home, [&](uint32_t payload) { fn(i, payload); });
+        }
+    }
+
+    private:
+    /** Invokes \p fn with the payload of every entry with \p key, starting the search at bucket \p b. */
+    template<typename Fn>
+    void find_from(int32_t key, uint64_t b, Fn &&fn) const
+    {
+        for (;; b = (b + 1) & mask_) {
+            const Bucket &bucket = buckets_[b];
+            const unsigned fill = fill_[b];
+            uint32_t matches = match(bucket, key) & ((1U << fill) - 1);
+            for (; matches; matches &= matches - 1)
+                fn(bucket.payloads[std::countr_zero(matches)]);
+            if (fill != BUCKET_SIZE)
+                return;
+        }
+    }
+
+    /** Returns a bit mask of the slots of \p bucket holding \p key. */
+    static uint32_t match(const Bucket &bucket, int32_t key)
+    {
+#ifdef __AVX2__
+        const __m256i keys = _mm256_load_si256(reinterpret_cast<const __m256i*>(bucket.keys));
+        const __m256i eq = _mm256_cmpeq_epi32(keys, _mm256_set1_epi32(key));
+        return _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+#else
+        uint32_t mask = 0;
+        for (std::size_t i = 0; i != BUCKET_SIZE; ++i)
+            mask |= uint32_t(bucket.keys[i] == key) << i;
+        return mask;
+#endif
+    }
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <mutable/mutable.hpp>
+#include <unordered_map>
+#include <vector>
+
+
+/** The join conditions of a query graph, indexed by the data sources they join, to quickly find the condition joining
+ * two subproblems during enumeration.  Conditions are never built in the inner loop of enumeration: a single join's
+ * condition is returned as is, the conjunction of several joins' conditions is built once per set of joins. */
+struct JoinPredicates
+{
+    private:
+    struct Edge
+    {
+        uint64_t sources; ///< the data sources joined by `condition`
+        const m::cnf::CNF *condition;
+
+        bool joins(uint64_t left, uint64_t right) const {
+            return (sources & left) and (sources & right) and not (sources & ~(left | right));
+        }
+    };
+
+    std::vector<Edge> edges_;
+    std::vector<uint64_t> incident_; ///< per data source, the mask of the edges joining it, if there are at most 64
+    const m::cnf::CNF empty_;
+    ///> the conjunctions of the conditions of two or more edges, by mask of edges
+    mutable std::unordered_map<uint64_t, m::cnf::CNF> conjunctions_;
+    ///> the conjunctions of the conditions of two or more edges, by indices of edges, if there are more than 64 edges
+    mutable std::map<std::vector<std::size_t>, m::cnf::CNF> large_conjunctions_;
+    mutable std::vector<std::size_t> joining_; ///< the edges joining the sides of the last call, if more than 64 edges
+
+    public:
+    explicit JoinPredicates(const m::QueryGraph &G)
+    {
+        for (auto join : G.joins()) {
+            uint64_t sources = 0;
+            for (auto ds : join->sources())
+                sources |= 1UL << ds->id();
+            edges_.push_back(Edge{ sources, &join->condition() });
+        }
+
+        if (edges_.size() <= 64) {
+            incident_.assign(G.num_sources(), 0);
+            for (std::size_t e = 0; e != edges_.size(); ++e) {
+                for (uint64_t x = edges_[e].sources; x; x &= x - 1)
+                    incident_[std::countr_zero(x)] |= 1UL << e;
+            }
+        }
+    }
+
+    /** Returns the conjunction of the conditions of all joins between \p left and \p right.  The condition lives as
+     * long as this object. */
+    const m::cnf::CNF & between(uint64_t left, uint64_t right) const
+    {
+        if (incident_.empty()) {
+            joining_.clear();
+            for (std::size_t e = 0; e != edges_.size(); ++e) {
+                if (edges_[e].joins(left, right))
+                    joining_.push_back(e);
+            }
+            if (joining_.size() <= 1)
+                return joining_.empty() ? empty_ : *edges_[joining_.front()].condition;
+            auto it = large_conjunctions_.find(joining_);
+            if (it == large_conjunctions_.end())
+                it = large_conjunctions_.emplace(joining_, conjunction(joining_)).first;
+            return it->second;
+        }
+
+        /* Only edges incident to the smaller side can join both sides. */
+        const uint64_t smaller = std::popcount(left) <= std::popcount(right) ? left : right;
+        uint64_t candidates = 0;
+        for (uint64_t x = smaller; x; x &= x - 1)
+            candidates |= incident_[std::countr_zero(x)];
+        uint64_t joining = 0;
+        for (; candidates; candidates &= candidates - 1) {
+            if (edges_[std::countr_zero(candidates)].joins(left, right))
+                joining |= candidates & -candidates;
+        }
+        if (not joining or std::has_single_bit(joining))
+            return joining ? *edges_[std::countr_zero(joining)].condition : empty_;
+        auto [it, inserted] = conjunctions_.try_emplace(joining);
+        if (inserted) {
+            std::vector<std::size_t> edges;
+            for (uint64_t x = joining; x; x &= x - 1)
+                edges.push_back(std::countr_zero(x));
+            it->second = conjunction(edges);
+        }
+        return it->second;
+    }
+
+    const m::cnf::CNF & between(m::SmallBitset left, m::SmallBitset right) const
+    {
+        return between(uint64_t(left), uint64_t(right));
+    }
+
+    private:
+    /** Returns the conjunction of the conditions of \p edges. */
+    m::cnf::CNF conjunction(const std::vector<std::size_t> &edges) const
+    {
+        m::cnf::CNF condition = *edges_[edges.front()].condition;
+        for (auto it = std::next(edges.begin()); it != edges.end(); ++it)
+            condition = condition && *edges_[*it].condition;
+        return condition;
+    }
+};
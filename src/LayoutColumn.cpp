@@ -0,0 +1,54 @@
+#include "LayoutColumn.hpp"
+#include <cstring>
+
+using namespace m;
+using namespace m::storage;
+
+
+LayoutColumn LayoutColumn::Of(const Table &table, const Attribute &attr)
+{
+    M_insist(attr.type->is_character_sequence() or attr.type->is_integral(),
+             "only character sequences and integers are supported");
+    const DataLayout &layout = table.layout();
+    auto block = cast<const DataLayout::INode>(&layout.child());
+    M_insist(block, "the layout must be a sequence of blocks");
+
+    LayoutColumn column;
+    bool found = false;
+    for (std::size_t i = 0; i != block->num_children(); ++i) {
+        auto &child = block->at(i);
+        auto leaf = cast<const DataLayout::Leaf>(child.ptr.get());
+        if (not leaf)
+            continue;
+        if (leaf->index() == table.num_attrs()) { // the NULL bitmap, with one bit per attribute
+            column.has_null_bitmap = true;
+            column.null_bit_offset = child.offset_in_bits + attr.id;
+            column.null_bitmap_stride = child.stride_in_bits;
+            continue;
+        }
+        if (leaf->index() != attr.id)
+            continue;
+        M_insist(child.offset_in_bits % 8 == 0 and child.stride_in_bits % 8 == 0, "values must be byte-aligned");
+
+        column.data = table.store().memory().as<const uint8_t*>();
+        column.tuples_per_block = block->num_tuples();
+        column.block_stride = layout.stride_in_bits() / 8;
+        column.offset = child.offset_in_bits / 8;
+        column.stride = child.stride_in_bits / 8;
+        column.size = attr.type->size() / 8;
+        column.is_character_sequence = attr.type->is_character_sequence();
+        found = true;
+    }
+    if (not found)
+        M_unreachable("the attribute is not part of the table's layout");
+    return column;
+}
+
+LayoutColumn LayoutColumn::Of(const Table &table, const char *name)
+{
+    for (std::size_t i = 0; i != table.num_attrs(); ++i) {
+        if (std::strcmp(table[i].name, name) == 0)
+            return Of(table, table[i]);
+    }
+    M_unreachable("no such attribute");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutable/mutable.hpp>
+
+
+/** The values of one attribute in the memory of a table's store, located by the table's `DataLayout`.  The layout
+ * must be a sequence of blocks of one or more tuples, each block storing every attribute at a fixed offset and with a
+ * fixed stride, as the row and PAX layouts do. */
+struct LayoutColumn
+{
+    const uint8_t *data = nullptr; ///< the start of the store's memory
+    std::size_t tuples_per_block = 1;
+    std::size_t block_stride = 0; ///< the size of a block in bytes
+    std::size_t offset = 0; ///< the offset of the attribute's first value in a block, in bytes
+    std::size_t stride = 0; ///< the distance between values of consecutive tuples of a block, in bytes
+    std::size_t size = 0; ///< the size of a value in bytes
+    bool is_character_sequence = false; ///< whether values are NUL-padded strings rather than integers
+    bool has_null_bitmap = false; ///< whether the layout stores a NULL bitmap per tuple
+    std::size_t null_bit_offset = 0; ///< the offset of the attribute's bit in the first NULL bitmap of a block, in bits
+    std::size_t null_bitmap_stride = 0; ///< the distance between NULL bitmaps of consecutive tuples, in bits
+
+    /** Locates \p attr, a character sequence or integral attribute, in the store of \p table. */
+    static LayoutColumn Of(const m::Table &table, const m::Attribute &attr);
+    /** Locates the attribute named \p name in the store of \p table. */
+    static LayoutColumn Of(const m::Table &table, const char *name);
+
+    const uint8_t * at(std::size_t row) const {
+        return data + (row / tuples_per_block) * block_stride + offset + (row % tuples_per_block) * stride;
+    }
+
+    /** Returns whether the value of \p row is NULL.  mutable sets the bit of a value that is present. */
+    bool is_null(std::size_t row) const {
+        if (not has_null_bitmap)
+            return false;
+        const std::size_t bit = null_bit_offset + (row % tuples_per_block) * null_bitmap_stride;
+        const uint8_t *block = data + (row / tuples_per_block) * block_stride;
+        return not (block[bit / 8] >> (bit % 8) & 1U);
+    }
+};
+
+/** Returns the signed integer of \p size bytes at \p p. */
+inline int64_t load_integer(const uint8_t *p, std::size_t size)
+{
+    switch (size) {
+        case 1: { int8_t v;  std::memcpy(&v, p, sizeof(v)); return v; }
+        case 2: { int16_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case 4: { int32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        case 8: { int64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+        default: M_unreachable("unsupported integer size");
+    }
+}
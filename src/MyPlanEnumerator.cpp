@@ -1,5 +1,13 @@
 #include "MyPlanEnumerator.hpp"
-#include<unordered_set>
+#include "JoinPredicates.hpp"
+#include "QuerySimplification.hpp"
+#include "SmallQueryDP.hpp"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <unordered_set>
 
 using namespace m;
 
@@ -50,16 +58,75 @@ m::SmallBitset get_bitset(std::vector<uint64_t> relations) {
     return m::SmallBitset(bitset);
 }
 
+/** Joins the connected components of \p U, whose plans must already be in \p PT, by cross products in ascending
+ * order of their cardinality, which keeps the intermediate results of the cross products smallest. */
+template <typename PlanTable>
+void join_components(PlanTable &PT, const QueryGraph &G, const UnitGraph &U, const std::vector<uint64_t> &components,
+                     const CardinalityEstimator &CE, const CostFunction &CF)
+{
+    std::vector<std::pair<double, uint64_t>> sizes;
+    for (uint64_t C : components) {
+        const uint64_t sources = U.sources(C);
+        sizes.emplace_back(CE.predict_cardinality(*PT[SmallBitset(sources)].model), sources);
+    }
+    std::sort(sizes.begin(), sizes.end());
+    uint64_t joined = sizes.front().second;
+    for (auto it = std::next(sizes.begin()); it != sizes.end(); ++it) {
+        auto &entry = PT[SmallBitset(joined | it->second)];
+        entry.model.reset();
+        entry.cost = std::numeric_limits<double>::infinity();
+        PT.update(G, CE, CF, SmallBitset(joined), SmallBitset(it->second), cnf::CNF()); // cross product
+        joined |= it->second;
+    }
+}
+
 template <typename PlanTable>
 void MyPlanEnumerator::operator()(enumerate_tag, PlanTable &PT, const QueryGraph &G, const CostFunction &CF) const
 {
     const AdjacencyMatrix &M = G.adjacency_matrix();
-    auto &CE = Catalog::Get().get_database_in_use().cardinality_estimator();
-    cnf::CNF condition; // Use this as join condition for PT.update(); we have fake cardinalities, so the condition
-                        // doesn't matter.
+    auto &CE = cardinality_estimator ? *cardinality_estimator
+                                     : Catalog::Get().get_database_in_use().cardinality_estimator();
+    const JoinPredicates predicates(G); // the join conditions to pass to PT.update()
 
     uint64_t num_relations = PT.num_sources();
 
+    /* Disconnected graphs are enumerated by DPccp, which considers only connected subproblems and thus optimizes
+     * every connected component on its own.  The components are then combined by cross products. */
+    if (num_relations > 1) {
+        const UnitGraph U(G);
+        if (auto components = U.components(); components.size() > 1) {
+            enumerate_units(PT, G, U, CE, CF);
+            join_components(PT, G, U, components, CE, CF);
+            return;
+        }
+    }
+
+    /* With a memory budget, plans are enumerated in a bounded table and only the final plan is kept. */
+    if (plan_table_budget and order_tracking == OrderTracking::Off and dynamic_cast<const CostFunctionCout*>(&CF)) {
+        bounded_result = enumerate_bounded(PT, G, CE, CF, plan_table_budget);
+        return;
+    }
+
+    /* Queries with too many csg-cmp pairs are simplified and then enumerated exactly over the remaining units. */
+    if (simplification_budget and order_tracking == OrderTracking::Off and
+        UnitGraph(G).count_ccps(simplification_budget) > simplification_budget)
+    {
+        const UnitGraph U = simplify_query_graph(PT, G, CE, CF, simplification_budget);
+        enumerate_units(PT, G, U, CE, CF);
+        return;
+    }
+
+    /* Small queries are optimized by a kernel specialized for their number of relations. */
+    if (specialize_small_queries and order_tracking == OrderTracking::Off and
+        dynamic_cast<const CostFunctionCout*>(&CF) and enumerate_small_query(PT, G, CE))
+        return;
+
+    std::optional<InterestingOrderTable> orders;
+    if (order_tracking != OrderTracking::Off) {
+        orders.emplace(G, physical_cost_model, order_tracking == OrderTracking::CheapestOnly);
+        orders->init(PT, CE);
+    }
+
     // std::cout << M << std::endl;
 
     std::vector<uint64_t> relations;
@@ -88,7 +155,9 @@ void MyPlanEnumerator::operator()(enumerate_tag, PlanTable &PT, const QueryGraph
                     if(M.is_connected(left, right)){
                         // std::cout << left << "\t" << right << std::endl;
 
-                        PT.update(G, CE, CF, left, right, condition);
+                        PT.update(G, CE, CF, left, right, predicates.between(left, right));
+                        if (orders)
+                            orders->update(PT, CE, left, right);
                         left |= right;
                         // vis.insert(left);
                     }
@@ -97,8 +166,102 @@ void MyPlanEnumerator::operator()(enumerate_tag, PlanTable &PT, const QueryGraph
         }while(it.advance());
     }
 
+    /* Replace the plan chosen by the cost function by the cheapest physical plan. */
+    if (orders)
+        physical_cost = orders->apply(PT, G, CE, CF, predicates);
+
     // TODO 3: Implement algorithm for plan enumeration (join ordering).
 }
 
+template <typename PlanTable>
+void MyPlanEnumerator::reoptimize(PlanTable &PT, const QueryGraph &G, const CostFunction &CF,
+                                  const std::vector<SmallBitset> &changed) const
+{
+    const AdjacencyMatrix &M = G.adjacency_matrix();
+    auto &CE = cardinality_estimator ? *cardinality_estimator
+                                     : Catalog::Get().get_database_in_use().cardinality_estimator();
+    const JoinPredicates predicates(G);
+
+    const uint64_t all = (1UL << PT.num_sources()) - 1;
+
+    /* Collect the subproblems with a plan that contain a changed subproblem. */
+    std::unordered_set<uint64_t> affected;
+    for (SmallBitset C : changed) {
+        const uint64_t c = uint64_t(C);
+        const uint64_t rest = all & ~c;
+        uint64_t x = 0;
+        do {
+            if (PT.has_plan(SmallBitset(c | x)))
+                affected.insert(c | x);
+            x = (x - rest) & rest; // next subset of `rest`
+        } while (x);
+    }
+
+    /* Re-optimize the affected subproblems bottom up, so that all subplans are final when they are joined. */
+    std::vector<uint64_t> order(affected.begin(), affected.end());
+    std::sort(order.begin(), order.end(), [](uint64_t a, uint64_t b) {
+        return std::popcount(a) < std::popcount(b) or (std::popcount(a) == std::popcount(b) and a < b);
+    });
+
+    for (uint64_t s : order) {
+        const SmallBitset S(s);
+        auto &entry = PT[S];
+
+        if (std::has_single_bit(s)) {
+            /* Re-estimate the (filtered) scan of a single data source. */
+            entry.model = CE.estimate_scan(G, S);
+            auto &filter = G.sources()[std::countr_zero(s)]->filter();
+            if (not filter.empty())
+                entry.model = CE.estimate_filter(G, *entry.model, filter);
+            continue;
+        }
+
+        entry.model.reset();
+        entry.cost = std::numeric_limits<double>::infinity();
+        for (uint64_t l = (0 - s) & s; l != s; l = (l - s) & s) { // all non-empty proper subsets of `s`
+            const SmallBitset left(l), right(s & ~l);
+            if (PT.has_plan(left) and PT.has_plan(right) and M.is_connected(left, right))
+                PT.update(G, CE, CF, left, right, predicates.between(left, right));
+        }
+    }
+}
+
+template <typename PlanTable>
+void MyPlanEnumerator::replan(PlanTable &PT, const QueryGraph &G, const CostFunction &CF,
+                              const std::vector<SmallBitset> &finished) const
+{
+    auto &CE = cardinality_estimator ? *cardinality_estimator
+                                     : Catalog::Get().get_database_in_use().cardinality_estimator();
+
+    /* Collapse every finished subproblem into a single unit. */
+    UnitGraph U(G);
+    for (SmallBitset F : finished) {
+        for (;;) {
+            std::size_t u = U.size(), v = U.size();
+            for (std::size_t i = 0; i != U.size() and v == U.size(); ++i) {
+                if (U.sources_of(i) & ~uint64_t(F))
+                    continue; // not part of `F`
+                if (u == U.size())
+                    u = i;
+                else
+                    v = i;
+            }
+            if (v == U.size())
+                break;
+            U.merge(u, v);
+        }
+    }
+
+    enumerate_units(PT, G, U, CE, CF);
+    if (auto components = U.components(); components.size() > 1)
+        join_components(PT, G, U, components, CE, CF);
+}
+
 template void MyPlanEnumerator::operator()<PlanTableSmallOrDense &>(enumerate_tag, PlanTableSmallOrDense &, const QueryGraph &, const CostFunction &) const;
-template void MyPlanEnumerator::operator()<PlanTableLargeAndSparse &>(enumerate_tag, PlanTableLargeAndSparse &, const QueryGraph &, const CostFunction &) const;
\ No newline at end of file
+template void MyPlanEnumerator::operator()<PlanTableLargeAndSparse &>(enumerate_tag, PlanTableLargeAndSparse &, const QueryGraph &, const CostFunction &) const;
+
+template void MyPlanEnumerator::reoptimize<PlanTableSmallOrDense>(PlanTableSmallOrDense &, const QueryGraph &, const CostFunction &, const std::vector<SmallBitset> &) const;
+template void MyPlanEnumerator::reoptimize<PlanTableLargeAndSparse>(PlanTableLargeAndSparse &, const QueryGraph &, const CostFunction &, const std::vector<SmallBitset> &) const;
+
+template void MyPlanEnumerator::replan<PlanTableSmallOrDense>(PlanTableSmallOrDense &, const QueryGraph &, const CostFunction &, const std::vector<SmallBitset> &) const;
+template void MyPlanEnumerator::replan<PlanTableLargeAndSparse>(PlanTableLargeAndSparse &, const QueryGraph &, const CostFunction &, const std::vector<SmallBitset> &) const;
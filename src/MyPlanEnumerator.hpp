@@ -1,3 +1,7 @@
+#pragma once
+
+#include "BoundedPlanTable.hpp"
+#include "InterestingOrders.hpp"
 #include <mutable/mutable.hpp>
 
 
@@ -6,6 +10,52 @@ struct MyPlanEnumerator final : m::PlanEnumeratorCRTP<MyPlanEnumerator>
     using base_type = m::PlanEnumeratorCRTP<MyPlanEnumerator>;
     using base_type::operator();
 
+    /** How physical plans are tracked next to the logical plan table, see `InterestingOrderTable`. */
+    enum class OrderTracking
+    {
+        Off, ///< choose the plan by the cost function only
+        CheapestOnly, ///< choose the plan by the physical cost model, keeping one plan per subproblem
+        Pareto, ///< choose the plan by the physical cost model, keeping one plan per interesting order
+    };
+
+    ///> the estimator to use instead of the estimator of the database in use, if set
+    const m::CardinalityEstimator *cardinality_estimator = nullptr;
+
+    ///> the memory budget in bytes for plans of the C_out cost function; if set, plans are enumerated in a
+    ///> `BoundedPlanTable` and only the final plan is entered into the plan table, see `enumerate_bounded()`
+    std::size_t plan_table_budget = 0;
+    ///> the outcome of the last enumeration with `plan_table_budget` set
+    mutable BoundedEnumerationResult bounded_result{};
+
+    ///> the maximum number of csg-cmp pairs to enumerate; the join graph of queries with more pairs is simplified
+    ///> first, see `simplify_query_graph()`; 0 disables simplification
+    std::size_t simplification_budget = 100'000;
+
+    ///> whether queries of at most 16 data sources are optimized by the specialized `SmallQueryDP`, if the cost
+    ///> function is C_out and orders are not tracked
+    bool specialize_small_queries = true;
+
+    OrderTracking order_tracking = OrderTracking::Off;
+    PhysicalCostModel physical_cost_model;
+    ///> the physical cost of the plan chosen by the last enumeration with `order_tracking` enabled
+    mutable double physical_cost = 0;
+
     template<typename PlanTable>
     void operator()(m::enumerate_tag, PlanTable &PT, const m::QueryGraph &G, const m::CostFunction &CF) const;
+
+    /** Incrementally re-optimizes \p PT, the final plan table of an enumeration of \p G, after the cardinalities of
+     * the subproblems in \p changed changed, e.g. because the cardinality estimator of the database in use was
+     * replaced.  Only the changed subproblems and their supersets are estimated and enumerated again, all other
+     * entries of \p PT are kept. */
+    template<typename PlanTable>
+    void reoptimize(PlanTable &PT, const m::QueryGraph &G, const m::CostFunction &CF,
+                    const std::vector<m::SmallBitset> &changed) const;
+
+    /** Re-optimizes \p PT, the final plan table of an enumeration of \p G, for the joins that remain after the
+     * subproblems in \p finished were executed, e.g. after the cardinality estimator learned their actual
+     * cardinalities.  Every finished subproblem is kept with its plan as a unit, only the joins between units are
+     * enumerated again, see `enumerate_units()`. */
+    template<typename PlanTable>
+    void replan(PlanTable &PT, const m::QueryGraph &G, const m::CostFunction &CF,
+                const std::vector<m::SmallBitset> &finished) const;
 };
@@ -0,0 +1,212 @@
+#include "ParallelSort.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+
+namespace {
+
+constexpr std::size_t PREFIX_SIZE = sizeof(uint64_t);
+
+/** A row to sort: the first bytes of its normalized keys and its row id. */
+struct Entry
+{
+    uint64_t prefix; ///< the first `PREFIX_SIZE` bytes of the normalized keys, big endian
+    uint32_t row;
+};
+
+/** The normalized keys of all rows and their order. */
+struct NormalizedKeys
+{
+    const std::vector<SortKey> &keys;
+    std::size_t width = 0; ///< the size of the normalized keys of a row
+    std::vector<uint8_t> rest; ///< the normalized keys of all rows, only if `width` exceeds `PREFIX_SIZE`
+
+    NormalizedKeys(const std::vector<SortKey> &keys, std::size_t num_rows)
+        : keys(keys)
+    {
+        for (auto &key : keys)
+            width += key.column.size;
+        if (width > PREFIX_SIZE)
+            rest.resize(num_rows * width);
+    }
+
+    /** Normalizes the keys of \p row and returns its entry. */
+    Entry normalize(uint32_t row)
+    {
+        uint8_t buffer[PREFIX_SIZE] = { };
+        uint8_t *out = rest.empty() ? buffer : &rest[std::size_t(row) * width];
+        for (auto &key : keys) {
+            const uint8_t *p = key.column.at(row);
+            const std::size_t n = key.column.size;
+            if (key.column.is_character_sequence) {
+                const std::size_t length = strnlen(reinterpret_cast<const char*>(p), n);
+                std::memcpy(out, p, length);
+                std::memset(out + length, 0, n - length);
+            } else {
+                const uint64_t value = uint64_t(load_integer(p, n)) ^ (uint64_t(1) << (8 * n - 1));
+                for (std::size_t i = 0; i != n; ++i)
+                    out[i] = value >> (8 * (n - 1 - i));
+            }
+            if (key.descending) {
+                for (std::size_t i = 0; i != n; ++i)
+                    out[i] = ~out[i];
+            }
+            out += n;
+        }
+
+        const uint8_t *normalized = rest.empty() ? buffer : &rest[std::size_t(row) * width];
+        uint64_t prefix = 0;
+        for (std::size_t i = 0; i != PREFIX_SIZE; ++i)
+            prefix = prefix << 8 | (i < width ? normalized[i] : 0);
+        return Entry{ prefix, row };
+    }
+
+    bool less(const Entry &left, const Entry &right) const
+    {
+        if (left.prefix != right.prefix)
+            return left.prefix < right.prefix;
+        if (not rest.empty()) {
+            const int cmp = std::memcmp(&rest[std::size_t(left.row) * width + PREFIX_SIZE],
+                                        &rest[std::size_t(right.row) * width + PREFIX_SIZE], width - PREFIX_SIZE);
+            if (cmp != 0)
+                return cmp < 0;
+        }
+        return left.row < right.row;
+    }
+
+    auto comparator() const { return [this](const Entry &left, const Entry &right) { return less(left, right); }; }
+};
+
+}
+
+std::vector<uint32_t> ParallelSort::operator()(ThreadPool &pool, const std::vector<SortKey> &keys,
+                                               std::size_t num_rows) const
+{
+    NormalizedKeys normalized(keys, num_rows);
+    const auto less = normalized.comparator();
+
+    /*----- Normalize the keys of all rows. -----*/
+    std::vector<Entry> entries(num_rows);
+    const std::size_t num_morsels = (num_rows + morsel_size - 1) / morsel_size;
+    pool.parallel_for(num_morsels, 1, [&](std::size_t morsel) {
+        const std::size_t end = std::min(num_rows, (morsel + 1) * morsel_size);
+        for (std::size_t row = morsel * morsel_size; row != end; ++row)
+            entries[row] = normalized.normalize(row);
+    });
+
+    /*----- Sort one run per worker. -----*/
+    const std::size_t num_runs = std::max<std::size_t>(1, std::min(pool.num_threads(), num_rows / 1024));
+    std::vector<std::size_t> run_bounds(num_runs + 1);
+    for (std::size_t r = 0; r <= num_runs; ++r)
+        run_bounds[r] = r * num_rows / num_runs;
+    pool.parallel_for(num_runs, 1, [&](std::size_t r) {
+        std::sort(entries.begin() + run_bounds[r], entries.begin() + run_bounds[r + 1], less);
+    });
+
+    std::vector<uint32_t> result(num_rows);
+    if (num_runs == 1) {
+        std::transform(entries.begin(), entries.end(), result.begin(), [](const Entry &e) { return e.row; });
+        return result;
+    }
+
+    /*----- Split the runs into ranges by splitters sampled from all runs. -----*/
+    constexpr std::size_t SAMPLES_PER_RUN = 64;
+    std::vector<Entry> samples;
+    for (std::size_t r = 0; r != num_runs; ++r) {
+        const std::size_t size = run_bounds[r + 1] - run_bounds[r];
+        for (std::size_t i = 0; i != SAMPLES_PER_RUN; ++i)
+            samples.push_back(entries[run_bounds[r] + i * size / SAMPLES_PER_RUN]);
+    }
+    std::sort(samples.begin(), samples.end(), less);
+
+    const std::size_t num_ranges = num_runs;
+    /* `cuts[q][r]` is the position in the run `r` where range `q` starts. */
+    std::vector<std::vector<std::size_t>> cuts(num_ranges + 1, std::vector<std::size_t>(num_runs));
+    for (std::size_t r = 0; r != num_runs; ++r) {
+        cuts.front()[r] = run_bounds[r];
+        cuts.back()[r] = run_bounds[r + 1];
+        for (std::size_t q = 1; q != num_ranges; ++q) {
+            const Entry &splitter = samples[q * samples.size() / num_ranges];
+            cuts[q][r] = std::lower_bound(entries.begin() + run_bounds[r], entries.begin() + run_bounds[r + 1],
+                                          splitter, less) - entries.begin();
+        }
+    }
+
+    /*----- Merge every range from all runs. -----*/
+    pool.parallel_for(num_ranges, 1, [&](std::size_t q) {
+        std::size_t out = 0;
+        for (std::size_t p = 0; p != q; ++p) {
+            for (std::size_t r = 0; r != num_runs; ++r)
+                out += cuts[p + 1][r] - cuts[p][r];
+        }
+
+        /* A heap of the positions of the next entry of every run, the smallest entry on top. */
+        std::vector<std::pair<std::size_t, std::size_t>> heap; // (position, end)
+        auto greater = [&](const auto &left, const auto &right) {
+            return less(entries[right.first], entries[left.first]);
+        };
+        for (std::size_t r = 0; r != num_runs; ++r) {
+            if (cuts[q][r] != cuts[q + 1][r])
+                heap.emplace_back(cuts[q][r], cuts[q + 1][r]);
+        }
+        std::make_heap(heap.begin(), heap.end(), greater);
+        while (not heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), greater);
+            auto &next = heap.back();
+            result[out++] = entries[next.first].row;
+            if (++next.first == next.second)
+                heap.pop_back();
+            else
+                std::push_heap(heap.begin(), heap.end(), greater);
+        }
+    });
+    return result;
+}
+
+std::vector<uint32_t> ParallelSort::top_k(ThreadPool &pool, const std::vector<SortKey> &keys, std::size_t num_rows,
+                                          std::size_t k) const
+{
+    if (k == 0)
+        return {};
+    if (k >= num_rows)
+        return (*this)(pool, keys, num_rows);
+
+    NormalizedKeys normalized(keys, num_rows);
+    const auto less = normalized.comparator();
+
+    /*----- Keep the first k rows of every worker's morsels in a heap, the last of them on top. -----*/
+    const std::size_t num_workers = pool.num_threads();
+    const std::size_t num_morsels = (num_rows + morsel_size - 1) / morsel_size;
+    std::vector<std::vector<Entry>> heaps(num_workers);
+    std::atomic_size_t next_morsel = 0;
+    pool.parallel_for(num_workers, 1, [&](std::size_t worker) {
+        auto &heap = heaps[worker];
+        heap.reserve(k + 1);
+        for (std::size_t morsel; (morsel = next_morsel++) < num_morsels; ) {
+            const std::size_t end = std::min(num_rows, (morsel + 1) * morsel_size);
+            for (std::size_t row = morsel * morsel_size; row != end; ++row) {
+                const Entry entry = normalized.normalize(row);
+                if (heap.size() == k and not less(entry, heap.front()))
+                    continue;
+                heap.push_back(entry);
+                std::push_heap(heap.begin(), heap.end(), less);
+                if (heap.size() > k) {
+                    std::pop_heap(heap.begin(), heap.end(), less);
+                    heap.pop_back();
+                }
+            }
+        }
+    });
+
+    /*----- Merge the heaps of all workers. -----*/
+    std::vector<Entry> entries;
+    for (auto &heap : heaps)
+        entries.insert(entries.end(), heap.begin(), heap.end());
+    std::partial_sort(entries.begin(), entries.begin() + k, entries.end(), less);
+
+    std::vector<uint32_t> result(k);
+    std::transform(entries.begin(), entries.begin() + k, result.begin(), [](const Entry &e) { return e.row; });
+    return result;
+}
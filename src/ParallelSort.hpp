@@ -0,0 +1,42 @@
+#pragma once
+
+#include "LayoutColumn.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/** A column to sort by. */
+struct SortKey
+{
+    LayoutColumn column;
+    bool descending = false;
+};
+
+/** Sorts the rows of a table natively and in parallel, reading the columns to sort by directly from the table's store,
+ * as for `SELECT ... FROM table ORDER BY keys [LIMIT k]`.  Rows of equal keys stay in their order in the table.
+ *
+ * The keys of every row are first normalized into a binary string that sorts by `memcmp()`: integers big endian with
+ * the sign bit flipped, character sequences padded with NUL bytes, all bits inverted for descending keys.  Rows are
+ * sorted as pairs of the first 8 bytes of their normalized keys, compared as one integer, and their row id; the rest of
+ * the normalized keys is only compared by `memcmp()` if the first 8 bytes are equal.  Every worker of a `ThreadPool`
+ * sorts a run of the rows, then the runs are split by splitters sampled from them into ranges of about equal size, and
+ * every range is merged from all runs by one worker through a heap.
+ *
+ * The first k rows are instead selected by every worker keeping a heap of the k first rows of the morsels it
+ * normalizes, and merging the heaps of all workers. */
+struct ParallelSort
+{
+    ///> the number of rows a worker normalizes at once
+    std::size_t morsel_size = 16 * 1024;
+
+    /** Returns the row ids of the first \p num_rows rows of \p keys' columns in the order of \p keys. */
+    std::vector<uint32_t> operator()(ThreadPool &pool, const std::vector<SortKey> &keys, std::size_t num_rows) const;
+
+    /** Returns the row ids of the first \p k of the first \p num_rows rows of \p keys' columns in the order of
+     * \p keys. */
+    std::vector<uint32_t> top_k(ThreadPool &pool, const std::vector<SortKey> &keys, std::size_t num_rows,
+                                std::size_t k) const;
+};
@@ -0,0 +1,350 @@
+#include "PipelineExecutor.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+using namespace m;
+
+
+PipelineExecutor::PipelineExecutor(const QueryGraph &G, std::vector<const ColumnarTable*> tables)
+    : G_(G)
+    , tables_(std::move(tables))
+    , predicates_(resolve_equi_joins(G))
+    , filters_(G.num_sources())
+{
+    M_insist(tables_.size() == G.num_sources(), "every data source needs a table");
+
+    for (auto ds : G.sources()) {
+        for (auto &clause : ds->filter()) {
+            if (clause.size() != 1)
+                throw std::invalid_argument("disjunctive filters are not supported");
+            auto bin = cast<const ast::BinaryExpr>(&clause[0].expr());
+            if (not bin)
+                throw std::invalid_argument("only comparisons are supported as filters");
+            auto op = bin->op().type;
+            if (op != TK_EQUAL and op != TK_NOT_EQUAL and op != TK_LESS and op != TK_LESS_EQUAL and
+                op != TK_GREATER and op != TK_GREATER_EQUAL)
+                throw std::invalid_argument("only comparisons are supported as filters");
+
+            /* Normalize the comparison to have the attribute on the left. */
+            auto d = cast<const ast::Designator>(bin->lhs.get());
+            auto c = cast<const ast::Constant>(bin->rhs.get());
+            if (not d) {
+                d = cast<const ast::Designator>(bin->rhs.get());
+                c = cast<const ast::Constant>(bin->lhs.get());
+                switch (op) {
+                    case TK_LESS:          op = TK_GREATER;       break;
+                    case TK_LESS_EQUAL:    op = TK_GREATER_EQUAL; break;
+                    case TK_GREATER:       op = TK_LESS;          break;
+                    case TK_GREATER_EQUAL: op = TK_LESS_EQUAL;    break;
+                    default: break;
+                }
+            }
+            if (not d or not c)
+                throw std::invalid_argument("only comparisons of an attribute with a constant are supported as "
+                                            "filters");
+            if (c->tok.type != TK_DEC_INT and c->tok.type != TK_OCT_INT and c->tok.type != TK_HEX_INT)
+                throw std::invalid_argument("only integer constants are supported in filters");
+
+            filters_[ds->id()].push_back(Comparison{
+                .attr = resolve_column(G, *d).attr,
+                .op = op,
+                .constant = std::strtoll(c->tok.text, nullptr, 0),
+                .negative = clause[0].negative(),
+            });
+        }
+    }
+}
+
+bool PipelineExecutor::holds(const Comparison &c, int64_t value)
+{
+    bool result;
+    switch (c.op) {
+        case TK_EQUAL:         result = value == c.constant; break;
+        case TK_NOT_EQUAL:     result = value != c.constant; break;
+        case TK_LESS:          result = value <  c.constant; break;
+        case TK_LESS_EQUAL:    result = value <= c.constant; break;
+        case TK_GREATER:       result = value >  c.constant; break;
+        case TK_GREATER_EQUAL: result = value >= c.constant; break;
+        default: M_unreachable("unsupported comparison");
+    }
+    return result != c.negative;
+}
+
+template<typename PlanTable>
+PipelineExecutor::Result PipelineExecutor::operator()(ThreadPool &pool, const PlanTable &PT,
+                                                      const CardinalityEstimator &CE)
+{
+    return execute(pool, PT, CE, [](SmallBitset, std::size_t) { return false; });
+}
+
+template<typename PlanTable>
+PipelineExecutor::Result PipelineExecutor::operator()(ThreadPool &pool, PlanTable &PT, FeedbackCardinalityEstimator &CE,
+                                                      const MyPlanEnumerator &PE, const CostFunction &CF)
+{
+    M_insist(PE.cardinality_estimator == &CE, "plans must be enumerated with the feedback estimator");
+    num_replans = 0;
+    std::vector<SmallBitset> finished;
+    return execute(pool, PT, CE, [&](SmallBitset S, std::size_t cardinality) {
+        finished.push_back(S);
+        const double estimated = std::max<double>(1, CE.predict_cardinality(*PT[S].model));
+        const double actual = std::max<double>(1, cardinality);
+        CE.observe(*PT[S].model, cardinality);
+        if (std::max(actual / estimated, estimated / actual) <= replan_factor)
+            return false;
+        PE.replan(PT, G_, CF, finished);
+        ++num_replans;
+        return true;
+    });
+}
+
+template<typename PlanTable, typename Feedback>
+PipelineExecutor::Result PipelineExecutor::execute(ThreadPool &pool, const PlanTable &PT,
+                                                   const CardinalityEstimator &CE, Feedback &&feedback)
+{
+    hash_tables_.clear();
+    materialized_.clear();
+
+    Result result;
+    for (;;) {
+        pipelines_.clear();
+        Pipeline root;
+        root.sink = RESULT;
+        compile(PT, CE, SmallBitset(~0UL >> (64 - G_.num_sources())), root);
+        pipelines_.push_back(std::move(root));
+
+        for (auto &pipeline : pipelines_) {
+            run(pool, pipeline, result);
+            if (pipeline.sink == RESULT)
+                return result;
+            materialized_.emplace(pipeline.sources, pipeline.sink);
+            if (feedback(SmallBitset(pipeline.sources), hash_tables_[pipeline.sink].rowids.front().size()))
+                break; // compile the changed plan, reusing the materialized build sides
+        }
+    }
+}
+
+template<typename PlanTable>
+void PipelineExecutor::compile(const PlanTable &PT, const CardinalityEstimator &CE, SmallBitset S,
+                               Pipeline &pipeline)
+{
+    pipeline.sources = uint64_t(S);
+
+    /* Finished work is scanned from the hash table it was materialized in. */
+    if (auto it = materialized_.find(uint64_t(S)); it != materialized_.end()) {
+        pipeline.input = it->second;
+        pipeline.layout = hash_tables_[it->second].layout;
+        return;
+    }
+
+    if (std::has_single_bit(uint64_t(S))) {
+        pipeline.source = std::countr_zero(uint64_t(S));
+        pipeline.filter = filters_[pipeline.source];
+        pipeline.layout = { pipeline.source };
+        return;
+    }
+
+    auto &entry = PT[S];
+    const bool build_left = CE.predict_cardinality(*PT[entry.left].model) <=
+                            CE.predict_cardinality(*PT[entry.right].model);
+    const SmallBitset build = build_left ? entry.left : entry.right;
+    const SmallBitset probe = build_left ? entry.right : entry.left;
+
+    /* The build side is compiled into pipelines of its own, which run before `pipeline`. */
+    Pipeline build_pipeline;
+    compile(PT, CE, build, build_pipeline);
+    const std::size_t hash_table = hash_tables_.size();
+    build_pipeline.sink = hash_table;
+    hash_tables_.emplace_back().layout = build_pipeline.layout;
+    pipelines_.push_back(std::move(build_pipeline));
+
+    /* The probe side continues `pipeline`. */
+    compile(PT, CE, probe, pipeline);
+    pipeline.sources = uint64_t(S);
+    auto &HT = hash_tables_[hash_table];
+    std::vector<ProbeKey> keys = keys_between(pipeline.layout, HT.layout);
+    Probe &step = pipeline.probes.emplace_back();
+    step.hash_table = hash_table;
+    if (not keys.empty()) {
+        HT.key = keys.front();
+        step.residuals.assign(std::next(keys.begin()), keys.end());
+    }
+    pipeline.layout.insert(pipeline.layout.end(), HT.layout.begin(), HT.layout.end());
+}
+
+std::vector<PipelineExecutor::ProbeKey> PipelineExecutor::keys_between(const std::vector<std::size_t> &probe,
+                                                                       const std::vector<std::size_t> &build) const
+{
+    auto column_of = [](const std::vector<std::size_t> &layout, std::size_t source) -> std::size_t {
+        auto it = std::find(layout.begin(), layout.end(), source);
+        return it == layout.end() ? NONE : it - layout.begin();
+    };
+
+    std::vector<ProbeKey> keys;
+    for (auto &p : predicates_) {
+        for (auto [l, r] : { std::pair(p.lhs, p.rhs), std::pair(p.rhs, p.lhs) }) {
+            const std::size_t probe_column = column_of(probe, l.source), build_column = column_of(build, r.source);
+            if (probe_column != NONE and build_column != NONE) {
+                keys.push_back(ProbeKey{ l, probe_column, r, build_column });
+                break;
+            }
+        }
+    }
+    return keys;
+}
+
+void PipelineExecutor::run(ThreadPool &pool, const Pipeline &pipeline, Result &result)
+{
+    const HashTable *input = pipeline.input == NONE ? nullptr : &hash_tables_[pipeline.input];
+    const std::size_t num_rows = input ? input->rowids.front().size() : tables_[pipeline.source]->num_rows;
+    const std::size_t num_morsels = (num_rows + MORSEL_SIZE - 1) / MORSEL_SIZE;
+    HashTable *HT = pipeline.sink == RESULT ? nullptr : &hash_tables_[pipeline.sink];
+    if (HT)
+        HT->chunks.assign(num_morsels, std::vector<std::vector<uint32_t>>(pipeline.layout.size()));
+
+    std::vector<std::size_t> num_tuples(num_morsels, 0);
+    std::vector<uint64_t> checksums(num_morsels, 0);
+    pool.parallel_for(num_morsels, 1, [&](std::size_t morsel) {
+        MorselState state;
+        std::size_t width = input ? input->layout.size() : 1;
+        state.batches.emplace_back(width);
+        for (auto &p : pipeline.probes) {
+            width += hash_tables_[p.hash_table].layout.size();
+            state.batches.emplace_back(width);
+        }
+        if (HT)
+            state.build_chunk = &HT->chunks[morsel];
+
+        /* Scan and filter the morsel. */
+        const std::size_t end = std::min(num_rows, (morsel + 1) * MORSEL_SIZE);
+        Batch &scan = state.batches.front();
+        for (std::size_t begin = morsel * MORSEL_SIZE; begin < end; begin += BATCH_SIZE) {
+            const std::size_t batch_end = std::min(end, begin + BATCH_SIZE);
+            if (input) {
+                for (std::size_t c = 0; c != scan.rowids.size(); ++c)
+                    scan.rowids[c].assign(input->rowids[c].begin() + begin, input->rowids[c].begin() + batch_end);
+                push(pipeline, 0, scan, state);
+                continue;
+            }
+
+            const ColumnarTable &table = *tables_[pipeline.source];
+            for (uint32_t rowid = begin; rowid != batch_end; ++rowid) {
+                const bool qualifies = std::all_of(pipeline.filter.begin(), pipeline.filter.end(),
+                                                   [&](const Comparison &c) {
+                    return not table.is_null(c.attr, rowid) and holds(c, table.value(c.attr, rowid));
+                });
+                if (qualifies)
+                    scan.rowids[0].push_back(rowid);
+            }
+            if (scan.size())
+                push(pipeline, 0, scan, state);
+        }
+
+        /* Push the partially filled batches of all operators through the rest of the pipeline. */
+        for (std::size_t step = 1; step != state.batches.size(); ++step) {
+            if (state.batches[step].size())
+                push(pipeline, step, state.batches[step], state);
+        }
+
+        num_tuples[morsel] = state.num_tuples;
+        checksums[morsel] = state.checksum;
+    });
+
+    if (not HT) {
+        result.num_tuples += std::accumulate(num_tuples.begin(), num_tuples.end(), std::size_t(0));
+        result.checksum += std::accumulate(checksums.begin(), checksums.end(), uint64_t(0));
+        return;
+    }
+
+    /* Concatenate the build tuples of all morsels and build the hash table on them. */
+    HT->rowids.assign(pipeline.layout.size(), {});
+    for (auto &chunk : HT->chunks) {
+        for (std::size_t c = 0; c != chunk.size(); ++c)
+            HT->rowids[c].insert(HT->rowids[c].end(), chunk[c].begin(), chunk[c].end());
+    }
+    HT->chunks.clear();
+
+    if (HT->key) {
+        const auto &rowids = HT->rowids[HT->key->build_column];
+        HT->table = std::make_unique<JoinHashTable>(rowids.size());
+        for (uint32_t i = 0; i != rowids.size(); ++i) {
+            if (not is_null(HT->key->build, rowids[i]))
+                HT->table->insert(join_key(value(HT->key->build, rowids[i])), i);
+        }
+    }
+}
+
+void PipelineExecutor::push(const Pipeline &pipeline, std::size_t step, Batch &batch, MorselState &state) const
+{
+    if (step == pipeline.probes.size())
+        sink(pipeline, batch, state);
+    else
+        probe(pipeline, step, batch, state);
+    batch.clear();
+}
+
+void PipelineExecutor::probe(const Pipeline &pipeline, std::size_t step, const Batch &in, MorselState &state) const
+{
+    const Probe &p = pipeline.probes[step];
+    const HashTable &HT = hash_tables_[p.hash_table];
+    Batch &out = state.batches[step + 1];
+    const std::size_t width = in.rowids.size();
+
+    auto matches = [&](const ProbeKey &k, std::size_t i, uint32_t b) {
+        return equal(k.probe, in.rowids[k.probe_column][i], k.build, HT.rowids[k.build_column][b]);
+    };
+    auto emit = [&](std::size_t i, uint32_t b) {
+        if (HT.key and not matches(*HT.key, i, b))
+            return; // the keys collide or the probe key is NULL
+        for (auto &r : p.residuals) {
+            if (not matches(r, i, b))
+                return;
+        }
+        for (std::size_t c = 0; c != width; ++c)
+            out.rowids[c].push_back(in.rowids[c][i]);
+        for (std::size_t c = 0; c != HT.rowids.size(); ++c)
+            out.rowids[width + c].push_back(HT.rowids[c][b]);
+        if (out.size() == BATCH_SIZE)
+            push(pipeline, step + 1, out, state);
+    };
+
+    if (HT.key) {
+        int32_t keys[BATCH_SIZE];
+        const auto &rowids = in.rowids[HT.key->probe_column];
+        for (std::size_t i = 0; i != in.size(); ++i)
+            keys[i] = join_key(value(HT.key->probe, rowids[i]));
+        HT.table->probe(keys, in.size(), emit);
+    } else {
+        const std::size_t num_build = HT.rowids.front().size();
+        for (std::size_t i = 0; i != in.size(); ++i) {
+            for (uint32_t b = 0; b != num_build; ++b)
+                emit(i, b);
+        }
+    }
+}
+
+void PipelineExecutor::sink(const Pipeline&, Batch &batch, MorselState &state) const
+{
+    if (state.build_chunk) {
+        auto &chunk = *state.build_chunk;
+        for (std::size_t c = 0; c != batch.rowids.size(); ++c)
+            chunk[c].insert(chunk[c].end(), batch.rowids[c].begin(), batch.rowids[c].end());
+        return;
+    }
+
+    state.num_tuples += batch.size();
+    for (auto &rowids : batch.rowids)
+        state.checksum = std::accumulate(rowids.begin(), rowids.end(), state.checksum);
+}
+
+#define INSTANTIATE(PLAN_TABLE) \
+    template PipelineExecutor::Result PipelineExecutor::operator()<PLAN_TABLE>( \
+        ThreadPool&, const PLAN_TABLE&, const CardinalityEstimator&); \
+    template PipelineExecutor::Result PipelineExecutor::operator()<PLAN_TABLE>( \
+        ThreadPool&, PLAN_TABLE&, FeedbackCardinalityEstimator&, const MyPlanEnumerator&, const CostFunction&);
+INSTANTIATE(PlanTableSmallOrDense)
+INSTANTIATE(PlanTableLargeAndSparse)
+#undef INSTANTIATE
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "FeedbackCardinalityEstimator.hpp"
+#include "JoinHashTable.hpp"
+#include "MyPlanEnumerator.hpp"
+#include "PlanExecutor.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+
+/** Executes the join plans chosen by plan enumeration as push-based pipelines on `ColumnarTable`s, e.g. scanning the
+ * stores of mutable in place.
+ *
+ * A plan is compiled into pipelines, each scanning a data source, filtering it, probing the hash tables of zero or more
+ * joins and ending in a sink, which either builds the hash table of a join or consumes the result.  Of the inputs of a
+ * join, the one with the smaller estimated cardinality is the build side and ends its pipeline, the other one continues
+ * the pipeline through the probe.  Pipelines run one after another, such that every hash table is built before it is
+ * probed.
+ *
+ * Every pipeline is run morsel-wise on the workers of a `ThreadPool`.  Tuples are row ids, one per data source of the
+ * pipeline so far, and are pushed through the pipeline in batches of up to `BATCH_SIZE` tuples, i.e. intermediate
+ * results are only materialized where a hash table is built.  Filters must be conjunctions of comparisons of an
+ * attribute with an integer constant, joins conjunctions of equi-join predicates.  Hash tables are keyed by the
+ * `join_key()` of a value and every match is checked on the values.  NULL satisfies no filter and joins with nothing.
+ *
+ * Executed adaptively, the actual cardinality of every build side is fed back to the cardinality estimator.  If it is
+ * off from the estimate by more than `replan_factor`, the joins not executed yet are re-planned by `MyPlanEnumerator`
+ * and compiled again.  The build sides materialized so far are kept as inputs of the new plan. */
+struct PipelineExecutor
+{
+    using Result = PlanExecutor::Result;
+
+    static constexpr std::size_t BATCH_SIZE = 1024;
+    ///> the number of rows of the scanned data source a worker processes at once
+    static constexpr std::size_t MORSEL_SIZE = 16 * 1024;
+
+    ///> the factor by which the actual cardinality of a build side must be off from its estimate to re-plan
+    double replan_factor = 2;
+    ///> the number of times the last adaptive execution re-planned
+    std::size_t num_replans = 0;
+
+    private:
+    /** A comparison `attr op constant` of a filter. */
+    struct Comparison
+    {
+        std::size_t attr;
+        m::TokenType op;
+        int64_t constant;
+        bool negative;
+    };
+
+    /** A batch of tuples, `rowids[c][i]` being the row id of the `c`-th data source of the `i`-th tuple. */
+    struct Batch
+    {
+        std::vector<std::vector<uint32_t>> rowids;
+
+        explicit Batch(std::size_t num_sources)
+            : rowids(num_sources)
+        {
+            for (auto &r : rowids)
+                r.reserve(BATCH_SIZE);
+        }
+
+        std::size_t size() const { return rowids.front().size(); }
+        void clear() { for (auto &r : rowids) r.clear(); }
+    };
+
+    /** A predicate of a probe, comparing an attribute of the probing tuple with one of the matching build tuple. */
+    struct ProbeKey
+    {
+        ColumnRef probe;
+        std::size_t probe_column; ///< the position of the data source of `probe` in the probing tuple
+        ColumnRef build;
+        std::size_t build_column; ///< the position of the data source of `build` in the build tuple
+    };
+
+    /** The hash table of a join, built by one pipeline and probed by another. */
+    struct HashTable
+    {
+        std::vector<std::size_t> layout; ///< the data source of every column of the build tuples
+        std::optional<ProbeKey> key; ///< the predicate whose build side attribute is the key, none for cross products
+        std::vector<std::vector<std::vector<uint32_t>>> chunks; ///< the build tuples collected per morsel
+        std::vector<std::vector<uint32_t>> rowids; ///< the build tuples, by column
+        std::unique_ptr<JoinHashTable> table; ///< maps keys to positions in `rowids`
+    };
+
+    struct Probe
+    {
+        std::size_t hash_table;
+        std::vector<ProbeKey> residuals; ///< predicates checked for every match in addition to the key
+    };
+
+    struct Pipeline
+    {
+        uint64_t sources = 0; ///< the data sources joined by this pipeline
+        std::size_t source; ///< the scanned data source
+        std::size_t input = NONE; ///< the hash table whose build tuples are scanned instead of `source`, if any
+        std::vector<Comparison> filter;
+        std::vector<Probe> probes;
+        std::vector<std::size_t> layout; ///< the data source of every column of the tuples reaching the sink
+        std::size_t sink; ///< the hash table built by this pipeline, or `RESULT` if it produces the result
+    };
+
+    /** The state of a worker processing a morsel: the batches between the operators of the pipeline. */
+    struct MorselState
+    {
+        std::vector<Batch> batches; ///< the input batch of every probe and of the sink
+        std::vector<std::vector<uint32_t>> *build_chunk = nullptr;
+        std::size_t num_tuples = 0;
+        uint64_t checksum = 0;
+    };
+
+    static constexpr std::size_t NONE = -1;
+    static constexpr std::size_t RESULT = -1;
+
+    const m::QueryGraph &G_;
+    std::vector<const ColumnarTable*> tables_;
+    std::vector<EquiJoinPredicate> predicates_;
+    std::vector<std::vector<Comparison>> filters_; ///< the filter of every data source
+    std::vector<Pipeline> pipelines_;
+    std::vector<HashTable> hash_tables_;
+    std::unordered_map<uint64_t, std::size_t> materialized_; ///< the hash table holding every finished build side
+
+    public:
+    /** Creates an executor for plans of \p G, reading data source `i` from `tables[i]`.  Throws
+     * `std::invalid_argument` if \p G has joins other than equi-joins, see `resolve_equi_joins()`, or filters other
+     * than conjunctions of comparisons of an attribute with an integer constant. */
+    PipelineExecutor(const m::QueryGraph &G, std::vector<const ColumnarTable*> tables);
+
+    /** Compiles the final plan of \p PT into pipelines and runs them on the workers of \p pool.  Build sides are chosen
+     * by the cardinalities \p CE estimates for the entries of \p PT. */
+    template<typename PlanTable>
+    Result operator()(ThreadPool &pool, const PlanTable &PT, const m::CardinalityEstimator &CE);
+
+    /** Executes the final plan of \p PT adaptively.  \p PT must have been computed with \p CE, which learns the actual
+     * cardinalities of all build sides.  The remaining joins are re-planned by \p PE for the cost function \p CF,
+     * with `PE.cardinality_estimator` being \p CE. */
+    template<typename PlanTable>
+    Result operator()(ThreadPool &pool, PlanTable &PT, FeedbackCardinalityEstimator &CE, const MyPlanEnumerator &PE,
+                      const m::CostFunction &CF);
+
+    std::size_t num_pipelines() const { return pipelines_.size(); }
+
+    private:
+    int64_t value(const ColumnRef &c, uint32_t rowid) const { return tables_[c.source]->value(c.attr, rowid); }
+    bool is_null(const ColumnRef &c, uint32_t rowid) const { return tables_[c.source]->is_null(c.attr, rowid); }
+    /** Returns whether the values of \p l in row \p l_rowid and of \p r in row \p r_rowid are equal and not NULL. */
+    bool equal(const ColumnRef &l, uint32_t l_rowid, const ColumnRef &r, uint32_t r_rowid) const
+    {
+        return not is_null(l, l_rowid) and not is_null(r, r_rowid) and value(l, l_rowid) == value(r, r_rowid);
+    }
+    static bool holds(const Comparison &c, int64_t value);
+
+    /** Runs the pipelines of the final plan of \p PT.  After every build side is materialized, \p feedback is invoked
+     * with its subproblem and actual cardinality and returns whether \p PT changed, which recompiles the pipelines
+     * that did not run yet. */
+    template<typename PlanTable, typename Feedback>
+    Result execute(ThreadPool &pool, const PlanTable &PT, const m::CardinalityEstimator &CE, Feedback &&feedback);
+
+    /** Compiles the plan for \p S into pipelines, continuing \p pipeline with the probe side of every join. */
+    template<typename PlanTable>
+    void compile(const PlanTable &PT, const m::CardinalityEstimator &CE, m::SmallBitset S, Pipeline &pipeline);
+
+    /** Returns the predicates between the data sources of the tuples \p probe and \p build. */
+    std::vector<ProbeKey> keys_between(const std::vector<std::size_t> &probe,
+                                       const std::vector<std::size_t> &build) const;
+
+    void run(ThreadPool &pool, const Pipeline &pipeline, Result &result);
+    void push(const Pipeline &pipeline, std::size_t step, Batch &batch, MorselState &state) const;
+    void probe(const Pipeline &pipeline, std::size_t step, const Batch &in, MorselState &state) const;
+    void sink(const Pipeline &pipeline, Batch &batch, MorselState &state) const;
+};
@@ -0,0 +1,203 @@
+#include "PlanExecutor.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+using namespace m;
+
+
+ColumnarTable ColumnarTable::Of(const Table &table)
+{
+    ColumnarTable result;
+    result.num_rows = table.store().num_rows();
+    result.columns.resize(table.num_attrs());
+    for (auto &attr : table) {
+        if (attr.type->is_integral())
+            result.columns[attr.id] = LayoutColumn::Of(table, attr);
+    }
+    return result;
+}
+
+void ColumnarTable::generate(std::size_t attr, std::vector<int64_t> values)
+{
+    M_insist(values.size() == num_rows, "a generated column needs a value per row");
+    if (columns.size() <= attr)
+        columns.resize(attr + 1);
+    /* A single array of 8 byte integers, i.e. blocks of one value without a NULL bitmap. */
+    LayoutColumn &column = columns[attr];
+    column = LayoutColumn();
+    column.data = reinterpret_cast<const uint8_t*>(values.data());
+    column.block_stride = sizeof(int64_t);
+    column.size = sizeof(int64_t);
+    generated_.push_back(std::move(values)); // moving keeps the memory of `values`
+}
+
+const std::vector<uint32_t> & PlanExecutor::Intermediate::of(std::size_t source) const
+{
+    auto it = std::find(sources_order.begin(), sources_order.end(), source);
+    M_insist(it != sources_order.end(), "source is not part of this intermediate result");
+    return rowids[it - sources_order.begin()];
+}
+
+ColumnRef resolve_column(const QueryGraph &G, const ast::Designator &d)
+{
+    auto target = d.target();
+    auto attr = std::get_if<const Attribute*>(&target);
+    if (not attr or not *attr)
+        throw std::invalid_argument("only attributes of data sources are supported");
+    for (auto ds : G.sources()) {
+        const char *name = ds->alias() ? ds->alias() : ds->name();
+        if (d.table_name.text and std::strcmp(name, d.table_name.text) == 0)
+            return ColumnRef{ ds->id(), (*attr)->id };
+    }
+    throw std::invalid_argument("designator does not refer to a data source");
+}
+
+std::vector<EquiJoinPredicate> resolve_equi_joins(const QueryGraph &G)
+{
+    std::vector<EquiJoinPredicate> predicates;
+    for (auto join : G.joins()) {
+        for (auto &clause : join->condition()) {
+            if (clause.size() != 1)
+                throw std::invalid_argument("disjunctive join predicates are not supported");
+            auto bin = cast<const ast::BinaryExpr>(&clause[0].expr());
+            auto lhs = bin ? cast<const ast::Designator>(bin->lhs.get()) : nullptr;
+            auto rhs = bin ? cast<const ast::Designator>(bin->rhs.get()) : nullptr;
+            if (not lhs or not rhs or bin->op().type != TK_EQUAL or clause[0].negative())
+                throw std::invalid_argument("only equi-join predicates are supported");
+            const ColumnRef l = resolve_column(G, *lhs), r = resolve_column(G, *rhs);
+            predicates.push_back(EquiJoinPredicate{ (1UL << l.source) | (1UL << r.source), l, r });
+        }
+    }
+    return predicates;
+}
+
+PlanExecutor::PlanExecutor(const QueryGraph &G, std::vector<const ColumnarTable*> tables)
+    : G_(G)
+    , tables_(std::move(tables))
+    , predicates_(resolve_equi_joins(G))
+{
+    M_insist(tables_.size() == G.num_sources(), "every data source needs a table");
+    for (auto ds : G.sources()) {
+        if (not ds->filter().empty())
+            throw std::invalid_argument("filters of data sources are not supported");
+    }
+}
+
+template<typename PlanTable>
+PlanExecutor::Result PlanExecutor::operator()(const PlanTable &PT) const
+{
+    const SmallBitset all(~0UL >> (64 - G_.num_sources()));
+    const Intermediate I = execute(PT, all);
+
+    Result result;
+    result.num_tuples = I.size();
+    for (auto &rowids : I.rowids)
+        result.checksum = std::accumulate(rowids.begin(), rowids.end(), result.checksum);
+    return result;
+}
+
+template<typename PlanTable>
+PlanExecutor::Intermediate PlanExecutor::execute(const PlanTable &PT, SmallBitset S) const
+{
+    if (std::has_single_bit(uint64_t(S)))
+        return scan(std::countr_zero(uint64_t(S)));
+    auto &entry = PT[S];
+    return join(execute(PT, entry.left), execute(PT, entry.right));
+}
+
+PlanExecutor::Intermediate PlanExecutor::scan(std::size_t source) const
+{
+    M_insist(G_.sources()[source]->filter().empty(), "filters are rejected by the constructor");
+    Intermediate I;
+    I.sources = 1UL << source;
+    I.sources_order.push_back(source);
+    I.rowids.emplace_back(tables_[source]->num_rows);
+    std::iota(I.rowids[0].begin(), I.rowids[0].end(), 0);
+    return I;
+}
+
+PlanExecutor::Intermediate PlanExecutor::join(const Intermediate &left, const Intermediate &right) const
+{
+    const bool build_left = left.size() <= right.size();
+    const Intermediate &build = build_left ? left : right;
+    const Intermediate &probe = build_left ? right : left;
+
+    /* Collect the predicates between the inputs, oriented as (build column, probe column). */
+    std::vector<std::pair<ColumnRef, ColumnRef>> predicates;
+    for (auto &p : predicates_) {
+        if ((p.sources & ~(left.sources | right.sources)) or not (p.sources & left.sources) or
+            not (p.sources & right.sources))
+            continue;
+        if (build.sources & (1UL << p.lhs.source))
+            predicates.emplace_back(p.lhs, p.rhs);
+        else
+            predicates.emplace_back(p.rhs, p.lhs);
+    }
+
+    /* Compute the matching pairs of positions in `build` and `probe`. */
+    JoinMatches matches;
+    if (predicates.empty()) {
+        for (uint32_t j = 0; j != probe.size(); ++j) {
+            for (uint32_t i = 0; i != build.size(); ++i) {
+                matches.build.push_back(i);
+                matches.probe.push_back(j);
+            }
+        }
+    } else {
+        auto gather_keys = [this](const Intermediate &input, const ColumnRef &key) {
+            const auto &rowids = input.of(key.source);
+            std::vector<int32_t> keys(rowids.size());
+            for (std::size_t i = 0; i != rowids.size(); ++i)
+                keys[i] = join_key(value(key, rowids[i]));
+            return keys;
+        };
+        const std::vector<int32_t> build_keys = gather_keys(build, predicates.front().first);
+        const std::vector<int32_t> probe_keys = gather_keys(probe, predicates.front().second);
+
+        if (pool and radix_config.should_partition(build_keys.size()))
+            matches = radix_join(*pool, radix_config, build_keys.data(), build_keys.size(),
+                                 probe_keys.data(), probe_keys.size());
+        else
+            matches = hash_join(build_keys.data(), build_keys.size(), probe_keys.data(), probe_keys.size());
+
+        /* Check all predicates on all matches, the first one as well since its keys may collide or be NULL. */
+        for (const auto &[b, p] : predicates) {
+            const auto &build_rowids = build.of(b.source);
+            const auto &probe_rowids = probe.of(p.source);
+            std::size_t num_matches = 0;
+            for (std::size_t k = 0; k != matches.size(); ++k) {
+                if (equal(b, build_rowids[matches.build[k]], p, probe_rowids[matches.probe[k]])) {
+                    matches.build[num_matches] = matches.build[k];
+                    matches.probe[num_matches] = matches.probe[k];
+                    ++num_matches;
+                }
+            }
+            matches.build.resize(num_matches);
+            matches.probe.resize(num_matches);
+        }
+    }
+
+    /* Gather the row ids of the result. */
+    Intermediate result;
+    result.sources = left.sources | right.sources;
+    auto gather = [&result](const Intermediate &input, const std::vector<uint32_t> &positions) {
+        for (std::size_t s = 0; s != input.sources_order.size(); ++s) {
+            result.sources_order.push_back(input.sources_order[s]);
+            auto &out = result.rowids.emplace_back(positions.size());
+            const auto &in = input.rowids[s];
+            for (std::size_t k = 0; k != positions.size(); ++k)
+                out[k] = in[positions[k]];
+        }
+    };
+    gather(build, matches.build);
+    gather(probe, matches.probe);
+    return result;
+}
+
+template PlanExecutor::Result PlanExecutor::operator()<PlanTableSmallOrDense>(const PlanTableSmallOrDense &) const;
+template PlanExecutor::Result PlanExecutor::operator()<PlanTableLargeAndSparse>(const PlanTableLargeAndSparse &) const;
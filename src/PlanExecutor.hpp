@@ -0,0 +1,128 @@
+#pragma once
+
+#include "LayoutColumn.hpp"
+#include "RadixJoin.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/** The integral columns of a table, located in the store of a mutable table or generated.  Columns of a store are
+ * read in place, hence the table must not change while the columns are used. */
+struct ColumnarTable
+{
+    std::size_t num_rows = 0;
+    std::vector<LayoutColumn> columns; ///< the values per attribute id, unset for non-integral attributes
+
+    private:
+    std::vector<std::vector<int64_t>> generated_; ///< the memory of generated columns
+
+    public:
+    ColumnarTable() = default;
+    ColumnarTable(const ColumnarTable&) = delete; // the columns would refer to the memory of the original
+    ColumnarTable(ColumnarTable&&) = default;
+
+    /** Locates all integral columns of \p table in its store. */
+    static ColumnarTable Of(const m::Table &table);
+
+    /** Makes \p values, one per row and none of them NULL, the column of attribute \p attr. */
+    void generate(std::size_t attr, std::vector<int64_t> values);
+
+    bool is_null(std::size_t attr, std::size_t row) const { return columns[attr].is_null(row); }
+    int64_t value(std::size_t attr, std::size_t row) const
+    {
+        return load_integer(columns[attr].at(row), columns[attr].size);
+    }
+};
+
+/** Returns the 32 bit key of \p value for a `JoinHashTable`.  Distinct values may share a key, hence matches must be
+ * checked on the values. */
+inline int32_t join_key(int64_t value) { return int32_t(value ^ (value >> 32)); }
+
+/** An attribute of a data source of a query graph. */
+struct ColumnRef
+{
+    std::size_t source;
+    std::size_t attr;
+};
+
+/** A predicate `lhs = rhs` joining two data sources. */
+struct EquiJoinPredicate
+{
+    uint64_t sources; ///< the data sources of `lhs` and `rhs`
+    ColumnRef lhs;
+    ColumnRef rhs;
+};
+
+/** Returns the data source and attribute designated by \p d in \p G.  Throws `std::invalid_argument` if \p d does not
+ * designate an attribute of a data source. */
+ColumnRef resolve_column(const m::QueryGraph &G, const m::ast::Designator &d);
+
+/** Returns the predicates of all joins of \p G.  Throws `std::invalid_argument` unless all joins are conjunctions of
+ * equi-join predicates. */
+std::vector<EquiJoinPredicate> resolve_equi_joins(const m::QueryGraph &G);
+
+/** Executes the join plans chosen by plan enumeration natively on `ColumnarTable`s, to time the optimizer's choice
+ * end to end.
+ *
+ * Intermediate results are lists of row ids, one per data source joined so far.  Every join is a hash join on the
+ * first equi-join predicate between its inputs, building a `JoinHashTable` on the smaller input and probing it with
+ * the `join_key()`s of the other input.  If the hash table would exceed the last level cache and a thread pool is
+ * given, the join is radix-partitioned instead.  All predicates between the inputs are checked on every match, where
+ * NULL equals nothing.
+ * Inputs without any predicate between them are joined by a cross product.  Filters of data sources are not
+ * supported, the constructor rejects them. */
+struct PlanExecutor
+{
+    struct Result
+    {
+        std::size_t num_tuples = 0;
+        uint64_t checksum = 0; ///< the sum of all row ids of the result, to compare results of different plans
+    };
+
+    ///> the workers for radix-partitioned joins, joins are never partitioned if not set
+    ThreadPool *pool = nullptr;
+    ///> the caches radix-partitioned joins are tuned to
+    RadixJoinConfig radix_config = RadixJoinConfig::Detect();
+
+    private:
+    struct Intermediate
+    {
+        uint64_t sources = 0;
+        std::vector<std::size_t> sources_order; ///< the data source of every list of row ids
+        std::vector<std::vector<uint32_t>> rowids;
+
+        std::size_t size() const { return rowids.empty() ? 0 : rowids.front().size(); }
+        const std::vector<uint32_t> & of(std::size_t source) const;
+    };
+
+    const m::QueryGraph &G_;
+    std::vector<const ColumnarTable*> tables_;
+    std::vector<EquiJoinPredicate> predicates_;
+
+    public:
+    /** Creates an executor for plans of \p G, reading data source `i` from `tables[i]`.  Throws
+     * `std::invalid_argument` if \p G has filters on data sources or joins other than equi-joins. */
+    PlanExecutor(const m::QueryGraph &G, std::vector<const ColumnarTable*> tables);
+
+    /** Executes the final plan of \p PT. */
+    template<typename PlanTable>
+    Result operator()(const PlanTable &PT) const;
+
+    private:
+    int64_t value(const ColumnRef &c, uint32_t rowid) const { return tables_[c.source]->value(c.attr, rowid); }
+    /** Returns whether the values of \p l in row \p l_rowid and of \p r in row \p r_rowid are equal and not NULL. */
+    bool equal(const ColumnRef &l, uint32_t l_rowid, const ColumnRef &r, uint32_t r_rowid) const
+    {
+        return not tables_[l.source]->is_null(l.attr, l_rowid) and not tables_[r.source]->is_null(r.attr, r_rowid) and
+               value(l, l_rowid) == value(r, r_rowid);
+    }
+
+    template<typename PlanTable>
+    Intermediate execute(const PlanTable &PT, m::SmallBitset S) const;
+
+    Intermediate scan(std::size_t source) const;
+    Intermediate join(const Intermediate &left, const Intermediate &right) const;
+};
@@ -0,0 +1,133 @@
+#include "PlanSerialization.hpp"
+#include "ColumnStatistics.hpp"
+#include "JoinPredicates.hpp"
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <unordered_set>
+
+using namespace m;
+
+
+uint64_t plan_fingerprint(std::string_view query, std::string_view cardinalities)
+{
+    return mix_hash(hash_string(query) ^ mix_hash(hash_string(cardinalities) + 1));
+}
+
+namespace {
+
+template<typename T>
+void write_raw(std::ostream &out, const T &value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template<typename T>
+bool read_raw(std::istream &in, T &value)
+{
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+template<typename PlanTable>
+void collect_joins(const PlanTable &PT, const CardinalityEstimator &CE, SmallBitset S,
+                   std::vector<SerializedPlan::Join> &joins)
+{
+    auto &entry = PT[S];
+    if (not uint64_t(entry.left) or not uint64_t(entry.right))
+        return; // a data source
+    collect_joins(PT, CE, entry.left, joins);
+    collect_joins(PT, CE, entry.right, joins);
+    joins.push_back({ uint64_t(entry.left), uint64_t(entry.right), entry.cost,
+                      double(CE.predict_cardinality(*entry.model)) });
+}
+
+}
+
+template<typename PlanTable>
+SerializedPlan SerializedPlan::from_plan_table(const PlanTable &PT, const CardinalityEstimator &CE,
+                                               uint64_t fingerprint)
+{
+    SerializedPlan plan;
+    plan.fingerprint = fingerprint;
+    plan.num_sources = PT.num_sources();
+    const SmallBitset all(~0UL >> (64 - PT.num_sources()));
+    collect_joins(PT, CE, all, plan.joins);
+    return plan;
+}
+
+void SerializedPlan::write(std::ostream &out) const
+{
+    out.write(MAGIC, sizeof(MAGIC));
+    write_raw(out, VERSION);
+    write_raw(out, num_sources);
+    write_raw(out, fingerprint);
+    write_raw(out, uint32_t(joins.size()));
+    out.write(reinterpret_cast<const char*>(joins.data()), joins.size() * sizeof(Join));
+}
+
+std::optional<SerializedPlan> SerializedPlan::read(std::istream &in)
+{
+    char magic[sizeof(MAGIC)];
+    uint32_t version, num_joins;
+    SerializedPlan plan;
+    if (not in.read(magic, sizeof(magic)) or std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return std::nullopt;
+    if (not read_raw(in, version) or version != VERSION)
+        return std::nullopt;
+    if (not read_raw(in, plan.num_sources) or not read_raw(in, plan.fingerprint) or not read_raw(in, num_joins))
+        return std::nullopt;
+    if (plan.num_sources == 0 or plan.num_sources > 64 or num_joins != plan.num_sources - 1)
+        return std::nullopt; // a plan of n data sources has n - 1 joins
+    plan.joins.resize(num_joins);
+    if (not in.read(reinterpret_cast<char*>(plan.joins.data()), num_joins * sizeof(Join)))
+        return std::nullopt;
+    return plan;
+}
+
+std::optional<std::string> SerializedPlan::check(const QueryGraph &G) const
+{
+    if (num_sources != G.num_sources())
+        return "the plan has " + std::to_string(num_sources) + " data sources, the query " +
+               std::to_string(G.num_sources());
+    if (joins.size() + 1 != num_sources)
+        return "the plan has " + std::to_string(joins.size()) + " joins of " + std::to_string(num_sources) +
+               " data sources";
+
+    /* The subproblems planned so far and not yet joined.  Every join consumes two of them and produces their union. */
+    const uint64_t all = ~0UL >> (64 - num_sources);
+    std::unordered_set<uint64_t> inputs;
+    for (std::size_t i = 0; i != num_sources; ++i)
+        inputs.insert(1UL << i);
+    for (std::size_t i = 0; i != joins.size(); ++i) {
+        const auto &join = joins[i];
+        const std::string which = "join " + std::to_string(i);
+        if (not join.left or not join.right or (join.left | join.right) & ~all)
+            return which + " is not of subproblems of the data sources";
+        if (join.left & join.right)
+            return which + " has overlapping sides";
+        if (not inputs.erase(join.left) or not inputs.erase(join.right))
+            return which + " is not of subproblems planned before";
+        inputs.insert(join.left | join.right);
+    }
+    return std::nullopt; // n - 1 joins of two inputs each leave one input, of all data sources
+}
+
+template<typename PlanTable>
+void ReplayPlanEnumerator::operator()(enumerate_tag, PlanTable &PT, const QueryGraph &G, const CostFunction &CF) const
+{
+    M_insist(not plan.check(G), "the plan must be checked for the query");
+    auto &CE = Catalog::Get().get_database_in_use().cardinality_estimator();
+    const JoinPredicates predicates(G);
+
+    for (auto &join : plan.joins) {
+        const SmallBitset left(join.left), right(join.right);
+        M_insist(PT.has_plan(left) and PT.has_plan(right), "joins must be stored bottom up");
+        PT.update(G, CE, CF, left, right, predicates.between(left, right));
+    }
+}
+
+template SerializedPlan SerializedPlan::from_plan_table<PlanTableSmallOrDense>(const PlanTableSmallOrDense &, const CardinalityEstimator &, uint64_t);
+template SerializedPlan SerializedPlan::from_plan_table<PlanTableLargeAndSparse>(const PlanTableLargeAndSparse &, const CardinalityEstimator &, uint64_t);
+
+template void ReplayPlanEnumerator::operator()<PlanTableSmallOrDense &>(enumerate_tag, PlanTableSmallOrDense &, const QueryGraph &, const CostFunction &) const;
+template void ReplayPlanEnumerator::operator()<PlanTableLargeAndSparse &>(enumerate_tag, PlanTableLargeAndSparse &, const QueryGraph &, const CostFunction &) const;
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <mutable/mutable.hpp>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+/** Returns a fingerprint identifying a query by its text and the cardinalities used to optimize it. */
+uint64_t plan_fingerprint(std::string_view query, std::string_view cardinalities);
+
+/** The joins of an optimized plan, in a compact binary format that other processes can load to skip optimization.
+ *
+ * The format, in host byte order, is the magic `DBSPLAN\0`, the `uint32_t` version and number of data sources, the
+ * `uint64_t` fingerprint of the query, the `uint32_t` number of joins, and per join the `uint64_t` masks of its left
+ * and right subproblem followed by the `double` cost and cardinality of the joined subproblem.  Joins are stored bottom
+ * up, so every join follows the joins producing its inputs. */
+struct SerializedPlan
+{
+    static constexpr char MAGIC[8] = { 'D', 'B', 'S', 'P', 'L', 'A', 'N', '\0' };
+    static constexpr uint32_t VERSION = 1;
+
+    struct Join
+    {
+        uint64_t left;
+        uint64_t right;
+        double cost;
+        double cardinality;
+    };
+
+    uint64_t fingerprint = 0;
+    uint32_t num_sources = 0;
+    std::vector<Join> joins;
+
+    /** Collects the joins of the final plan of \p PT. */
+    template<typename PlanTable>
+    static SerializedPlan from_plan_table(const PlanTable &PT, const m::CardinalityEstimator &CE,
+                                          uint64_t fingerprint);
+
+    void write(std::ostream &out) const;
+
+    /** Reads a plan from \p in.  Returns `std::nullopt` if \p in does not contain a plan of the current version with
+     * one join less than data sources. */
+    static std::optional<SerializedPlan> read(std::istream &in);
+
+    /** Returns why the plan cannot be replayed for the query graph \p G, or `std::nullopt` if it can: the plan must
+     * have as many data sources as \p G, and its joins must form one tree, bottom up, of disjoint non-empty
+     * subproblems of these data sources. */
+    std::optional<std::string> check(const m::QueryGraph &G) const;
+};
+
+/** A plan enumerator that enters a `SerializedPlan` into the plan table instead of enumerating.  Only the joins of
+ * the plan are estimated and costed.  The plan must pass `SerializedPlan::check()` for the query graph. */
+struct ReplayPlanEnumerator final : m::PlanEnumeratorCRTP<ReplayPlanEnumerator>
+{
+    using base_type = m::PlanEnumeratorCRTP<ReplayPlanEnumerator>;
+    using base_type::operator();
+
+    const SerializedPlan &plan;
+
+    explicit ReplayPlanEnumerator(const SerializedPlan &plan) : plan(plan) { }
+
+    template<typename PlanTable>
+    void operator()(m::enumerate_tag, PlanTable &PT, const m::QueryGraph &G, const m::CostFunction &CF) const;
+};
@@ -0,0 +1,139 @@
+#include "QuerySimplification.hpp"
+#include "JoinPredicates.hpp"
+#include <limits>
+#include <unordered_set>
+
+using namespace m;
+
+
+UnitGraph::UnitGraph(const QueryGraph &G)
+    : sources_(G.num_sources())
+    , neighbours_(G.num_sources(), 0)
+{
+    for (std::size_t i = 0; i != sources_.size(); ++i)
+        sources_[i] = 1UL << i;
+    for (auto join : G.joins()) {
+        uint64_t S = 0;
+        for (auto ds : join->sources())
+            S |= 1UL << ds->id();
+        for (uint64_t x = S; x; x &= x - 1)
+            neighbours_[std::countr_zero(x)] |= S & ~(x & -x);
+    }
+}
+
+uint64_t UnitGraph::sources(uint64_t units) const
+{
+    uint64_t S = 0;
+    for (uint64_t x = units; x; x &= x - 1)
+        S |= sources_[std::countr_zero(x)];
+    return S;
+}
+
+std::vector<uint64_t> UnitGraph::components() const
+{
+    std::vector<uint64_t> components;
+    uint64_t unvisited = size() == 64 ? ~0UL : (1UL << size()) - 1;
+    while (unvisited) {
+        uint64_t C = unvisited & -unvisited;
+        for (uint64_t frontier = C; frontier; ) {
+            uint64_t N = 0;
+            for (uint64_t x = frontier; x; x &= x - 1)
+                N |= neighbours_[std::countr_zero(x)];
+            frontier = N & ~C;
+            C |= N;
+        }
+        components.push_back(C);
+        unvisited &= ~C;
+    }
+    return components;
+}
+
+void UnitGraph::merge(std::size_t u, std::size_t v)
+{
+    const std::size_t last = size() - 1;
+    const uint64_t bit_u = 1UL << u, bit_v = 1UL << v, bit_last = 1UL << last;
+
+    sources_[u] |= sources_[v];
+    neighbours_[u] = (neighbours_[u] | neighbours_[v]) & ~(bit_u | bit_v);
+    for (auto &N : neighbours_) {
+        if (N & bit_v)
+            N = (N & ~bit_v) | bit_u;
+    }
+    neighbours_[u] &= ~bit_u;
+
+    /* Move the last unit to index `v`. */
+    if (v != last) {
+        sources_[v] = sources_[last];
+        neighbours_[v] = neighbours_[last];
+        for (auto &N : neighbours_) {
+            if (N & bit_last)
+                N = (N & ~bit_last) | bit_v;
+        }
+    }
+    sources_.pop_back();
+    neighbours_.pop_back();
+}
+
+template<typename PlanTable>
+UnitGraph simplify_query_graph(PlanTable &PT, const QueryGraph &G, const CardinalityEstimator &CE,
+                               const CostFunction &CF, std::size_t budget)
+{
+    UnitGraph U(G);
+    const JoinPredicates predicates(G);
+
+    while (U.size() > 1 and U.count_ccps(budget) > budget) {
+        /* Find the join of adjacent units with the smallest result. */
+        double best = std::numeric_limits<double>::infinity();
+        std::size_t best_u = 0, best_v = 0;
+        for (std::size_t u = 0; u != U.size(); ++u) {
+            const SmallBitset left(U.sources_of(u));
+            for (uint64_t n = U.neighbours_of(u) & ~(~0UL >> (63 - u)); n; n &= n - 1) { // each edge once
+                const std::size_t v = std::countr_zero(n);
+                const SmallBitset right(U.sources_of(v));
+                auto model = CE.estimate_join(G, *PT[left].model, *PT[right].model, predicates.between(left, right));
+                const double size = CE.predict_cardinality(*model);
+                if (size < best) {
+                    best = size;
+                    best_u = u;
+                    best_v = v;
+                }
+            }
+        }
+        if (best_u == best_v)
+            break; // no edges left, the graph is not connected
+
+        const SmallBitset left(U.sources_of(best_u)), right(U.sources_of(best_v));
+        PT.update(G, CE, CF, left, right, predicates.between(left, right));
+        U.merge(best_u, best_v);
+    }
+
+    return U;
+}
+
+template<typename PlanTable>
+void enumerate_units(PlanTable &PT, const QueryGraph &G, const UnitGraph &U, const CardinalityEstimator &CE,
+                     const CostFunction &CF)
+{
+    const JoinPredicates predicates(G);
+    std::unordered_set<uint64_t> enumerated;
+    U.for_each_ccp([&](uint64_t S1, uint64_t S2) {
+        const uint64_t left = U.sources(S1), right = U.sources(S2);
+        if (enumerated.insert(left | right).second) {
+            auto &entry = PT[SmallBitset(left | right)];
+            entry.model.reset();
+            entry.cost = std::numeric_limits<double>::infinity();
+        }
+        PT.update(G, CE, CF, SmallBitset(left), SmallBitset(right), predicates.between(left, right));
+        return true;
+    });
+}
+
+#define INSTANTIATE(PLAN_TABLE) \
+    template UnitGraph simplify_query_graph<PLAN_TABLE>(PLAN_TABLE &, const QueryGraph &, \
+                                                        const CardinalityEstimator &, const CostFunction &, \
+                                                        std::size_t); \
+    template void enumerate_units<PLAN_TABLE>(PLAN_TABLE &, const QueryGraph &, const UnitGraph &, \
+                                              const CardinalityEstimator &, const CostFunction &);
+INSTANTIATE(PlanTableSmallOrDense)
+INSTANTIATE(PlanTableLargeAndSparse)
+#undef INSTANTIATE
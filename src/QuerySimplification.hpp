@@ -0,0 +1,135 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <vector>
+
+
+/** A join graph over *units*, i.e. disjoint sets of data sources whose join order is already decided.  Initially,
+ * every data source of the query graph is a unit of its own.  Sets of units are masks of unit indices. */
+struct UnitGraph
+{
+    private:
+    std::vector<uint64_t> sources_; ///< the data sources of each unit
+    std::vector<uint64_t> neighbours_; ///< the units adjacent to each unit
+
+    public:
+    explicit UnitGraph(const m::QueryGraph &G);
+
+    std::size_t size() const { return sources_.size(); }
+
+    /** Returns the data sources of the unit \p u. */
+    uint64_t sources_of(std::size_t u) const { return sources_[u]; }
+    /** Returns the data sources of all units in \p units. */
+    uint64_t sources(uint64_t units) const;
+    /** Returns the units adjacent to unit \p u. */
+    uint64_t neighbours_of(std::size_t u) const { return neighbours_[u]; }
+
+    /** Returns the connected components of this graph as sets of units. */
+    std::vector<uint64_t> components() const;
+
+    /** Merges unit \p v into unit \p u.  The last unit takes the index of \p v. */
+    void merge(std::size_t u, std::size_t v);
+
+    /** Invokes \p fn with every csg-cmp pair of sets of units, in an order such that both sets of a pair are
+     * enumerated as pairs before, as DPccp does.  Stops as soon as \p fn returns `false` and returns `false` then. */
+    template<typename Fn>
+    bool for_each_ccp(Fn &&fn) const
+    {
+        for (std::size_t i = size(); i-- != 0; ) {
+            const uint64_t v = 1UL << i;
+            if (not emit_csg(v, fn))
+                return false;
+            if (not enumerate_csg_rec(v, prefix(i), fn))
+                return false;
+        }
+        return true;
+    }
+
+    /** Returns the number of csg-cmp pairs, counting at most up to \p limit + 1. */
+    std::size_t count_ccps(std::size_t limit) const
+    {
+        std::size_t count = 0;
+        for_each_ccp([&](uint64_t, uint64_t) { return ++count <= limit; });
+        return count;
+    }
+
+    private:
+    /** Returns the units with index at most \p i. */
+    static uint64_t prefix(std::size_t i) { return ~0UL >> (63 - i); }
+
+    uint64_t neighbourhood(uint64_t S) const
+    {
+        uint64_t N = 0;
+        for (uint64_t x = S; x; x &= x - 1)
+            N |= neighbours_[std::countr_zero(x)];
+        return N & ~S;
+    }
+
+    template<typename Fn>
+    bool enumerate_csg_rec(uint64_t S, uint64_t X, Fn &fn) const
+    {
+        const uint64_t N = neighbourhood(S) & ~X;
+        if (not N)
+            return true;
+        for (uint64_t x = N & -N; x; x = (x - N) & N) { // all non-empty subsets of `N`
+            if (not emit_csg(S | x, fn))
+                return false;
+        }
+        for (uint64_t x = N & -N; x; x = (x - N) & N) {
+            if (not enumerate_csg_rec(S | x, X | N, fn))
+                return false;
+        }
+        return true;
+    }
+
+    template<typename Fn>
+    bool emit_csg(uint64_t S1, Fn &fn) const
+    {
+        const uint64_t X = S1 | prefix(std::countr_zero(S1));
+        const uint64_t N = neighbourhood(S1) & ~X;
+        for (uint64_t n = N; n; ) {
+            const std::size_t i = 63 - std::countl_zero(n); // in descending order
+            n &= ~(1UL << i);
+            const uint64_t S2 = 1UL << i;
+            if (not fn(S1, S2))
+                return false;
+            if (not enumerate_cmp_rec(S1, S2, X | (prefix(i) & N), fn))
+                return false;
+        }
+        return true;
+    }
+
+    template<typename Fn>
+    bool enumerate_cmp_rec(uint64_t S1, uint64_t S2, uint64_t X, Fn &fn) const
+    {
+        const uint64_t N = neighbourhood(S2) & ~X;
+        if (not N)
+            return true;
+        for (uint64_t x = N & -N; x; x = (x - N) & N) {
+            if (not fn(S1, S2 | x))
+                return false;
+        }
+        for (uint64_t x = N & -N; x; x = (x - N) & N) {
+            if (not enumerate_cmp_rec(S1, S2 | x, X | N, fn))
+                return false;
+        }
+        return true;
+    }
+};
+
+/** Simplifies the join graph of queries with a search space too large for exact enumeration, following the idea of
+ * Neumann's query simplification: the join that is obviously best, i.e. the join of two adjacent units with the
+ * smallest estimated result, is committed to greedily, until the number of csg-cmp pairs of the remaining graph is at
+ * most \p budget.  Every committed join is entered into \p PT.  Returns the simplified graph. */
+template<typename PlanTable>
+UnitGraph simplify_query_graph(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE,
+                               const m::CostFunction &CF, std::size_t budget);
+
+/** Enumerates all csg-cmp pairs of the units of \p U, entering the best plan for every connected set of units into
+ * \p PT.  The plans of the units themselves must already be in \p PT, plans for sets of several units are replaced. */
+template<typename PlanTable>
+void enumerate_units(PlanTable &PT, const m::QueryGraph &G, const UnitGraph &U, const m::CardinalityEstimator &CE,
+                     const m::CostFunction &CF);
@@ -0,0 +1,239 @@
+#include "RadixJoin.hpp"
+#include "JoinHashTable.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <unistd.h>
+#include <utility>
+
+
+namespace {
+
+struct Tuple
+{
+    int32_t key;
+    uint32_t payload; ///< the position of the key in its input
+};
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+constexpr std::size_t TUPLES_PER_LINE = CACHE_LINE_SIZE / sizeof(Tuple);
+
+/** A software write-combining buffer, collecting tuples of one partition until a full cache line can be written. */
+struct alignas(CACHE_LINE_SIZE) CacheLine
+{
+    Tuple tuples[TUPLES_PER_LINE];
+};
+
+/** An input partitioned by radix, partition `p` being `tuples[bounds[p]]` to `tuples[bounds[p + 1]]`. */
+struct Partitioned
+{
+    std::unique_ptr<Tuple[]> tuples;
+    std::vector<std::size_t> bounds;
+};
+
+/** Returns the partition of \p key, given by the \p bits bits of its hash starting at bit \p shift. */
+std::size_t radix(int32_t key, unsigned shift, unsigned bits)
+{
+    return (JoinHashTable::hash(key) >> shift) & ((std::size_t(1) << bits) - 1);
+}
+
+unsigned ceil_log2(std::size_t n) { return n <= 1 ? 0 : std::bit_width(n - 1); }
+
+/** Scatters the tuples `tuple_at(i)` for all `i` in `[begin, end)` to their partitions in \p out, the next tuple of
+ * partition `p` going to `out[offsets[p]]`.  Advances \p offsets past the written tuples. */
+template<typename TupleAt>
+void scatter(TupleAt &&tuple_at, std::size_t begin, std::size_t end, Tuple *out, std::size_t *offsets,
+             unsigned shift, unsigned bits)
+{
+    const std::size_t fanout = std::size_t(1) << bits;
+    std::unique_ptr<CacheLine[]> buffers(new CacheLine[fanout]);
+    std::unique_ptr<uint8_t[]> fill(new uint8_t[fanout]());
+
+    for (std::size_t i = begin; i != end; ++i) {
+        const Tuple t = tuple_at(i);
+        const std::size_t p = radix(t.key, shift, bits);
+        buffers[p].tuples[fill[p]] = t;
+        if (++fill[p] == TUPLES_PER_LINE) {
+            std::memcpy(out + offsets[p], buffers[p].tuples, sizeof(CacheLine));
+            offsets[p] += TUPLES_PER_LINE;
+            fill[p] = 0;
+        }
+    }
+
+    /* Flush the partially filled buffers. */
+    for (std::size_t p = 0; p != fanout; ++p) {
+        std::memcpy(out + offsets[p], buffers[p].tuples, fill[p] * sizeof(Tuple));
+        offsets[p] += fill[p];
+    }
+}
+
+/** Partitions the \p n \p keys, tagged with their positions, in one pass per entry of \p passes. */
+Partitioned partition(ThreadPool &pool, const int32_t *keys, std::size_t n, const std::vector<unsigned> &passes)
+{
+    unsigned shift = 64 - passes.front();
+    std::size_t fanout = std::size_t(1) << passes.front();
+
+    /* First pass: every worker partitions a chunk of the input into its own range of every partition. */
+    const std::size_t num_chunks = pool.num_threads();
+    const std::size_t chunk_size = (n + num_chunks - 1) / num_chunks;
+    auto chunk_begin = [&](std::size_t c) { return std::min(n, c * chunk_size); };
+
+    std::vector<std::size_t> offsets(num_chunks * fanout, 0);
+    pool.parallel_for(num_chunks, 1, [&](std::size_t c) {
+        std::size_t *counts = &offsets[c * fanout];
+        for (std::size_t i = chunk_begin(c), end = chunk_begin(c + 1); i != end; ++i)
+            ++counts[radix(keys[i], shift, passes.front())];
+    });
+
+    Partitioned result;
+    result.tuples.reset(new Tuple[n]);
+    result.bounds.resize(fanout + 1);
+    std::size_t sum = 0;
+    for (std::size_t p = 0; p != fanout; ++p) {
+        result.bounds[p] = sum;
+        for (std::size_t c = 0; c != num_chunks; ++c)
+            sum += std::exchange(offsets[c * fanout + p], sum);
+    }
+    result.bounds[fanout] = n;
+
+    pool.parallel_for(num_chunks, 1, [&](std::size_t c) {
+        scatter([keys](std::size_t i) { return Tuple{ keys[i], uint32_t(i) }; }, chunk_begin(c), chunk_begin(c + 1),
+                result.tuples.get(), &offsets[c * fanout], shift, passes.front());
+    });
+
+    /* Further passes: the partitions of the previous pass are partitioned independently of each other. */
+    for (auto it = std::next(passes.begin()); it != passes.end(); ++it) {
+        const unsigned bits = *it;
+        shift -= bits;
+        fanout = std::size_t(1) << bits;
+        const std::size_t num_inputs = result.bounds.size() - 1;
+
+        Partitioned next;
+        next.tuples.reset(new Tuple[n]);
+        next.bounds.resize(num_inputs * fanout + 1);
+        next.bounds.back() = n;
+
+        pool.parallel_for(num_inputs, 1, [&](std::size_t q) {
+            const std::size_t begin = result.bounds[q], end = result.bounds[q + 1];
+            std::size_t *bounds = &next.bounds[q * fanout];
+            std::fill_n(bounds, fanout, 0);
+            for (std::size_t i = begin; i != end; ++i)
+                ++bounds[radix(result.tuples[i].key, shift, bits)];
+            for (std::size_t p = 0, sum = begin; p != fanout; ++p)
+                sum += std::exchange(bounds[p], sum);
+
+            std::vector<std::size_t> cursors(bounds, bounds + fanout);
+            scatter([&result](std::size_t i) { return result.tuples[i]; }, begin, end, next.tuples.get(),
+                    cursors.data(), shift, bits);
+        });
+        result = std::move(next);
+    }
+    return result;
+}
+
+}
+
+
+RadixJoinConfig RadixJoinConfig::Detect()
+{
+    RadixJoinConfig config;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+    if (const long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE); l2 > 0)
+        config.cache_bytes = l2;
+    if (const long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE); l3 > 0)
+        config.llc_bytes = l3;
+    /* Let the write-combining buffers take at most half of the L1 cache and write to at most 1024 partitions, about
+     * the number of pages the second level TLB covers. */
+    if (const long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE); l1 > 0)
+        config.max_bits_per_pass = std::clamp<unsigned>(std::bit_width(std::size_t(l1) / (2 * CACHE_LINE_SIZE)) - 1,
+                                                        1, 10);
+#endif
+    return config;
+}
+
+bool RadixJoinConfig::should_partition(std::size_t num_build) const
+{
+    return JoinHashTable::bytes_for(num_build) > llc_bytes;
+}
+
+std::vector<unsigned> RadixJoinConfig::passes(std::size_t num_build) const
+{
+    if (not should_partition(num_build))
+        return {};
+    const std::size_t bytes = JoinHashTable::bytes_for(num_build);
+    const unsigned total_bits = ceil_log2((bytes + cache_bytes - 1) / cache_bytes);
+    if (total_bits == 0)
+        return {};
+
+    /* Spread the bits evenly over the least number of passes. */
+    const unsigned num_passes = (total_bits + max_bits_per_pass - 1) / max_bits_per_pass;
+    std::vector<unsigned> passes(num_passes, total_bits / num_passes);
+    for (unsigned i = 0; i != total_bits % num_passes; ++i)
+        ++passes[i];
+    return passes;
+}
+
+JoinMatches hash_join(const int32_t *build_keys, std::size_t num_build,
+                      const int32_t *probe_keys, std::size_t num_probe)
+{
+    JoinHashTable HT(num_build);
+    for (std::size_t i = 0; i != num_build; ++i)
+        HT.insert(build_keys[i], i);
+
+    JoinMatches matches;
+    HT.probe(probe_keys, num_probe, [&matches](std::size_t j, uint32_t i) {
+        matches.build.push_back(i);
+        matches.probe.push_back(j);
+    });
+    return matches;
+}
+
+JoinMatches radix_join(ThreadPool &pool, const RadixJoinConfig &config,
+                       const int32_t *build_keys, std::size_t num_build,
+                       const int32_t *probe_keys, std::size_t num_probe)
+{
+    const std::vector<unsigned> passes = config.passes(num_build);
+    if (passes.empty())
+        return hash_join(build_keys, num_build, probe_keys, num_probe);
+
+    const Partitioned build = partition(pool, build_keys, num_build, passes);
+    const Partitioned probe = partition(pool, probe_keys, num_probe, passes);
+
+    /* Join every pair of corresponding partitions. */
+    const std::size_t num_partitions = build.bounds.size() - 1;
+    std::vector<JoinMatches> partial(num_partitions);
+    pool.parallel_for(num_partitions, std::max<std::size_t>(1, num_partitions / (4 * pool.num_threads())),
+                      [&](std::size_t p) {
+        JoinHashTable HT(build.bounds[p + 1] - build.bounds[p]);
+        for (std::size_t i = build.bounds[p]; i != build.bounds[p + 1]; ++i)
+            HT.insert(build.tuples[i].key, build.tuples[i].payload);
+
+        constexpr std::size_t BATCH_SIZE = 1024;
+        int32_t keys[BATCH_SIZE];
+        auto &out = partial[p];
+        for (std::size_t begin = probe.bounds[p]; begin < probe.bounds[p + 1]; begin += BATCH_SIZE) {
+            const std::size_t n = std::min(BATCH_SIZE, probe.bounds[p + 1] - begin);
+            for (std::size_t k = 0; k != n; ++k)
+                keys[k] = probe.tuples[begin + k].key;
+            HT.probe(keys, n, [&](std::size_t k, uint32_t i) {
+                out.build.push_back(i);
+                out.probe.push_back(probe.tuples[begin + k].payload);
+            });
+        }
+    });
+
+    /* Concatenate the matches of all partitions. */
+    std::vector<std::size_t> offsets(num_partitions + 1, 0);
+    for (std::size_t p = 0; p != num_partitions; ++p)
+        offsets[p + 1] = offsets[p] + partial[p].size();
+    JoinMatches matches;
+    matches.build.resize(offsets.back());
+    matches.probe.resize(offsets.back());
+    pool.parallel_for(num_partitions, std::max<std::size_t>(1, num_partitions / pool.num_threads()),
+                      [&](std::size_t p) {
+        std::copy(partial[p].build.begin(), partial[p].build.end(), matches.build.begin() + offsets[p]);
+        std::copy(partial[p].probe.begin(), partial[p].probe.end(), matches.probe.begin() + offsets[p]);
+    });
+    return matches;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+/** The pairs of positions of matching keys computed by a join, `build[i]` matching `probe[i]`. */
+struct JoinMatches
+{
+    std::vector<uint32_t> build;
+    std::vector<uint32_t> probe;
+
+    std::size_t size() const { return build.size(); }
+};
+
+/** The cache and TLB parameters radix partitioning is tuned to. */
+struct RadixJoinConfig
+{
+    ///> the size of the cache a partition's hash table should fit into, i.e. the per-core L2 cache
+    std::size_t cache_bytes = 1UL << 20;
+    ///> the size of the last level cache, beyond which a hash table is partitioned at all
+    std::size_t llc_bytes = 32UL << 20;
+    ///> the maximum number of radix bits per partitioning pass; the write-combining buffers of a pass must fit into
+    /// the L1 cache and the partitions they are flushed to should be covered by the TLB
+    unsigned max_bits_per_pass = 8;
+
+    /** Returns a configuration for the caches of this machine, falling back to the defaults where they are
+     * unknown. */
+    static RadixJoinConfig Detect();
+
+    /** Returns whether a hash table for \p num_build entries exceeds the last level cache. */
+    bool should_partition(std::size_t num_build) const;
+
+    /** Returns the number of radix bits of every partitioning pass, such that the hash table of a partition of
+     * \p num_build entries fits into the cache.  Returns no passes if \p num_build entries fit without partitioning. */
+    std::vector<unsigned> passes(std::size_t num_build) const;
+};
+
+/** Joins \p build_keys and \p probe_keys by a single `JoinHashTable` on all of \p build_keys. */
+JoinMatches hash_join(const int32_t *build_keys, std::size_t num_build,
+                      const int32_t *probe_keys, std::size_t num_probe);
+
+/** Joins \p build_keys and \p probe_keys by a radix-partitioned hash join on the workers of \p pool.
+ *
+ * Both inputs are partitioned by the high bits of their keys' hashes in one or more passes, as chosen by
+ * `RadixJoinConfig::passes()`, such that the hash table of every partition of the build side fits into the cache.  The
+ * first pass partitions chunks of the inputs in parallel, every further pass partitions the partitions of the
+ * previous pass in parallel.  Tuples are scattered through software write-combining buffers of one cache line per
+ * partition, so the partitions are written a full cache line at a time.  Finally, every pair of corresponding
+ * partitions is joined by a `JoinHashTable` in parallel. */
+JoinMatches radix_join(ThreadPool &pool, const RadixJoinConfig &config,
+                       const int32_t *build_keys, std::size_t num_build,
+                       const int32_t *probe_keys, std::size_t num_probe);
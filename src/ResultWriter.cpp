@@ -0,0 +1,147 @@
+#include "ResultWriter.hpp"
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+using namespace m;
+
+
+std::optional<ResultWriter::Format> ResultWriter::ParseFormat(const char *name)
+{
+    if (std::strcmp(name, "text") == 0)
+        return Format::Text;
+    if (std::strcmp(name, "csv") == 0)
+        return Format::CSV;
+    if (std::strcmp(name, "binary") == 0)
+        return Format::Binary;
+    return std::nullopt;
+}
+
+bool ResultWriter::flush()
+{
+    const std::size_t size = size_;
+    size_ = 0;
+    errno = 0;
+    write_all(buffer_.get(), size);
+    return errno == 0;
+}
+
+void ResultWriter::write_all(const char *data, std::size_t size)
+{
+    while (size) {
+        const ssize_t n = ::write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void ResultWriter::field(std::string_view str, bool first)
+{
+    switch (format_) {
+        case Format::Binary:
+            binary(uint32_t(str.size()));
+            *this << str;
+            return;
+
+        case Format::Text:
+            if (not first)
+                *this << ',';
+            *this << '"' << str << '"';
+            return;
+
+        case Format::CSV:
+            if (not first)
+                *this << ',';
+            if (str.find_first_of(",\"\r\n") == std::string_view::npos) {
+                *this << str;
+                return;
+            }
+            /* Quote the field and double the quotes in it. */
+            *this << '"';
+            for (std::size_t pos = 0; ; ) {
+                const std::size_t quote = str.find('"', pos);
+                *this << str.substr(pos, quote - pos);
+                if (quote == std::string_view::npos)
+                    break;
+                *this << "\"\"";
+                pos = quote + 1;
+            }
+            *this << '"';
+            return;
+    }
+}
+
+void ResultWriter::null_field(const Type &type, bool first)
+{
+    /* The binary format has no NULL, write a sentinel of the type instead. */
+    if (format_ == Format::Binary) {
+        if (type.is_character_sequence())
+            binary(std::numeric_limits<uint32_t>::max());
+        else if (type.is_float() or type.is_double() or type.is_decimal())
+            binary(std::numeric_limits<double>::quiet_NaN());
+        else
+            binary(std::numeric_limits<int64_t>::min());
+        return;
+    }
+    if (not first)
+        *this << ',';
+    if (format_ == Format::Text)
+        *this << "NULL";
+}
+
+void ResultWriter::tuple(const Schema &S, const Tuple &t)
+{
+    for (std::size_t i = 0; i != S.num_entries(); ++i) {
+        const bool first = i == 0;
+        auto type = S[i].type;
+
+        if (t.is_null(i)) {
+            null_field(*type, first);
+            continue;
+        }
+
+        if (type->is_character_sequence()) {
+            const char *str = static_cast<const char*>(t[i].as_p());
+            field(std::string_view(str, strnlen(str, as<const CharacterSequence>(*type).length)), first);
+        } else if (type->is_boolean()) {
+            if (format_ == Format::Binary)
+                binary(int64_t(t[i].as_b()));
+            else
+                *this << (first ? "" : ",") << (t[i].as_b() ? "TRUE" : "FALSE");
+        } else if (type->is_float()) {
+            field(t[i].as_f(), first);
+        } else if (type->is_double()) {
+            field(t[i].as_d(), first);
+        } else if (type->is_decimal()) {
+            const int64_t value = t[i].as_i();
+            const unsigned scale = as<const Numeric>(*type).scale;
+            if (format_ == Format::Binary) {
+                binary(value / std::pow(10., scale));
+                continue;
+            }
+            /* Format the fixed-point number exactly, with all `scale` fractional digits. */
+            uint64_t factor = 1;
+            for (unsigned s = 0; s != scale; ++s)
+                factor *= 10;
+            const uint64_t magnitude = value < 0 ? -uint64_t(value) : uint64_t(value);
+            *this << (first ? "" : ",") << (value < 0 ? "-" : "") << magnitude / factor;
+            if (scale) {
+                char digits[20];
+                uint64_t fraction = magnitude % factor;
+                for (unsigned d = scale; d-- != 0; fraction /= 10)
+                    digits[d] = '0' + fraction % 10;
+                *this << '.' << std::string_view(digits, scale);
+            }
+        } else {
+            M_insist(type->is_integral(), "unsupported type");
+            field(t[i].as_i(), first);
+        }
+    }
+    end_row();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <optional>
+#include <string_view>
+#include <unistd.h>
+
+
+/** Writes results to a file descriptor through one reusable buffer, issuing a single `write()` per flush, i.e. when
+ * the buffer is full or on `flush()`.  Numbers are formatted by `std::to_chars()` directly into the buffer.
+ *
+ * Text can be written piecewise by `operator<<`.  Rows of fields are written by `row()` and `tuple()` in one of three
+ * formats: `Text` separates fields by commas and quotes strings, as mutable prints tuples; `CSV` quotes strings only
+ * where RFC 4180 requires it; `Binary` writes integers as 8 byte and floating-point numbers as 8 byte IEEE 754, both
+ * in host byte order, and strings as their 4 byte length followed by their bytes, without any separators.  As it has
+ * no NULL, `tuple()` writes NULL as the length `0xffffffff`, as NaN or as the smallest integer, and decimals as
+ * floating-point numbers. */
+struct ResultWriter
+{
+    enum class Format { Text, CSV, Binary };
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 1UL << 16;
+
+    /** Returns the format named \p name, i.e. `text`, `csv` or `binary`, if any. */
+    static std::optional<Format> ParseFormat(const char *name);
+
+    private:
+    int fd_;
+    Format format_;
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+    std::size_t size_ = 0;
+
+    public:
+    explicit ResultWriter(int fd = STDOUT_FILENO, Format format = Format::Text,
+                          std::size_t capacity = DEFAULT_CAPACITY)
+        : fd_(fd), format_(format), buffer_(std::make_unique<char[]>(capacity)), capacity_(capacity)
+    { }
+
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter & operator=(const ResultWriter&) = delete;
+
+    ~ResultWriter() { flush(); }
+
+    Format format() const { return format_; }
+
+    /** Writes the buffered bytes.  Returns `false` if writing failed. */
+    bool flush();
+
+    ResultWriter & operator<<(std::string_view str)
+    {
+        if (str.size() > capacity_ - size_) {
+            flush();
+            if (str.size() > capacity_) { // too large to buffer at all
+                write_all(str.data(), str.size());
+                return *this;
+            }
+        }
+        std::memcpy(buffer_.get() + size_, str.data(), str.size());
+        size_ += str.size();
+        return *this;
+    }
+
+    ResultWriter & operator<<(const char *str) { return *this << std::string_view(str); }
+
+    ResultWriter & operator<<(char c)
+    {
+        if (size_ == capacity_)
+            flush();
+        buffer_[size_++] = c;
+        return *this;
+    }
+
+    template<typename T>
+    requires std::integral<T> or std::floating_point<T>
+    ResultWriter & operator<<(T value)
+    {
+        constexpr std::size_t MAX_LENGTH = 32; // enough for any integer and the shortest repr. of any double
+        if (capacity_ - size_ < MAX_LENGTH)
+            flush();
+        auto [end, _] = std::to_chars(buffer_.get() + size_, buffer_.get() + capacity_, value);
+        size_ = end - buffer_.get();
+        return *this;
+    }
+
+    /** Writes a row of \p fields, integers, floating-point numbers or strings, in the format of this writer. */
+    template<typename... Fields>
+    void row(const Fields&... fields)
+    {
+        bool first = true;
+        ((field(fields, first), first = false), ...);
+        end_row();
+    }
+
+    /** Writes the tuple \p t of schema \p S as a row in the format of this writer. */
+    void tuple(const m::Schema &S, const m::Tuple &t);
+
+    /** Writes the field \p str of a row whose fields are only known at runtime; \p first tells whether it is the
+     * row's first field.  The row is ended by `end_row()`. */
+    void field(std::string_view str, bool first);
+    void field(const char *str, bool first) { field(std::string_view(str), first); }
+
+    template<typename T>
+    requires std::integral<T> or std::floating_point<T>
+    void field(T value, bool first)
+    {
+        if (format_ == Format::Binary) {
+            if constexpr (std::integral<T>)
+                binary(int64_t(value));
+            else
+                binary(double(value));
+            return;
+        }
+        if (not first)
+            *this << ',';
+        *this << value;
+    }
+
+    /** Writes NULL as a field of type \p type, see `field()`. */
+    void null_field(const m::Type &type, bool first);
+
+    void end_row()
+    {
+        if (format_ != Format::Binary)
+            *this << '\n';
+    }
+
+    private:
+    void write_all(const char *data, std::size_t size);
+
+    template<typename T>
+    void binary(const T &value) { *this << std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)); }
+};
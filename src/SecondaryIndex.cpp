@@ -0,0 +1,319 @@
+#include "SecondaryIndex.hpp"
+#include "LayoutColumn.hpp"
+#include "SortedRuns.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace m;
+
+
+namespace {
+
+/** Returns the result of the integer arithmetic `lhs op rhs`, unless \p op is no arithmetic operator or divides by
+ * zero. */
+std::optional<int64_t> arithmetic(TokenType op, int64_t lhs, int64_t rhs)
+{
+    switch (op) {
+        case TK_PLUS:     return lhs + rhs;
+        case TK_MINUS:    return lhs - rhs;
+        case TK_ASTERISK: return lhs * rhs;
+        case TK_SLASH:    return rhs ? std::optional<int64_t>(lhs / rhs) : std::nullopt;
+        case TK_PERCENT:  return rhs ? std::optional<int64_t>(lhs % rhs) : std::nullopt;
+        default:          return std::nullopt;
+    }
+}
+
+/** Returns the value of \p e if it is an integer constant expression, e.g. `1024 * 1024`. */
+std::optional<int64_t> fold_integer(const ast::Expr &e)
+{
+    if (auto c = cast<const ast::Constant>(&e)) {
+        if (c->tok.type == TK_DEC_INT or c->tok.type == TK_OCT_INT or c->tok.type == TK_HEX_INT)
+            return std::strtoll(c->tok.text, nullptr, 0);
+        return std::nullopt;
+    }
+    if (auto u = cast<const ast::UnaryExpr>(&e)) {
+        auto value = fold_integer(*u->expr);
+        return value ? arithmetic(u->op().type, 0, *value) : std::nullopt;
+    }
+    if (auto b = cast<const ast::BinaryExpr>(&e)) {
+        auto lhs = fold_integer(*b->lhs), rhs = fold_integer(*b->rhs);
+        return lhs and rhs ? arithmetic(b->op().type, *lhs, *rhs) : std::nullopt;
+    }
+    return std::nullopt;
+}
+
+/** Returns the attribute designated by \p e, if \p e designates one. */
+const Attribute * designated_attribute(const ast::Expr &e)
+{
+    auto d = cast<const ast::Designator>(&e);
+    if (not d)
+        return nullptr;
+    auto target = d->target();
+    auto attr = std::get_if<const Attribute*>(&target);
+    return attr ? *attr : nullptr;
+}
+
+/** Returns the contents of the string literal \p c, without its quotes. */
+std::string_view string_literal(const ast::Constant &c)
+{
+    const std::string_view text(c.tok.text);
+    return text.substr(1, text.size() - 2);
+}
+
+/** Returns whether \p e is an integral attribute of \p table, an integer constant, or integer arithmetic of those
+ * dividing only by non-zero constants, i.e. an expression `IndexRangeScan` evaluates to an integer. */
+bool is_integer_expression(const ast::Expr &e, const Table &table)
+{
+    if (auto attr = designated_attribute(e))
+        return &attr->table == &table and attr->type->is_integral();
+    if (fold_integer(e))
+        return true;
+    if (auto u = cast<const ast::UnaryExpr>(&e))
+        return (u->op().type == TK_PLUS or u->op().type == TK_MINUS) and is_integer_expression(*u->expr, table);
+    if (auto b = cast<const ast::BinaryExpr>(&e)) {
+        switch (b->op().type) {
+            case TK_PLUS:
+            case TK_MINUS:
+            case TK_ASTERISK:
+                return is_integer_expression(*b->lhs, table) and is_integer_expression(*b->rhs, table);
+            case TK_SLASH:
+            case TK_PERCENT: {
+                auto divisor = fold_integer(*b->rhs);
+                return divisor and *divisor != 0 and is_integer_expression(*b->lhs, table);
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+/** Returns the integer \p e evaluates to for \p row, reading attributes from \p columns, indexed by attribute id, or
+ * nothing if it evaluates to NULL, i.e. if any attribute it reads is NULL. */
+std::optional<int64_t> evaluate_integer(const ast::Expr &e, const std::vector<LayoutColumn> &columns, std::size_t row)
+{
+    if (auto attr = designated_attribute(e)) {
+        auto &column = columns[attr->id];
+        if (column.is_null(row))
+            return std::nullopt;
+        return load_integer(column.at(row), column.size);
+    }
+    if (auto value = fold_integer(e))
+        return *value;
+    if (auto u = cast<const ast::UnaryExpr>(&e)) {
+        auto value = evaluate_integer(*u->expr, columns, row);
+        return value ? arithmetic(u->op().type, 0, *value) : std::nullopt;
+    }
+    auto &b = as<const ast::BinaryExpr>(e);
+    auto lhs = evaluate_integer(*b.lhs, columns, row), rhs = evaluate_integer(*b.rhs, columns, row);
+    return lhs and rhs ? arithmetic(b.op().type, *lhs, *rhs) : std::nullopt;
+}
+
+}
+
+
+SecondaryIndex::SecondaryIndex(const Table &table, const Attribute &attr)
+    : table(table), attr(attr), tree_(nullptr, 0, 0)
+{
+    if (not attr.type->is_integral())
+        throw std::invalid_argument("only integral attributes can be indexed");
+}
+
+void SecondaryIndex::sync(ThreadPool &pool)
+{
+    const std::size_t num_rows = table.store().num_rows();
+    const LayoutColumn column = LayoutColumn::Of(table, attr);
+    if (num_rows_ == 0 or num_rows < num_rows_) {
+        SortedRuns<int64_t, uint32_t> runs(pool);
+        for (std::size_t row = 0; row != num_rows; ++row) {
+            if (not column.is_null(row))
+                runs.push_back(load_integer(column.at(row), column.size), uint32_t(row));
+        }
+        runs.finish();
+        tree_ = tree_type::Bulkload(runs.begin(), runs.end());
+        delta_.clear();
+    } else {
+        for (std::size_t row = num_rows_; row != num_rows; ++row) {
+            if (not column.is_null(row))
+                delta_.emplace(load_integer(column.at(row), column.size), uint32_t(row)); // after equal values
+        }
+        if (delta_.size() * MERGE_RATIO > tree_.size())
+            merge_delta();
+    }
+    num_rows_ = num_rows;
+}
+
+void SecondaryIndex::merge_delta()
+{
+    std::vector<std::pair<int64_t, uint32_t>> rows;
+    rows.reserve(tree_.size() + delta_.size());
+    auto delta_it = delta_.cbegin();
+    for (auto it = tree_.cbegin(), end = tree_.cend(); it != end; ++it) {
+        for (; delta_it != delta_.cend() and delta_it->first < (*it).first(); ++delta_it)
+            rows.emplace_back(*delta_it);
+        rows.emplace_back((*it).first(), (*it).second());
+    }
+    rows.insert(rows.end(), delta_it, delta_.cend());
+    tree_ = tree_type::Bulkload(rows.cbegin(), rows.cend());
+    delta_.clear();
+}
+
+std::size_t IndexRangeScan::operator()(ResultWriter &out) const
+{
+    /* Locate the attributes in the store once, the projection only refers to integral and character sequence ones. */
+    const Table &table = index->table;
+    std::vector<LayoutColumn> columns(table.num_attrs());
+    for (auto &attr : table) {
+        if (attr.type->is_integral() or attr.type->is_character_sequence())
+            columns[attr.id] = LayoutColumn::Of(table, attr);
+    }
+
+    std::size_t num_rows = 0;
+    index->for_each_in_range(lo, hi, [&](uint32_t row) {
+        ++num_rows;
+        bool first = true;
+        for (auto e : projection) {
+            auto attr = designated_attribute(*e);
+            auto c = cast<const ast::Constant>(e);
+            if (attr and attr->type->is_character_sequence()) {
+                auto &column = columns[attr->id];
+                const char *str = reinterpret_cast<const char*>(column.at(row));
+                if (column.is_null(row))
+                    out.null_field(*attr->type, first);
+                else
+                    out.field(std::string_view(str, strnlen(str, column.size)), first);
+            } else if (c and c->tok.type == TK_STRING_LITERAL) {
+                out.field(string_literal(*c), first);
+            } else if (auto value = evaluate_integer(*e, columns, row)) {
+                out.field(*value, first);
+            } else {
+                out.null_field(*e->type(), first);
+            }
+            first = false;
+        }
+        out.end_row();
+    });
+    return num_rows;
+}
+
+SecondaryIndex & IndexRegistry::add(const Table &table, const char *attr)
+{
+    return *indexes_.emplace_back(std::make_unique<SecondaryIndex>(table, table.at(attr)));
+}
+
+const SecondaryIndex * IndexRegistry::find(const Attribute &attr) const
+{
+    for (auto &index : indexes_) {
+        if (&index->attr == &attr)
+            return index.get();
+    }
+    return nullptr;
+}
+
+void IndexRegistry::sync(ThreadPool &pool)
+{
+    for (auto &index : indexes_) {
+        if (index->is_stale())
+            index->sync(pool);
+    }
+}
+
+std::optional<IndexRangeScan> IndexRegistry::route(const ast::SelectStmt &query) const
+{
+    if (not query.where or query.group_by or query.having or query.order_by or query.limit)
+        return std::nullopt;
+    auto &from = as<const ast::FromClause>(*query.from).from;
+    if (from.size() != 1 or not std::holds_alternative<Token>(from[0].source))
+        return std::nullopt; // no single base table
+
+    /* Intersect the ranges of all conjuncts, each comparing the same indexed attribute with a constant. */
+    IndexRangeScan scan;
+    bool empty = false;
+    std::vector<const ast::Expr*> conjuncts{ as<const ast::WhereClause>(*query.where).where.get() };
+    while (not conjuncts.empty()) {
+        auto bin = cast<const ast::BinaryExpr>(conjuncts.back());
+        conjuncts.pop_back();
+        if (not bin)
+            return std::nullopt;
+        auto op = bin->op().type;
+        if (op == TK_And) {
+            conjuncts.push_back(bin->lhs.get());
+            conjuncts.push_back(bin->rhs.get());
+            continue;
+        }
+
+        /* Normalize the comparison to have the attribute on the left. */
+        auto attr = designated_attribute(*bin->lhs);
+        auto constant = fold_integer(*bin->rhs);
+        if (not attr) {
+            attr = designated_attribute(*bin->rhs);
+            constant = fold_integer(*bin->lhs);
+            switch (op) {
+                case TK_LESS:          op = TK_GREATER;       break;
+                case TK_LESS_EQUAL:    op = TK_GREATER_EQUAL; break;
+                case TK_GREATER:       op = TK_LESS;          break;
+                case TK_GREATER_EQUAL: op = TK_LESS_EQUAL;    break;
+                default: break;
+            }
+        }
+        if (not attr or not constant)
+            return std::nullopt;
+        auto index = find(*attr);
+        if (not index or index->is_stale() or (scan.index and scan.index != index))
+            return std::nullopt;
+        scan.index = index;
+
+        const int64_t c = *constant;
+        constexpr int64_t MIN = std::numeric_limits<int64_t>::min(), MAX = std::numeric_limits<int64_t>::max();
+        switch (op) {
+            case TK_EQUAL:
+                scan.lo = std::max(scan.lo, c);
+                scan.hi = std::min(scan.hi, c);
+                break;
+            case TK_LESS:
+                empty = empty or c == MIN;
+                scan.hi = std::min(scan.hi, c == MIN ? MIN : c - 1);
+                break;
+            case TK_LESS_EQUAL:
+                scan.hi = std::min(scan.hi, c);
+                break;
+            case TK_GREATER:
+                empty = empty or c == MAX;
+                scan.lo = std::max(scan.lo, c == MAX ? MAX : c + 1);
+                break;
+            case TK_GREATER_EQUAL:
+                scan.lo = std::max(scan.lo, c);
+                break;
+            default:
+                return std::nullopt;
+        }
+    }
+    if (empty) {
+        scan.lo = std::numeric_limits<int64_t>::max();
+        scan.hi = std::numeric_limits<int64_t>::min();
+    }
+
+    /* Every projection must be evaluable on the rows fetched. */
+    auto &select = as<const ast::SelectClause>(*query.select);
+    if (select.select_all.type != TK_EOF)
+        return std::nullopt;
+    for (auto &[e, alias] : select.select) {
+        auto attr = designated_attribute(*e);
+        auto c = cast<const ast::Constant>(e.get());
+        if (attr and &attr->table == &scan.index->table and attr->type->is_character_sequence())
+            scan.projection.push_back(e.get());
+        else if (c and c->tok.type == TK_STRING_LITERAL and not std::strchr(c->tok.text, '\\'))
+            scan.projection.push_back(e.get());
+        else if (is_integer_expression(*e, scan.index->table))
+            scan.projection.push_back(e.get());
+        else
+            return std::nullopt;
+    }
+    return scan;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "BTree.hpp"
+#include "ResultWriter.hpp"
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <optional>
+#include <vector>
+
+
+/** A secondary index on an integral attribute of a table: a B+-tree mapping the attribute's values to the ids of the
+ * rows of the table's store holding them.  Values are read directly from the store.  Rows whose value is NULL are not
+ * indexed, as no comparison with NULL holds.
+ *
+ * As the tree cannot insert, rows appended to the store after it was bulkloaded are kept in a sorted delta, which is
+ * merged into a freshly bulkloaded tree once it exceeds `1 / MERGE_RATIO` of the tree.  Hence, every row is bulkloaded
+ * amortized O(1) times. */
+struct SecondaryIndex
+{
+    static constexpr std::size_t NODE_SIZE = 4096;
+    static constexpr std::size_t MERGE_RATIO = 8;
+    using tree_type = BTree<int64_t, uint32_t, NODE_SIZE>;
+
+    const m::Table &table;
+    const m::Attribute &attr;
+
+    private:
+    tree_type tree_;
+    std::multimap<int64_t, uint32_t> delta_; ///< the rows appended since the tree was bulkloaded, in ascending order
+    std::size_t num_rows_ = 0; ///< the number of rows of the store indexed
+
+    public:
+    /** Declares an empty index on \p attr of \p table.  Throws `std::invalid_argument` if \p attr is not integral. */
+    SecondaryIndex(const m::Table &table, const m::Attribute &attr);
+
+    /** Returns the number of rows indexed. */
+    std::size_t num_rows() const { return num_rows_; }
+    /** Returns whether the store of the table has changed in size since the last `sync()`. */
+    bool is_stale() const { return table.store().num_rows() != num_rows_; }
+
+    /** Brings the index in sync with the store of the table.  Initially, or if the store shrank, all its rows are
+     * bulkloaded, sorted in chunks on \p pool.  Otherwise, only the rows appended since the last `sync()` are added to
+     * the delta. */
+    void sync(ThreadPool &pool);
+
+    /** Invokes \p fn with the id of every row whose value is in `[lo, hi]`, in ascending order of values and of row
+     * ids for equal values. */
+    template<typename Fn>
+    void for_each_in_range(int64_t lo, int64_t hi, Fn &&fn) const
+    {
+        if (lo > hi)
+            return;
+        /* Merge the rows of the tree and the delta.  Rows of the delta were appended later, so they come last among
+         * equal values. */
+        auto it = tree_.find_range(lo, lo).begin();
+        const auto end = tree_.cend();
+        auto delta_it = delta_.lower_bound(lo);
+        const auto delta_end = delta_.upper_bound(hi);
+        for (; it != end and (*it).first() <= hi; ++it) {
+            for (; delta_it != delta_end and delta_it->first < (*it).first(); ++delta_it)
+                fn(delta_it->second);
+            fn((*it).second());
+        }
+        for (; delta_it != delta_end; ++delta_it)
+            fn(delta_it->second);
+    }
+
+    private:
+    /** Bulkloads the tree from its rows merged with the delta, freeing the previous tree, and empties the delta. */
+    void merge_delta();
+};
+
+/** A query `SELECT <projection> FROM T WHERE <range>` answered by a range scan of a `SecondaryIndex` on `T` and by
+ * fetching the rows found from the store of `T`.  The projection refers to the expressions of the query, which must
+ * outlive the scan. */
+struct IndexRangeScan
+{
+    const SecondaryIndex *index = nullptr;
+    int64_t lo = std::numeric_limits<int64_t>::min(); ///< the smallest value in range
+    int64_t hi = std::numeric_limits<int64_t>::max(); ///< the largest value in range
+    std::vector<const m::ast::Expr*> projection; ///< the expressions of the `SELECT` clause
+
+    /** Writes the rows of the result, in ascending order of the indexed attribute, to \p out.  Returns their number.
+     * Projections of NULL values, e.g. `a + 1` for `a` NULL, are written as NULL. */
+    std::size_t operator()(ResultWriter &out) const;
+};
+
+/** The secondary indexes declared on tables, and the routing of range queries to them. */
+struct IndexRegistry
+{
+    private:
+    std::vector<std::unique_ptr<SecondaryIndex>> indexes_;
+
+    public:
+    /** Declares an index on the attribute named \p attr of \p table and returns it.  The index is empty until the next
+     * `sync()`. */
+    SecondaryIndex & add(const m::Table &table, const char *attr);
+
+    /** Returns the index on \p attr, if any. */
+    const SecondaryIndex * find(const m::Attribute &attr) const;
+
+    /** Brings every stale index in sync with the store of its table. */
+    void sync(ThreadPool &pool);
+
+    /** Returns the index range scan answering \p query, if any.  That requires \p query to read a single table, to
+     * filter it by a conjunction of comparisons of one attribute with an index in sync with integer constants, to
+     * project to integral and character sequence attributes, constants, and integer arithmetic, and to have no other
+     * clauses. */
+    std::optional<IndexRangeScan> route(const m::ast::SelectStmt &query) const;
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "JoinPredicates.hpp"
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <utility>
+#include <vector>
+
+
+/** A join ordering DP for queries of exactly `N` data sources, `N` being at most 16.  Subproblems are `uint16_t`
+ * masks indexing dense arrays of 2^N entries, and the neighbourhood of a subproblem is a fully unrolled fold over
+ * the rows of the adjacency matrix.  Subproblems are enumerated in increasing numeric order, hence every subset of a
+ * subproblem is final before the subproblem itself is considered.
+ *
+ * The DP minimizes C_out, i.e. the sum of the cardinalities of all intermediate results, as `m::CostFunctionCout`
+ * does.  Since the cardinality of a subproblem does not depend on how it is split, the DP estimates every connected
+ * subproblem exactly once, for its best split, instead of once per split. */
+template<unsigned N>
+struct SmallQueryDP
+{
+    static_assert(1 <= N and N <= 16, "the kernel supports only up to 16 data sources");
+
+    using mask_type = uint16_t;
+    static constexpr std::size_t NUM_SUBPROBLEMS = std::size_t(1) << N;
+
+    private:
+    std::array<mask_type, N> adjacency_{};
+    std::vector<double> cost_; ///< the cost of the best plan per subproblem, infinity if there is none
+    std::vector<mask_type> left_; ///< the left input of the best plan per subproblem
+    std::vector<std::unique_ptr<m::DataModel>> models_;
+
+    public:
+    SmallQueryDP()
+        : cost_(NUM_SUBPROBLEMS, std::numeric_limits<double>::infinity())
+        , left_(NUM_SUBPROBLEMS, 0)
+        , models_(NUM_SUBPROBLEMS)
+    { }
+
+    /** Computes the best plans for all connected subproblems of \p G and writes them to \p PT.  The entries of \p PT
+     * for the single data sources must already be initialized. */
+    template<typename PlanTable>
+    static void enumerate(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE)
+    {
+        SmallQueryDP DP;
+        DP.run(PT, G, CE);
+    }
+
+    private:
+    /** Returns the union of the neighbours of all data sources in \p S. */
+    mask_type neighbours(mask_type S) const
+    {
+        return [this, S]<std::size_t... I>(std::index_sequence<I...>) {
+            return mask_type(((S >> I & 1U ? adjacency_[I] : 0U) | ...));
+        }(std::make_index_sequence<N>{});
+    }
+
+    template<typename PlanTable>
+    void run(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE)
+    {
+        const m::AdjacencyMatrix &M = G.adjacency_matrix();
+        const JoinPredicates predicates(G);
+
+        for (unsigned i = 0; i != N; ++i) {
+            for (unsigned j = 0; j != N; ++j) {
+                if (i != j and M.is_connected(m::SmallBitset(1UL << i), m::SmallBitset(1UL << j)))
+                    adjacency_[i] |= mask_type(1U << j);
+            }
+            cost_[1U << i] = PT[m::SmallBitset(1UL << i)].cost;
+        }
+
+        auto model = [&](mask_type S) -> const m::DataModel & {
+            return std::has_single_bit(S) ? *PT[m::SmallBitset(S)].model : *models_[S];
+        };
+
+        for (std::size_t s = 3; s < NUM_SUBPROBLEMS; ++s) {
+            const mask_type S(s);
+            if (std::has_single_bit(S))
+                continue;
+
+            /* Consider every split once, with the lowest data source of `S` on the left. */
+            const mask_type lowest = S & -S;
+            const mask_type rest = S ^ lowest;
+            double best = std::numeric_limits<double>::infinity();
+            mask_type best_left = 0;
+            for (mask_type x = 0; x != rest; x = (x - rest) & rest) {
+                const mask_type L = lowest | x, R = S ^ L;
+                const double cost = cost_[L] + cost_[R];
+                if (cost < best and (neighbours(L) & R)) {
+                    best = cost;
+                    best_left = L;
+                }
+            }
+            if (not best_left)
+                continue; // `S` is not connected
+
+            models_[S] = CE.estimate_join(G, model(best_left), model(S ^ best_left),
+                                          predicates.between(best_left, S ^ best_left));
+            cost_[S] = best + CE.predict_cardinality(*models_[S]);
+            left_[S] = best_left;
+        }
+
+        /* Write all plans back. */
+        for (std::size_t s = 3; s < NUM_SUBPROBLEMS; ++s) {
+            if (not models_[s])
+                continue;
+            auto &entry = PT[m::SmallBitset(s)];
+            entry.left = m::SmallBitset(left_[s]);
+            entry.right = m::SmallBitset(s ^ left_[s]);
+            entry.cost = cost_[s];
+            entry.model = std::move(models_[s]);
+        }
+    }
+};
+
+/** Runs the `SmallQueryDP` specialized for the number of data sources of \p G.  Returns `false`, without modifying
+ * \p PT, if \p G has more than 16 data sources. */
+template<typename PlanTable>
+bool enumerate_small_query(PlanTable &PT, const m::QueryGraph &G, const m::CardinalityEstimator &CE)
+{
+    using kernel_type = void(*)(PlanTable&, const m::QueryGraph&, const m::CardinalityEstimator&);
+    static constexpr auto kernels = []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<kernel_type, sizeof...(I)>{ &SmallQueryDP<I + 1>::template enumerate<PlanTable>... };
+    }(std::make_index_sequence<16>{});
+
+    const std::size_t num_sources = G.num_sources();
+    if (num_sources == 0 or num_sources > kernels.size())
+        return false;
+    kernels[num_sources - 1](PT, G, CE);
+    return true;
+}
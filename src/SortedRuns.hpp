@@ -0,0 +1,140 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+
+/** Sorts a stream of key-value pairs, e.g. to bulkload a `BTree`, without collecting the entire stream first.
+ *
+ * The pairs are appended to chunks of a fixed size.  Every full chunk is sorted by a worker of the thread pool while
+ * the stream continues.  After `finish()`, the sorted chunks, or runs, are merged lazily by a single-pass input
+ * iterator, which releases every run as soon as it is exhausted.  Hence, every pair is held in memory only once, and
+ * while the merged pairs are consumed, e.g. by `BTree::Bulkload()`, the runs shrink as the consumer grows. */
+template<typename Key, typename Value>
+struct SortedRuns
+{
+    using value_type = std::pair<Key, Value>;
+    using run_type = std::vector<value_type>;
+
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 1UL << 16; ///< pairs per chunk
+
+    /** An input iterator over the pairs of all runs in ascending order.  Advancing it releases exhausted runs, so
+     * copies of it must not be advanced independently. */
+    struct iterator
+    {
+        using iterator_category = std::input_iterator_tag;
+        using value_type = SortedRuns::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        private:
+        struct Cursor
+        {
+            run_type *run;
+            std::size_t pos;
+
+            const value_type & get() const { return (*run)[pos]; }
+        };
+        std::vector<Cursor> heap_; ///< min-heap of the runs not yet exhausted, by their next pair
+
+        static bool greater(const Cursor &lhs, const Cursor &rhs) { return lhs.get() > rhs.get(); }
+
+        public:
+        iterator() = default;
+        explicit iterator(std::deque<run_type> &runs)
+        {
+            for (auto &run : runs) {
+                if (not run.empty())
+                    heap_.push_back({ &run, 0 });
+            }
+            std::make_heap(heap_.begin(), heap_.end(), greater);
+        }
+
+        reference operator*() const { return heap_.front().get(); }
+        pointer operator->() const { return &heap_.front().get(); }
+
+        iterator & operator++()
+        {
+            std::pop_heap(heap_.begin(), heap_.end(), greater);
+            auto &cursor = heap_.back();
+            if (++cursor.pos == cursor.run->size()) {
+                run_type().swap(*cursor.run); // release the exhausted run
+                heap_.pop_back();
+            } else {
+                std::push_heap(heap_.begin(), heap_.end(), greater);
+            }
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        bool operator==(const iterator &other) const
+        {
+            if (heap_.empty() or other.heap_.empty())
+                return heap_.empty() == other.heap_.empty();
+            return heap_.front().run == other.heap_.front().run and heap_.front().pos == other.heap_.front().pos;
+        }
+    };
+
+    private:
+    ThreadPool &pool_;
+    std::size_t chunk_size_;
+    std::deque<run_type> runs_; ///< the full chunks; a deque keeps them in place while the workers sort them
+    run_type chunk_; ///< the chunk being filled
+    std::size_t size_ = 0;
+
+    public:
+    /** Creates empty runs, sorting every chunk of \p chunk_size pairs on \p pool. */
+    explicit SortedRuns(ThreadPool &pool, std::size_t chunk_size = DEFAULT_CHUNK_SIZE)
+        : pool_(pool), chunk_size_(std::max<std::size_t>(1, chunk_size))
+    {
+        chunk_.reserve(chunk_size_);
+    }
+
+    SortedRuns(const SortedRuns&) = delete;
+    SortedRuns & operator=(const SortedRuns&) = delete;
+
+    ~SortedRuns() { pool_.wait(); }
+
+    /** Returns the number of pairs appended. */
+    std::size_t size() const { return size_; }
+    /** Returns the number of runs, i.e. of full chunks and, after `finish()`, the last chunk. */
+    std::size_t num_runs() const { return runs_.size(); }
+
+    /** Appends the pair of \p key and \p value.  Must not be called after `finish()`. */
+    void push_back(Key key, Value value)
+    {
+        chunk_.emplace_back(std::move(key), std::move(value));
+        ++size_;
+        if (chunk_.size() == chunk_size_)
+            seal();
+    }
+
+    /** Sorts the last chunk and waits until all runs are sorted. */
+    void finish()
+    {
+        if (not chunk_.empty())
+            seal();
+        chunk_ = run_type(); // release the reserved chunk
+        pool_.wait();
+    }
+
+    /** Returns an iterator to the smallest pair.  Must only be called after `finish()` and only once. */
+    iterator begin() { return iterator(runs_); }
+    iterator end() { return iterator(); }
+
+    private:
+    /** Turns the current chunk into a run and submits sorting it to the pool. */
+    void seal()
+    {
+        auto &run = runs_.emplace_back(std::move(chunk_));
+        pool_.submit([&run]() { std::sort(run.begin(), run.end()); });
+        chunk_ = run_type();
+        chunk_.reserve(chunk_size_);
+    }
+};
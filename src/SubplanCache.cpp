@@ -0,0 +1,152 @@
+#include "SubplanCache.hpp"
+#include "JoinPredicates.hpp"
+#include <algorithm>
+#include <bit>
+#include <sstream>
+#include <tuple>
+
+using namespace m;
+
+
+CanonicalSubproblem::CanonicalSubproblem(const QueryGraph &G, uint64_t S)
+{
+    std::vector<std::tuple<std::string_view, std::size_t, const BaseTable*>> sources;
+    for (auto ds : G.sources()) {
+        if (not (S >> ds->id() & 1UL))
+            continue;
+        auto bt = cast<const BaseTable>(ds);
+        if (not bt)
+            return; // a nested query, which is not shared
+        sources.emplace_back(ds->alias() ? ds->alias() : ds->name(), ds->id(), bt);
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::ostringstream oss;
+    for (auto [name, id, bt] : sources) {
+        oss << name << '=' << bt->table().name << '[' << bt->filter() << "];";
+        ids.push_back(id);
+    }
+
+    std::vector<std::string> conditions;
+    for (auto join : G.joins()) {
+        uint64_t sources = 0;
+        for (auto ds : join->sources())
+            sources |= 1UL << ds->id();
+        if ((sources & S) == sources) {
+            std::ostringstream condition;
+            condition << join->condition();
+            conditions.push_back(condition.str());
+        }
+    }
+    std::sort(conditions.begin(), conditions.end());
+    for (auto &condition : conditions)
+        oss << condition << ';';
+    key = oss.str();
+}
+
+uint64_t CanonicalSubproblem::to_canonical(uint64_t S) const
+{
+    uint64_t C = 0;
+    for (std::size_t p = 0; p != ids.size(); ++p)
+        C |= (S >> ids[p] & 1UL) << p;
+    return C;
+}
+
+uint64_t CanonicalSubproblem::from_canonical(uint64_t C) const
+{
+    uint64_t S = 0;
+    for (std::size_t p = 0; p != ids.size(); ++p)
+        S |= (C >> p & 1UL) << ids[p];
+    return S;
+}
+
+namespace {
+
+/** Collects the joins of the plan for \p S in \p PT bottom up.  The joins of the subplan of every join are the
+ * `|S| - 1` joins ending at it. */
+template<typename PlanTable>
+void collect_joins(const PlanTable &PT, uint64_t S, std::vector<std::pair<uint64_t, uint64_t>> &joins)
+{
+    auto &entry = PT[SmallBitset(S)];
+    if (not uint64_t(entry.left) or not uint64_t(entry.right))
+        return; // a data source
+    collect_joins(PT, uint64_t(entry.left), joins);
+    collect_joins(PT, uint64_t(entry.right), joins);
+    joins.emplace_back(uint64_t(entry.left), uint64_t(entry.right));
+}
+
+}
+
+std::size_t SubplanCache::size()
+{
+    std::lock_guard lock(mutex_);
+    return plans_.size();
+}
+
+template<typename PlanTable>
+void SubplanCache::add(const PlanTable &PT, const QueryGraph &G, std::string_view estimator)
+{
+    if (G.num_sources() < 2)
+        return;
+    std::vector<std::pair<uint64_t, uint64_t>> joins;
+    collect_joins(PT, ~0UL >> (64 - G.num_sources()), joins);
+
+    /* Cross products between connected components are not planned by enumeration, hence not shared. */
+    const AdjacencyMatrix &M = G.adjacency_matrix();
+    std::vector<std::pair<std::string, std::vector<std::pair<uint64_t, uint64_t>>>> subplans;
+    std::size_t connected = 0; // the number of connected joins ending at the current one
+    for (std::size_t i = 0; i != joins.size(); ++i) {
+        const auto [left, right] = joins[i];
+        connected = M.is_connected(SmallBitset(left), SmallBitset(right)) ? connected + 1 : 0;
+        const std::size_t num_joins = std::popcount(left | right) - 1;
+        if (connected < num_joins)
+            continue;
+
+        CanonicalSubproblem canonical(G, left | right);
+        if (canonical.key.empty())
+            continue;
+        std::vector<std::pair<uint64_t, uint64_t>> plan;
+        for (std::size_t j = i + 1 - num_joins; j <= i; ++j)
+            plan.emplace_back(canonical.to_canonical(joins[j].first), canonical.to_canonical(joins[j].second));
+        subplans.emplace_back(std::string(estimator) + '\0' + canonical.key, std::move(plan));
+    }
+
+    std::lock_guard lock(mutex_);
+    if (plans_.size() + subplans.size() > MAX_PLANS)
+        plans_.clear();
+    for (auto &[key, plan] : subplans)
+        plans_.try_emplace(std::move(key), std::move(plan));
+}
+
+template<typename PlanTable>
+bool SubplanCache::replay(PlanTable &PT, const QueryGraph &G, std::string_view estimator,
+                          const CardinalityEstimator &CE, const CostFunction &CF)
+{
+    if (G.num_sources() < 2)
+        return false;
+    const CanonicalSubproblem canonical(G, ~0UL >> (64 - G.num_sources()));
+    if (canonical.key.empty())
+        return false;
+
+    std::vector<std::pair<uint64_t, uint64_t>> plan;
+    {
+        std::lock_guard lock(mutex_);
+        auto it = plans_.find(std::string(estimator) + '\0' + canonical.key);
+        if (it == plans_.end())
+            return false;
+        plan = it->second;
+    }
+
+    const JoinPredicates predicates(G);
+    for (auto [l, r] : plan) {
+        const uint64_t left = canonical.from_canonical(l), right = canonical.from_canonical(r);
+        PT.update(G, CE, CF, SmallBitset(left), SmallBitset(right), predicates.between(left, right));
+    }
+    return true;
+}
+
+template void SubplanCache::add<PlanTableSmallOrDense>(const PlanTableSmallOrDense &, const QueryGraph &, std::string_view);
+template void SubplanCache::add<PlanTableLargeAndSparse>(const PlanTableLargeAndSparse &, const QueryGraph &, std::string_view);
+
+template bool SubplanCache::replay<PlanTableSmallOrDense>(PlanTableSmallOrDense &, const QueryGraph &, std::string_view, const CardinalityEstimator &, const CostFunction &);
+template bool SubplanCache::replay<PlanTableLargeAndSparse>(PlanTableLargeAndSparse &, const QueryGraph &, std::string_view, const CardinalityEstimator &, const CostFunction &);
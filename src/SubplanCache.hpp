@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutable/mutable.hpp>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+
+/** A subproblem of a query graph in a form independent of the order of the data sources in the query: its data
+ * sources in ascending order of their names, each with its table and filter, followed by the conditions of the joins
+ * between them in ascending order.  Subproblems of the same canonical form have the same plans and cardinalities for
+ * the same cardinality estimates. */
+struct CanonicalSubproblem
+{
+    std::string key; ///< the canonical form, empty if the subproblem cannot be shared, e.g. for nested queries
+    std::vector<std::size_t> ids; ///< the ids of the data sources of the subproblem, in canonical order
+
+    CanonicalSubproblem(const m::QueryGraph &G, uint64_t S);
+
+    /** Translates the data sources \p S of the subproblem to their positions in canonical order. */
+    uint64_t to_canonical(uint64_t S) const;
+    /** Translates the positions \p C in canonical order to the data sources of the subproblem. */
+    uint64_t from_canonical(uint64_t C) const;
+};
+
+/** The plans of the connected subproblems of the queries optimized so far, shared across queries by canonical
+ * subproblem and cardinality estimates.  Every subplan of a plan optimized exactly is the best plan for its own
+ * subproblem, hence a query of the same canonical form as a subproblem optimized before, e.g. a common subexpression
+ * of several queries, is planned by replaying that subplan instead of enumerating.  Thread-safe. */
+struct SubplanCache
+{
+    ///> the maximum number of subplans; the cache is cleared when it would exceed this
+    static constexpr std::size_t MAX_PLANS = 1UL << 16;
+
+    private:
+    std::mutex mutex_;
+    ///> the joins of every subplan bottom up, by the canonical positions of their data sources, by estimator and
+    ///> canonical subproblem
+    std::unordered_map<std::string, std::vector<std::pair<uint64_t, uint64_t>>> plans_;
+
+    public:
+    std::size_t size();
+
+    /** Adds the subplans of all connected subproblems of the final plan of \p PT, the plan table of \p G computed with
+     * the estimates identified by \p estimator, e.g. the name of the cardinality file. */
+    template<typename PlanTable>
+    void add(const PlanTable &PT, const m::QueryGraph &G, std::string_view estimator);
+
+    /** Enters the plan of \p G into \p PT, whose data sources must be initialized, if a subproblem of the same
+     * canonical form was added for the same \p estimator.  Returns whether it did. */
+    template<typename PlanTable>
+    bool replay(PlanTable &PT, const m::QueryGraph &G, std::string_view estimator, const m::CardinalityEstimator &CE,
+                const m::CostFunction &CF);
+};
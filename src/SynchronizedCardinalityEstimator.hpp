@@ -0,0 +1,68 @@
+#pragma once
+
+#include <mutable/mutable.hpp>
+#include <mutex>
+
+
+/** Forwards all estimates to another `CardinalityEstimator` while holding a mutex.  Estimators may use global state
+ * of mutable, e.g. the string pool of the `Catalog`, so concurrent optimizations share one mutex with all other users
+ * of that state.  The DP computes the model of every subproblem only once, so the lock is taken about once per
+ * subproblem and enumeration itself runs in parallel.  `predict_cardinality()` only reads a model and is called for
+ * every join considered, hence it is not synchronized. */
+struct SynchronizedCardinalityEstimator : m::CardinalityEstimator
+{
+    using Subproblem = m::SmallBitset;
+
+    private:
+    const m::CardinalityEstimator &estimator_;
+    std::mutex &mutex_;
+
+    public:
+    SynchronizedCardinalityEstimator(const m::CardinalityEstimator &estimator, std::mutex &mutex)
+        : estimator_(estimator), mutex_(mutex)
+    { }
+
+    std::unique_ptr<m::DataModel> empty_model() const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.empty_model();
+    }
+
+    std::unique_ptr<m::DataModel> estimate_scan(const m::QueryGraph &G, Subproblem P) const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.estimate_scan(G, P);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_filter(const m::QueryGraph &G, const m::DataModel &data,
+                                                  const m::cnf::CNF &filter) const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.estimate_filter(G, data, filter);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_limit(const m::QueryGraph &G, const m::DataModel &data, std::size_t limit,
+                                                 std::size_t offset) const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.estimate_limit(G, data, limit, offset);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_grouping(const m::QueryGraph &G, const m::DataModel &data,
+                                                    const std::vector<const m::ast::Expr*> &groups) const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.estimate_grouping(G, data, groups);
+    }
+
+    std::unique_ptr<m::DataModel> estimate_join(const m::QueryGraph &G, const m::DataModel &left,
+                                                const m::DataModel &right,
+                                                const m::cnf::CNF &condition) const override {
+        std::lock_guard lock(mutex_);
+        return estimator_.estimate_join(G, left, right, condition);
+    }
+
+    std::size_t predict_cardinality(const m::DataModel &data) const override {
+        return estimator_.predict_cardinality(data);
+    }
+
+    void print(std::ostream &out) const override {
+        out << "synchronized ";
+        estimator_.print(out);
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/** A fixed-size pool of worker threads executing submitted tasks in FIFO order. */
+struct ThreadPool
+{
+    private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    std::condition_variable all_done_;
+    std::size_t num_pending_ = 0; ///< number of tasks submitted but not yet finished
+    bool stop_ = false;
+
+    public:
+    /** Creates a pool of \p num_threads workers, by default one per hardware thread. */
+    explicit ThreadPool(std::size_t num_threads = std::thread::hardware_concurrency())
+    {
+        if (num_threads == 0)
+            num_threads = 1;
+        for (std::size_t i = 0; i != num_threads; ++i)
+            workers_.emplace_back([this]() { work(); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool & operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        task_available_.notify_all();
+        for (auto &t : workers_)
+            t.join();
+    }
+
+    std::size_t num_threads() const { return workers_.size(); }
+
+    /** Submits \p task for execution by some worker. */
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard lock(mutex_);
+            tasks_.push_back(std::move(task));
+            ++num_pending_;
+        }
+        task_available_.notify_one();
+    }
+
+    /** Blocks until all submitted tasks are finished. */
+    void wait()
+    {
+        std::unique_lock lock(mutex_);
+        all_done_.wait(lock, [this]() { return num_pending_ == 0; });
+    }
+
+    /** Invokes \p fn with every index in `[0, n)` on the workers, in chunks of \p grain indices, and waits for all
+     * invocations to finish. */
+    template<typename Fn>
+    void parallel_for(std::size_t n, std::size_t grain, Fn &&fn)
+    {
+        if (grain == 0)
+            grain = 1;
+        for (std::size_t begin = 0; begin < n; begin += grain) {
+            const std::size_t end = std::min(begin + grain, n);
+            submit([&fn, begin, end]() {
+                for (std::size_t i = begin; i != end; ++i)
+                    fn(i);
+            });
+        }
+        wait();
+    }
+
+    private:
+    void work()
+    {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                task_available_.wait(lock, [this]() { return stop_ or not tasks_.empty(); });
+                if (tasks_.empty())
+                    return; // stopped and drained
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+            {
+                std::lock_guard lock(mutex_);
+                if (--num_pending_ == 0)
+                    all_done_.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+/** A `std::streambuf` reading from and writing to a file descriptor, e.g. a connected socket.  Writes are buffered and
+ * issued as one `write()` per flush. */
+struct FdStreamBuf : std::streambuf
+{
+    static constexpr std::size_t BUFFER_SIZE = 1UL << 16;
+
+    private:
+    int fd_;
+    char in_[BUFFER_SIZE];
+    char out_[BUFFER_SIZE];
+
+    public:
+    explicit FdStreamBuf(int fd) : fd_(fd)
+    {
+        setg(in_, in_, in_);
+        setp(out_, out_ + BUFFER_SIZE);
+    }
+
+    ~FdStreamBuf() { sync(); }
+
+    protected:
+    int_type underflow() override
+    {
+        ssize_t n;
+        do
+            n = ::read(fd_, in_, BUFFER_SIZE);
+        while (n < 0 and errno == EINTR);
+        if (n <= 0)
+            return traits_type::eof();
+        setg(in_, in_, in_ + n);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type c) override
+    {
+        if (sync() != 0)
+            return traits_type::eof();
+        if (not traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        const char *p = pbase();
+        while (p != pptr()) {
+            const ssize_t n = ::write(fd_, p, pptr() - p);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return -1;
+            }
+            p += n;
+        }
+        setp(out_, out_ + BUFFER_SIZE);
+        return 0;
+    }
+};
+
+/** A `std::iostream` over a connected socket, closing the socket on destruction. */
+struct SocketStream : std::iostream
+{
+    private:
+    int fd_;
+    FdStreamBuf buf_;
+
+    public:
+    explicit SocketStream(int fd) : std::iostream(nullptr), fd_(fd), buf_(fd) { rdbuf(&buf_); }
+    ~SocketStream() { buf_.pubsync(); ::close(fd_); }
+};
+
+/** Listens for connections on a Unix domain stream socket bound to a path in the file system. */
+struct UnixSocketListener
+{
+    private:
+    int fd_ = -1;
+    std::filesystem::path path_;
+
+    public:
+    explicit UnixSocketListener(std::filesystem::path path, int backlog = 64) : path_(std::move(path))
+    {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path_.native().size() >= sizeof(addr.sun_path))
+            throw std::invalid_argument("socket path too long");
+        std::strcpy(addr.sun_path, path_.c_str());
+
+        fd_ = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd_ < 0)
+            throw std::runtime_error(std::string("socket(): ") + std::strerror(errno));
+        ::unlink(path_.c_str()); // remove a stale socket of a previous run
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 or ::listen(fd_, backlog) != 0) {
+            const std::string msg = std::string("bind()/listen(): ") + std::strerror(errno);
+            ::close(fd_);
+            throw std::runtime_error(msg);
+        }
+    }
+
+    UnixSocketListener(const UnixSocketListener&) = delete;
+    UnixSocketListener & operator=(const UnixSocketListener&) = delete;
+
+    ~UnixSocketListener()
+    {
+        ::close(fd_);
+        ::unlink(path_.c_str());
+    }
+
+    /** Blocks until a client connects and returns the connected socket, or -1 on error. */
+    int accept()
+    {
+        int client;
+        do
+            client = ::accept(fd_, nullptr, nullptr);
+        while (client < 0 and errno == EINTR);
+        return client;
+    }
+};
+
+/** Connects to the Unix domain stream socket at \p path.  Returns the connected socket, or -1 on error. */
+inline int connect_unix_socket(const std::filesystem::path &path)
+{
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.native().size() >= sizeof(addr.sun_path))
+        return -1;
+    std::strcpy(addr.sun_path, path.c_str());
+
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
@@ -1,20 +1,46 @@
 #include "data_layouts.hpp"
+#include "ResultWriter.hpp"
+#include "SecondaryIndex.hpp"
+#include "ThreadPool.hpp"
 #include <cerrno>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <mutable/lex/Lexer.hpp>
 #include <mutable/mutable.hpp>
+#include <mutable/parse/Parser.hpp>
+#include <mutable/parse/Sema.hpp>
+#include <optional>
+#include <string>
+#include <vector>
 
 
 int main(int argc, const char **argv)
 {
-    /* Check the number of parameters. */
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <Layout> <CSV-File> <SQL-File>" << std::endl;
+    /* Check the parameters. */
+    std::optional<ResultWriter::Format> format = ResultWriter::Format::Text;
+    std::vector<const char*> indexed_attributes;
+    bool valid = argc >= 4;
+    for (int i = 4; valid and i < argc; i += 2) {
+        if (i + 1 == argc)
+            valid = false;
+        else if (std::strcmp(argv[i], "--format") == 0)
+            valid = bool(format = ResultWriter::ParseFormat(argv[i + 1]));
+        else if (std::strcmp(argv[i], "--index") == 0)
+            indexed_attributes.push_back(argv[i + 1]);
+        else
+            valid = false;
+    }
+    if (not valid) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <Layout> <CSV-File> <SQL-File> [--format <text|csv|binary>] [--index <ATTRIBUTE>]...\n\n"
+                  << "With --index, range queries on the integral ATTRIBUTE of `packages` are answered by scanning a "
+                     "B+-tree index on it." << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -57,8 +83,54 @@ int main(int argc, const char **argv)
     if (diag.num_errors())
         exit(EXIT_FAILURE);
 
-    /* Process the SQL file. */
-    m::execute_file(diag, argv[3]);
+    /* Build the secondary indexes on the packages loaded. */
+    ThreadPool pool;
+    IndexRegistry indexes;
+    for (auto attr : indexed_attributes) {
+        try {
+            indexes.add(T, C.pool(attr));
+        } catch (std::exception &e) {
+            std::cerr << "cannot index attribute " << attr << ": " << e.what() << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+    indexes.sync(pool);
+
+    /* Process the SQL file statement by statement, writing the results of queries through one buffer.  Statements are
+     * read by mutable's lexer and parser, so that a `;` in a string literal or comment does not end a statement. */
+    ResultWriter out(STDOUT_FILENO, *format);
+    std::ifstream in(argv[3]);
+    if (not in) {
+        std::cerr << "cannot read " << argv[3] << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    m::ast::Lexer lexer(diag, C.get_pool(), argv[3], in);
+    m::ast::Parser parser(lexer);
+    m::ast::Sema sema(diag);
+    while (parser.token().type != m::TK_EOF) {
+        std::unique_ptr<m::ast::Stmt> stmt(parser.parse());
+        if (diag.num_errors() or not stmt)
+            exit(EXIT_FAILURE);
+        sema(*stmt);
+        if (diag.num_errors())
+            exit(EXIT_FAILURE);
+        std::cout.flush(); // keep the order of mutable's and our output
+        if (auto query = m::cast<const m::ast::SelectStmt>(stmt.get())) {
+            if (auto scan = indexes.route(*query)) {
+                (*scan)(out);
+                out.flush();
+                continue;
+            }
+            auto callback = std::make_unique<m::CallbackOperator>([&out](const m::Schema &S, const m::Tuple &t) {
+                out.tuple(S, t);
+            });
+            m::execute_query(diag, *query, std::move(callback));
+        } else {
+            m::execute_statement(diag, *stmt);
+            indexes.sync(pool); // keep the indexes in sync with statements changing the store, e.g. `INSERT`
+        }
+        out.flush();
+    }
 
     m::Catalog::Destroy();
     exit(EXIT_SUCCESS);
@@ -1,16 +1,40 @@
 #include "BTree.hpp"
+#include "LayoutColumn.hpp"
+#include "ResultWriter.hpp"
+#include "SortedRuns.hpp"
+#include "ThreadPool.hpp"
+#include <chrono>
+#include <cstring>
 #include <memory>
 #include <mutable/mutable.hpp>
-#include <utility>
+#include <optional>
+#include <sys/resource.h>
 
 
 constexpr std::size_t NODE_SIZE = 4096;
 
 int main(int argc, char **argv)
 {
-    /* Check the number of parameters. */
-    if (argc != 4) {
-        std::cerr << "Usage: " << argv[0] << " <CSV-File> <SIZE-MIN> <SIZE-MAX>" << std::endl;
+    using namespace std::chrono;
+    const auto t_begin = steady_clock::now();
+
+    /* Check the parameters. */
+    std::optional<ResultWriter::Format> format = ResultWriter::Format::Text;
+    bool print_stats = false;
+    bool valid = argc >= 4;
+    for (int i = 4; valid and i < argc; ++i) {
+        if (std::strcmp(argv[i], "--format") == 0 and i + 1 < argc)
+            valid = bool(format = ResultWriter::ParseFormat(argv[++i]));
+        else if (std::strcmp(argv[i], "--stats") == 0)
+            print_stats = true;
+        else
+            valid = false;
+    }
+    if (not valid) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <CSV-File> <SIZE-MIN> <SIZE-MAX> [--format <text|csv|binary>] [--stats]\n\n"
+                  << "With --stats, writes a line `index_build,<packages>,<runs>,<build µs>,<µs to first query>,"
+                     "<peak RSS KiB>` to stderr." << std::endl;
         exit(EXIT_FAILURE);
     }
 
@@ -53,29 +77,42 @@ int main(int argc, char **argv)
     if (diag.num_errors())
         exit(EXIT_FAILURE);
 
-    /* Collect all (size,id) pairs. */
-    std::vector<std::pair<int64_t, int32_t>> size2id;
-
-    /* Query the table for all package sizes. */
-    auto stmt = m::statement_from_string(diag, "SELECT size, id FROM packages;");
-    std::unique_ptr<m::ast::SelectStmt> query(static_cast<m::ast::SelectStmt*>(stmt.release()));
-
-    /* Insert all package sizes as (size,id) pairs into `size2id`. */
-    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema&, const m::Tuple &t) {
-        int64_t size = t[0].as_i();
-        int32_t id = t[1].as_i();
-        size2id.emplace_back(size, id);
-    });
-    m::execute_query(diag, *query, std::move(callback));
-
-    /* Sort all (size,id) pairs by size. */
-    std::sort(size2id.begin(), size2id.end(), [](auto left, auto right) { return left.first < right.first; });
+    /* Stream the (size,id) pairs of all packages, read directly from the store, into chunks, which are sorted in
+     * parallel while the store is still being read.  Packages of unknown size are not indexed. */
+    const auto t_build_begin = steady_clock::now();
+    const auto size_column = LayoutColumn::Of(T, "size"), id_column = LayoutColumn::Of(T, "id");
+    ThreadPool pool;
+    SortedRuns<int64_t, int32_t> size2id(pool);
+    for (std::size_t row = 0, num_rows = T.store().num_rows(); row != num_rows; ++row) {
+        if (not size_column.is_null(row))
+            size2id.push_back(load_integer(size_column.at(row), size_column.size),
+                              load_integer(id_column.at(row), id_column.size));
+    }
+    size2id.finish();
 
-    /* Bulkload the sorted (size,id) pairs into a B+-tree. */
+    /* Bulkload the merged runs into a B+-tree.  The merge releases every run once it is exhausted. */
     using tree_type = BTree<int64_t, int32_t, NODE_SIZE>;
-    auto btree = tree_type::Bulkload(size2id.cbegin(), size2id.cend());
-
-    /* Query the B+-tree for packages with a size between SIZE-MIN and SIZE-MAX. */
-    for (auto elem : btree.find_range(size_min, size_max))
-        std::cout << "Package with id " << elem.second() << " is " << elem.first() << " bytes.\n";
+    auto btree = tree_type::Bulkload(size2id.begin(), size2id.end());
+    const auto t_build_end = steady_clock::now();
+
+    /* Query the B+-tree for packages with a size between SIZE-MIN and SIZE-MAX, as text or as rows (id, size). */
+    ResultWriter out(STDOUT_FILENO, *format);
+    for (auto elem : btree.find_range(size_min, size_max)) {
+        if (*format == ResultWriter::Format::Text)
+            out << "Package with id " << elem.second() << " is " << elem.first() << " bytes.\n";
+        else
+            out.row(elem.second(), elem.first());
+    }
+    out.flush();
+
+    if (print_stats) {
+        const auto t_query_end = steady_clock::now();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cerr << "index_build," << size2id.size() << ',' << size2id.num_runs() << ','
+                  << duration_cast<microseconds>(t_build_end - t_build_begin).count() << ','
+                  << duration_cast<microseconds>(t_query_end - t_begin).count() << ','
+                  << usage.ru_maxrss // KiB on Linux
+                  << std::endl;
+    }
 }
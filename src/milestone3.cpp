@@ -1,12 +1,21 @@
 #include "milestone3_utils.hpp"
+#include "HistogramCardinalityEstimator.hpp"
 #include "MyPlanEnumerator.hpp"
+#include "PipelineExecutor.hpp"
+#include "PlanSerialization.hpp"
 #include <cmath>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <mutable/mutable.hpp>
 #include <mutable/Options.hpp>
 #include <random>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
 
@@ -17,13 +26,35 @@ using PlanTable = m::PlanTableLargeAndSparse;
 
 void usage(std::ostream &out, const char *name)
 {
-    out << "USAGE:\n    " << name << " <SCHEMA.sql> <QUERY.sql> <CARDINALITIES.json>" << std::endl;
+    out << "USAGE:\n    " << name << " <SCHEMA.sql> <QUERY.sql> <CARDINALITIES.json>"
+                                    " [--reoptimize <NEW_CARDINALITIES.json>]\n"
+        << "    " << name << " <SCHEMA.sql> <QUERY.sql> <CARDINALITIES.json>"
+                                    " (--export-plan|--import-plan) <PLAN.bin>\n"
+        << "    " << name << " <SCHEMA.sql> <QUERY.sql> <CARDINALITIES.json> --execute <DATA.sql>"
+                                    " [--adaptive <FACTOR>]\n"
+        << "    " << name << " <SCHEMA.sql> <QUERY.sql> --estimate <DATA.sql>\n\n"
+        << "With --estimate, DATA.sql is executed to load the tables and cardinalities are estimated from histograms "
+           "collected on the loaded data.\n"
+        << "With --reoptimize, the plan is incrementally re-optimized for the cardinalities of NEW_CARDINALITIES.json "
+           "after the initial optimization.\n"
+        << "With --export-plan, the optimized plan is written to PLAN.bin.  With --import-plan, the plan in PLAN.bin is "
+           "used instead of optimizing, if it was exported for the same query and cardinalities.\n"
+        << "With --execute, DATA.sql is executed to load the tables and the optimized plan is executed natively in "
+           "pipelines on all cores.  With --adaptive, the plan is re-optimized during execution whenever the actual "
+           "cardinality of a materialized intermediate result is off from its estimate by more than FACTOR."
+        << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
     /* Check the number of parameters. */
-    if (argc != 4) {
+    const bool use_histograms = argc == 5 and std::strcmp(argv[3], "--estimate") == 0;
+    const bool reoptimize = argc == 6 and std::strcmp(argv[4], "--reoptimize") == 0;
+    const bool export_plan = argc == 6 and std::strcmp(argv[4], "--export-plan") == 0;
+    const bool import_plan = argc == 6 and std::strcmp(argv[4], "--import-plan") == 0;
+    const bool adaptive = argc == 8 and std::strcmp(argv[6], "--adaptive") == 0;
+    const bool execute = (argc == 6 or adaptive) and std::strcmp(argv[4], "--execute") == 0;
+    if (argc != 4 and not use_histograms and not reoptimize and not export_plan and not import_plan and not execute) {
         usage(std::cerr, argv[0]);
         exit(EXIT_FAILURE);
     }
@@ -31,14 +62,22 @@ int main(int argc, char *argv[])
     Catalog &C = Catalog::Get();
     Diagnostic diag(true, std::cout, std::cerr);
 
-    C.default_cardinality_estimator("Injected");
-    const char *mutable_args[] = { argv[0], "--use-cardinality-file", argv[3], nullptr };
-    C.arg_parser().parse_args(4, mutable_args);
-    M_insist(C.arg_parser().args().empty(), "not all arguments were handled by mutable");
+    if (not use_histograms) {
+        C.default_cardinality_estimator("Injected");
+        const char *mutable_args[] = { argv[0], "--use-cardinality-file", argv[3], nullptr };
+        C.arg_parser().parse_args(4, mutable_args);
+        M_insist(C.arg_parser().args().empty(), "not all arguments were handled by mutable");
+    }
 
     /*----- Process SCHEMA.sql -----*/
     m::execute_file(diag, argv[1]);
 
+    /*----- Process DATA.sql -----*/
+    if (use_histograms)
+        m::execute_file(diag, argv[4]);
+    else if (execute)
+        m::execute_file(diag, argv[5]);
+
     /*----- Read in QUERY.sql -----*/
     std::ifstream in(argv[2]);
     std::stringstream ss;
@@ -48,6 +87,16 @@ int main(int argc, char *argv[])
     auto stmt = statement_from_string(diag, ss.str());
     auto G = QueryGraph::Build(*stmt);
 
+    /*----- Collect statistics of all tables of the query. -----*/
+    if (use_histograms) {
+        auto CE = std::make_unique<HistogramCardinalityEstimator>();
+        for (auto ds : G->sources()) {
+            if (auto bt = cast<const BaseTable>(ds); bt and not CE->has_statistics(bt->table()))
+                CE->add_statistics(diag, bt->table());
+        }
+        C.get_database_in_use().cardinality_estimator(std::move(CE));
+    }
+
     /*----- Show query graph. -----*/
     {
         DotTool dot(diag);
@@ -55,9 +104,34 @@ int main(int argc, char *argv[])
         dot.show("graph", true, "fdp");
     }
 
+    /*----- Load a previously exported plan. -----*/
+    uint64_t fingerprint = 0;
+    if (export_plan or import_plan) {
+        std::ifstream in_cardinalities(argv[3]);
+        std::stringstream cardinalities;
+        cardinalities << in_cardinalities.rdbuf();
+        fingerprint = plan_fingerprint(ss.str(), cardinalities.str());
+    }
+
+    SerializedPlan stored;
+    bool use_stored = false;
+    if (import_plan) {
+        std::ifstream in_plan(argv[5], std::ios::binary);
+        auto plan = SerializedPlan::read(in_plan);
+        if (not plan or plan->fingerprint != fingerprint) {
+            std::cerr << "No plan for this query in " << argv[5] << ", optimizing instead." << std::endl;
+        } else if (auto error = plan->check(*G)) {
+            std::cerr << "Invalid plan in " << argv[5] << ": " << *error << ", optimizing instead." << std::endl;
+        } else {
+            stored = std::move(*plan);
+            use_stored = true;
+        }
+    }
+
     MyPlanEnumerator PE;
+    ReplayPlanEnumerator RE(stored);
     auto &CF = C.cost_function(); // get default cost function (C_out)
-    Optimizer O(PE, CF);
+    Optimizer O(use_stored ? static_cast<const PlanEnumerator&>(RE) : PE, CF);
 
     /* Create base plans. */
     auto PT_in = get_plan_table<PlanTable>(*G);
@@ -69,6 +143,12 @@ int main(int argc, char *argv[])
 
     std::cout << "Final plan table:\n" << PT_out << std::endl;
 
+    if (export_plan) {
+        std::ofstream out_plan(argv[5], std::ios::binary);
+        SerializedPlan::from_plan_table(PT_out, C.get_database_in_use().cardinality_estimator(), fingerprint)
+            .write(out_plan);
+    }
+
     /* Show the plan and plan table. */
     plan->minimize_schema();
     plan->dump(std::cout);
@@ -78,4 +158,75 @@ int main(int argc, char *argv[])
         plan->dot(dot.stream());
         dot.show("plan", true);
     }
+
+    /*----- Incrementally re-optimize for the new cardinalities. -----*/
+    if (reoptimize) {
+        using namespace std::chrono;
+        auto &DB = C.get_database_in_use();
+
+        std::ifstream in_cardinalities(argv[5]);
+        auto CE_new = std::make_unique<InjectionCardinalityEstimator>(diag, DB.name, in_cardinalities);
+        const auto changed = changed_subproblems(PT_out, *G, DB.cardinality_estimator(), *CE_new);
+        DB.cardinality_estimator(std::move(CE_new));
+
+        const auto t_begin = steady_clock::now();
+        PE.reoptimize(PT_out, *G, CF, changed);
+        const auto t_end = steady_clock::now();
+
+        std::cout << "Re-optimized " << changed.size() << " changed subproblems in "
+                  << duration_cast<microseconds>(t_end - t_begin).count() << " µs.\n"
+                  << "Final plan table after re-optimization:\n" << PT_out << std::endl;
+    }
+
+    /*----- Execute the optimized plan. -----*/
+    if (execute) {
+        using namespace std::chrono;
+
+        /* Locate the columns of every table in its store once, even if several data sources refer to it. */
+        std::unordered_map<const Table*, ColumnarTable> columns;
+        std::vector<const ColumnarTable*> tables;
+        for (auto ds : G->sources()) {
+            auto bt = cast<const BaseTable>(ds);
+            M_insist(bt, "only base tables can be executed");
+            auto it = columns.find(&bt->table());
+            if (it == columns.end())
+                it = columns.emplace(&bt->table(), ColumnarTable::Of(bt->table())).first;
+            tables.push_back(&it->second);
+        }
+
+        ThreadPool pool;
+        PipelineExecutor executor = [&]() {
+            try {
+                return PipelineExecutor(*G, std::move(tables));
+            } catch (std::invalid_argument &e) {
+                std::cerr << "Cannot execute the plan: " << e.what() << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }();
+        if (not adaptive) {
+            const auto t_begin = steady_clock::now();
+            const auto result = executor(pool, PT_out, C.get_database_in_use().cardinality_estimator());
+            const auto t_end = steady_clock::now();
+
+            std::cout << "Executed the plan in " << executor.num_pipelines() << " pipelines in "
+                      << duration_cast<microseconds>(t_end - t_begin).count() << " µs: "
+                      << result.num_tuples << " tuples, checksum " << result.checksum << '.' << std::endl;
+        } else {
+            /* The plan is optimized again with an estimator that learns from execution. */
+            FeedbackCardinalityEstimator feedback(C.get_database_in_use().cardinality_estimator());
+            MyPlanEnumerator adaptive_PE;
+            adaptive_PE.cardinality_estimator = &feedback;
+            executor.replan_factor = std::strtod(argv[7], nullptr);
+
+            const auto t_begin = steady_clock::now();
+            auto PT = get_plan_table<PlanTable>(*G, feedback);
+            adaptive_PE(enumerate_tag{}, PT, *G, CF);
+            const auto result = executor(pool, PT, feedback, adaptive_PE, CF);
+            const auto t_end = steady_clock::now();
+
+            std::cout << "Executed the plan adaptively with " << executor.num_replans << " re-optimizations in "
+                      << duration_cast<microseconds>(t_end - t_begin).count() << " µs: "
+                      << result.num_tuples << " tuples, checksum " << result.checksum << '.' << std::endl;
+        }
+    }
 }
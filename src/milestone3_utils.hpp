@@ -1,22 +1,69 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
+#include "JoinPredicates.hpp"
 #include <mutable/mutable.hpp>
+#include <vector>
 
 
+/** Returns a plan table for \p G with the scans of all data sources estimated by \p CE.  The filters of the data
+ * sources are applied to their scans, as mutable's `Optimizer` initializes its plan table, so that re-estimating the
+ * scans (see `changed_subproblems()` and `MyPlanEnumerator::reoptimize()`) yields the same models.  This changes the
+ * estimates only for estimators that estimate filters, e.g. not for the injected cardinalities of milestone 3. */
 template<typename PlanTable>
-PlanTable get_plan_table(const m::QueryGraph &G)
+PlanTable get_plan_table(const m::QueryGraph &G, const m::CardinalityEstimator &CE)
 {
-    m::Catalog &C = m::Catalog::Get();
-    auto &DB = C.get_database_in_use();
-    auto &CE = DB.cardinality_estimator();
-
     PlanTable PT(G.num_sources());
     for (auto &ds : G.sources()) {
         m::QueryGraph::Subproblem s;
         s.at(ds->id()) = true;
         PT[s].cost = 0;
         PT[s].model = CE.estimate_scan(G, s);
+        if (not ds->filter().empty())
+            PT[s].model = CE.estimate_filter(G, *PT[s].model, ds->filter());
     }
     return PT;
 }
+
+template<typename PlanTable>
+PlanTable get_plan_table(const m::QueryGraph &G)
+{
+    m::Catalog &C = m::Catalog::Get();
+    auto &DB = C.get_database_in_use();
+    return get_plan_table<PlanTable>(G, DB.cardinality_estimator());
+}
+
+/** Returns the subproblems with a plan in \p PT whose cardinality estimated by \p CE_new differs from the cardinality
+ * estimated by \p CE_old, the estimator \p PT was computed with. */
+template<typename PlanTable>
+std::vector<m::SmallBitset> changed_subproblems(PlanTable &PT, const m::QueryGraph &G,
+                                                const m::CardinalityEstimator &CE_old,
+                                                const m::CardinalityEstimator &CE_new)
+{
+    std::vector<m::SmallBitset> changed;
+    const JoinPredicates predicates(G);
+
+    const uint64_t all = (1UL << G.num_sources()) - 1;
+    for (uint64_t s = 1; s <= all; ++s) {
+        const m::SmallBitset S(s);
+        if (not PT.has_plan(S))
+            continue;
+
+        auto &entry = PT[S];
+        std::unique_ptr<m::DataModel> model;
+        if (std::has_single_bit(s)) {
+            model = CE_new.estimate_scan(G, S);
+            auto &filter = G.sources()[std::countr_zero(s)]->filter();
+            if (not filter.empty())
+                model = CE_new.estimate_filter(G, *model, filter);
+        } else {
+            model = CE_new.estimate_join(G, *PT[entry.left].model, *PT[entry.right].model,
+                                         predicates.between(entry.left, entry.right));
+        }
+
+        if (CE_new.predict_cardinality(*model) != CE_old.predict_cardinality(*entry.model))
+            changed.push_back(S);
+    }
+    return changed;
+}
\ No newline at end of file
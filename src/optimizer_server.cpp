@@ -0,0 +1,300 @@
+#include "milestone3_utils.hpp"
+#include "MyPlanEnumerator.hpp"
+#include "QuerySimplification.hpp"
+#include "SubplanCache.hpp"
+#include "SynchronizedCardinalityEstimator.hpp"
+#include "ThreadPool.hpp"
+#include "UnixSocket.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+using namespace m;
+
+using PlanTable = m::PlanTableLargeAndSparse;
+
+
+void usage(std::ostream &out, const char *name)
+{
+    out << "USAGE:\n    " << name << " <SCHEMA.sql> [--socket <PATH>] [--threads <N>] [--batch-size <N>]\n\n"
+        << "Reads requests `<QUERY.sql> <CARDINALITIES.json>`, one per line, from stdin or from every client of the "
+           "Unix socket at PATH.\nRequests are optimized in batches, which end at an empty line, after batch-size "
+           "requests, or at the end of the input.\nRequests of the same relations and joins, in any order, share one "
+           "plan.  The plans of all joins of connected relations are kept, and a query equal to such a join of "
+           "an earlier query, e.g. a common subexpression, is planned by that plan instead of enumerating.\nFor "
+           "every request a line `<QUERY.sql>,<CARDINALITIES.json>,<µs>,<cost>` and for every batch a line "
+           "`batch,<requests>,<s>,<requests per second>,<requests planned by a shared plan>` is written."
+        << std::endl;
+}
+
+struct Request
+{
+    std::string query;
+    std::string cardinalities;
+};
+
+/** Optimizes batches of queries on a pool of workers.  Within a batch, every query and cardinality file is parsed
+ * once, and requests of the same canonical query are optimized once and share the plan.  Across batches and jobs,
+ * the subplans of all plans optimized exactly are shared by a `SubplanCache`: a query equal to a connected subproblem
+ * of a query optimized before is planned by replaying its subplan.  Jobs of more relations are started first, so that
+ * their subplans are available to the smaller jobs of the same batch that finish after them. */
+struct BatchOptimizer
+{
+    private:
+    ThreadPool &pool_;
+    std::mutex catalog_mutex_; ///< guards the global state of mutable, e.g. the parser and the string pool
+    SubplanCache subplans_;
+
+    /** A query parsed once per batch. */
+    struct Query
+    {
+        std::unique_ptr<ast::Stmt> stmt;
+        std::unique_ptr<QueryGraph> G;
+        std::string error;
+    };
+
+    struct Job
+    {
+        const Request *request;
+        const QueryGraph *G = nullptr;
+        const CardinalityEstimator *estimator = nullptr;
+        double us = 0;
+        double cost = 0;
+        bool shared = false; ///< whether the plan was replayed from `subplans_`
+        std::string error;
+    };
+
+    public:
+    explicit BatchOptimizer(ThreadPool &pool) : pool_(pool) { }
+
+    /** Optimizes all \p requests and writes the results to \p out.  Returns the number of requests answered. */
+    std::size_t run(const std::vector<Request> &requests, std::ostream &out)
+    {
+        using namespace std::chrono;
+        const auto t_begin = steady_clock::now();
+
+        /*----- Parse every query once. -----*/
+        std::unordered_map<std::string, Query> queries;
+        {
+            std::lock_guard lock(catalog_mutex_);
+            for (auto &r : requests) {
+                auto [it, inserted] = queries.try_emplace(r.query);
+                if (not inserted)
+                    continue;
+                Query &query = it->second;
+                std::ifstream in(r.query);
+                if (not in) {
+                    query.error = "cannot read query";
+                    continue;
+                }
+                std::stringstream ss;
+                ss << in.rdbuf();
+                std::ostringstream errors;
+                Diagnostic diag(false, errors, errors);
+                query.stmt = statement_from_string(diag, ss.str());
+                if (diag.num_errors() or not query.stmt) {
+                    query.error = "cannot parse query";
+                    continue;
+                }
+                query.G = QueryGraph::Build(*query.stmt);
+            }
+        }
+
+        /*----- Share jobs of requests of the same canonical query and cardinalities. -----*/
+        std::vector<Job> jobs;
+        std::vector<std::size_t> job_of_request;
+        {
+            std::unordered_map<std::string, std::size_t> job_ids;
+            for (auto &r : requests) {
+                const Query &query = queries.at(r.query);
+                std::string key = r.cardinalities + '\0';
+                if (query.G and query.G->num_sources() != 0) {
+                    const CanonicalSubproblem canonical(*query.G, ~0UL >> (64 - query.G->num_sources()));
+                    key += canonical.key.empty() ? r.query : canonical.key;
+                } else {
+                    key += r.query;
+                }
+                auto [it, inserted] = job_ids.try_emplace(std::move(key), jobs.size());
+                if (inserted)
+                    jobs.push_back(Job{ &r, query.G.get(), nullptr, 0, 0, false, query.error });
+                job_of_request.push_back(it->second);
+            }
+        }
+
+        /*----- Parse every cardinality file once. -----*/
+        std::unordered_map<std::string, std::unique_ptr<CardinalityEstimator>> estimators;
+        {
+            auto &C = Catalog::Get();
+            std::ostringstream errors;
+            Diagnostic diag(false, errors, errors);
+            for (auto &job : jobs) {
+                auto [it, inserted] = estimators.try_emplace(job.request->cardinalities);
+                if (inserted) {
+                    std::ifstream in(job.request->cardinalities);
+                    if (in)
+                        it->second = std::make_unique<InjectionCardinalityEstimator>(
+                            diag, C.get_database_in_use().name, in
+                        );
+                }
+                if (it->second)
+                    job.estimator = it->second.get();
+                else if (job.error.empty())
+                    job.error = "cannot read cardinalities";
+            }
+        }
+
+        /*----- Optimize all jobs in parallel, those of more relations first. -----*/
+        std::vector<Job*> order;
+        for (auto &job : jobs) {
+            if (job.estimator and job.G)
+                order.push_back(&job);
+        }
+        std::stable_sort(order.begin(), order.end(), [](const Job *a, const Job *b) {
+            return a->G->num_sources() > b->G->num_sources();
+        });
+        for (Job *job : order)
+            pool_.submit([this, job]() { optimize(*job); });
+        pool_.wait();
+
+        /*----- Report. -----*/
+        std::size_t num_shared = 0;
+        for (std::size_t i = 0; i != requests.size(); ++i) {
+            const Job &job = jobs[job_of_request[i]];
+            num_shared += job.shared;
+            out << requests[i].query << ',' << requests[i].cardinalities << ',';
+            if (job.error.empty())
+                out << job.us << ',' << job.cost << '\n';
+            else
+                out << "error: " << job.error << '\n';
+        }
+
+        const double s = duration_cast<nanoseconds>(steady_clock::now() - t_begin).count() / 1e9;
+        out << "batch," << requests.size() << ',' << s << ',' << requests.size() / s << ',' << num_shared
+            << std::endl;
+        return requests.size();
+    }
+
+    private:
+    void optimize(Job &job)
+    {
+        using namespace std::chrono;
+        const auto t_begin = steady_clock::now();
+
+        /* Replay a shared subplan or enumerate without holding the lock, except for estimates. */
+        const QueryGraph &G = *job.G;
+        auto &CF = Catalog::Get().cost_function();
+        SynchronizedCardinalityEstimator CE(*job.estimator, catalog_mutex_);
+        auto PT = get_plan_table<PlanTable>(G, CE);
+        job.shared = subplans_.replay(PT, G, job.request->cardinalities, CE, CF);
+        if (not job.shared) {
+            MyPlanEnumerator PE;
+            PE.cardinality_estimator = &CE;
+            PE(enumerate_tag{}, PT, G, CF);
+
+            /* Share the subplans only if enumeration was exact, i.e. the join graph was not simplified. */
+            if (not PE.simplification_budget or
+                UnitGraph(G).count_ccps(PE.simplification_budget) <= PE.simplification_budget)
+                subplans_.add(PT, G, job.request->cardinalities);
+        }
+
+        job.cost = PT.get_final().cost;
+        job.us = duration_cast<nanoseconds>(steady_clock::now() - t_begin).count() / 1e3;
+    }
+};
+
+/** Answers the requests read from \p in in batches of at most \p batch_size requests. */
+void serve(BatchOptimizer &optimizer, std::istream &in, std::ostream &out, std::size_t batch_size)
+{
+    using namespace std::chrono;
+    const auto t_begin = steady_clock::now();
+    std::size_t num_requests = 0;
+
+    std::vector<Request> batch;
+    auto flush = [&]() {
+        if (not batch.empty())
+            num_requests += optimizer.run(batch, out);
+        batch.clear();
+    };
+
+    for (std::string line; std::getline(in, line); ) {
+        std::istringstream iss(line);
+        Request r;
+        if (not (iss >> r.query >> r.cardinalities)) {
+            flush(); // an empty line ends the batch
+            continue;
+        }
+        batch.push_back(std::move(r));
+        if (batch.size() == batch_size)
+            flush();
+    }
+    flush();
+
+    const double s = duration_cast<nanoseconds>(steady_clock::now() - t_begin).count() / 1e9;
+    out << "total," << num_requests << ',' << s << ',' << num_requests / s << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    /* Check the parameters. */
+    if (argc < 2 or argc % 2 != 0) {
+        usage(std::cerr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *socket_path = nullptr;
+    std::size_t num_threads = std::thread::hardware_concurrency();
+    std::size_t batch_size = 64;
+    for (int i = 2; i != argc; i += 2) {
+        if (std::strcmp(argv[i], "--socket") == 0) {
+            socket_path = argv[i + 1];
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            num_threads = std::strtoul(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--batch-size") == 0) {
+            batch_size = std::max(1UL, std::strtoul(argv[i + 1], nullptr, 10));
+        } else {
+            usage(std::cerr, argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /*----- Process SCHEMA.sql once. -----*/
+    Diagnostic diag(true, std::cout, std::cerr);
+    m::execute_file(diag, argv[1]);
+    if (diag.num_errors())
+        exit(EXIT_FAILURE);
+
+    ThreadPool pool(num_threads);
+    BatchOptimizer optimizer(pool);
+
+    if (not socket_path) {
+        serve(optimizer, std::cin, std::cout, batch_size);
+    } else {
+        /* A client disconnecting before reading all responses must fail the writes to it, not kill the server. */
+        std::signal(SIGPIPE, SIG_IGN);
+        UnixSocketListener listener(socket_path);
+        std::cerr << "Listening on " << socket_path << " with " << pool.num_threads() << " workers." << std::endl;
+        for (;;) {
+            const int client = listener.accept();
+            if (client < 0) {
+                std::cerr << "accept(): " << std::strerror(errno) << std::endl;
+                break;
+            }
+            SocketStream stream(client);
+            serve(optimizer, stream, stream, batch_size);
+        }
+    }
+
+    m::Catalog::Destroy();
+}
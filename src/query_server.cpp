@@ -0,0 +1,202 @@
+#include "data_layouts.hpp"
+#include "UnixSocket.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <memory>
+#include <mutable/mutable.hpp>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+void usage(std::ostream &out, const char *name)
+{
+    out << "USAGE:\n    " << name << " <Layout> <CSV-File> [--socket <PATH>]\n\n"
+        << "Loads CSV-File into the table `packages` once, then reads SQL statements, each ending at `;`, from stdin "
+           "or from every client of the Unix socket at PATH.\nThe clients of the socket are served concurrently, "
+           "their statements are executed one at a time.\nFor every statement, the tuples of its result and a line "
+           "`query,<tuples>,<µs>`, or a line `error,<message>`, are written." << std::endl;
+}
+
+/** Executes SQL statements on the database loaded once, one statement at a time. */
+struct QueryServer
+{
+    private:
+    std::mutex catalog_mutex_; ///< guards the global state of mutable, e.g. the parser and the string pool
+
+    public:
+    /** Executes the statement \p sql and writes its result to \p out.  The result is buffered and written only after
+     * the lock on mutable is released, so that a slow client does not block the others.  The time reported is that of
+     * parsing and executing the statement, including formatting the result into the buffer. */
+    void execute(const std::string &sql, std::ostream &out)
+    {
+        using namespace std::chrono;
+
+        std::ostringstream result, errors;
+        m::Diagnostic diag(false, result, errors);
+        std::size_t num_tuples = 0;
+        double us = 0;
+        {
+            std::lock_guard lock(catalog_mutex_);
+            const auto t_begin = steady_clock::now();
+            auto stmt = m::statement_from_string(diag, sql);
+            if (stmt and not diag.num_errors()) {
+                if (auto select = m::cast<const m::ast::SelectStmt>(stmt.get())) {
+                    auto callback = std::make_unique<m::CallbackOperator>([&](const m::Schema &S, const m::Tuple &t) {
+                        ++num_tuples;
+                        t.print(result, S);
+                        result << '\n';
+                    });
+                    m::execute_query(diag, *select, std::move(callback));
+                } else {
+                    m::execute_statement(diag, *stmt);
+                }
+            }
+            us = duration_cast<nanoseconds>(steady_clock::now() - t_begin).count() / 1e3;
+        }
+
+        out << result.view();
+        if (diag.num_errors()) {
+            std::string message = errors.str();
+            std::replace(message.begin(), message.end(), '\n', ' ');
+            out << "error," << message << std::endl;
+        } else {
+            out << "query," << num_tuples << ',' << us << std::endl;
+        }
+    }
+};
+
+/** The threads serving the clients of a socket.  Threads of clients that disconnected are joined whenever a client is
+ * added, all others by `shutdown()`. */
+struct ClientThreads
+{
+    private:
+    struct Client
+    {
+        int fd;
+        std::thread thread;
+        bool done = false; ///< whether the client is served completely and its socket about to be closed
+    };
+
+    std::mutex mutex_;
+    std::list<Client> clients_;
+
+    public:
+    ~ClientThreads() { shutdown(); }
+
+    /** Serves the client connected to the socket \p fd in a new thread, executing its statements on \p server. */
+    void add(QueryServer &server, int fd);
+
+    /** Disconnects all clients and joins their threads, e.g. before destroying the catalog they access. */
+    void shutdown();
+};
+
+/** Executes the statements read from \p in and writes their results to \p out. */
+void serve(QueryServer &server, std::istream &in, std::ostream &out)
+{
+    for (std::string sql; std::getline(in, sql, ';'); ) {
+        if (sql.find_first_not_of(" \t\r\n") == std::string::npos)
+            continue; // only whitespace after the last statement
+        server.execute(sql + ';', out);
+    }
+}
+
+void ClientThreads::add(QueryServer &server, int fd)
+{
+    std::lock_guard lock(mutex_);
+    for (auto it = clients_.begin(); it != clients_.end(); ) {
+        if (it->done) {
+            it->thread.join();
+            it = clients_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    auto &client = clients_.emplace_back(Client{ fd, std::thread(), false });
+    client.thread = std::thread([this, &server, &client]() {
+        SocketStream stream(client.fd);
+        serve(server, stream, stream);
+        std::lock_guard lock(mutex_);
+        client.done = true;
+    }); // the socket is closed after `done` is set, so `shutdown()` never shuts down a socket already closed
+}
+
+void ClientThreads::shutdown()
+{
+    {
+        std::lock_guard lock(mutex_);
+        for (auto &client : clients_) {
+            if (not client.done)
+                ::shutdown(client.fd, SHUT_RDWR); // the client's thread reads end of file
+        }
+    }
+    for (auto &client : clients_)
+        client.thread.join();
+    clients_.clear();
+}
+
+int main(int argc, char *argv[])
+{
+    /* Check the parameters. */
+    if (argc != 3 and not (argc == 5 and std::strcmp(argv[3], "--socket") == 0)) {
+        usage(std::cerr, argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    const char *socket_path = argc == 5 ? argv[4] : nullptr;
+
+    auto &C = m::Catalog::Get();
+    m::Diagnostic diag(true, std::cout, std::cerr);
+
+    /*----- Create the table `packages` in the layout Layout and load CSV-File once. -----*/
+    C.register_data_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>(), "row layout (naïve)");
+    C.register_data_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>(), "row layout (optimized)");
+    C.register_data_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>(), "PAX layout with 4KiB blocks");
+    C.default_data_layout(argv[1]);
+
+    auto &DB = C.add_database(C.pool("dbsys"));
+    C.set_database_in_use(DB);
+    auto &T = DB.add_table(C.pool("packages"));
+    T.push_back(C.pool("id"),           m::Type::Get_Integer(m::Type::TY_Vector, 4));
+    T.push_back(C.pool("repo"),         m::Type::Get_Char(m::Type::TY_Vector, 10));
+    T.push_back(C.pool("pkg_name"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("pkg_ver"),      m::Type::Get_Char(m::Type::TY_Vector, 20));
+    T.push_back(C.pool("description"),  m::Type::Get_Char(m::Type::TY_Vector, 80));
+    T.push_back(C.pool("licenses"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.push_back(C.pool("size"),         m::Type::Get_Integer(m::Type::TY_Vector, 8));
+    T.push_back(C.pool("packager"),     m::Type::Get_Char(m::Type::TY_Vector, 32));
+    T.store(C.create_store(T));
+    T.layout(C.data_layout());
+    m::load_from_CSV(diag, T, argv[2], std::numeric_limits<std::size_t>::max(), true, false);
+    if (diag.num_errors())
+        exit(EXIT_FAILURE);
+
+    QueryServer server;
+    if (not socket_path) {
+        serve(server, std::cin, std::cout);
+    } else {
+        /* A client disconnecting before reading all results must fail the writes to it, not kill the server. */
+        std::signal(SIGPIPE, SIG_IGN);
+        UnixSocketListener listener(socket_path);
+        std::cerr << "Listening on " << socket_path << " with " << T.store().num_rows() << " packages." << std::endl;
+        ClientThreads clients;
+        for (;;) {
+            const int client = listener.accept();
+            if (client < 0) {
+                std::cerr << "accept(): " << std::strerror(errno) << std::endl;
+                break;
+            }
+            clients.add(server, client);
+        }
+        clients.shutdown();
+    }
+
+    m::Catalog::Destroy();
+}
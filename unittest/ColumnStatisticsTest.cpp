@@ -0,0 +1,134 @@
+#include "catch2/catch.hpp"
+
+#include "ColumnStatistics.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+TEST_CASE("HyperLogLog", "[milestone3]")
+{
+    HyperLogLog<> hll;
+
+    SECTION("empty")
+    {
+        CHECK(hll.estimate() == Approx(0).margin(.5));
+    }
+
+    SECTION("few distinct values")
+    {
+        for (int64_t i = 0; i != 1000; ++i)
+            hll.add(i % 50);
+        CHECK(hll.estimate() == Approx(50).epsilon(.05));
+    }
+
+    SECTION("many distinct values")
+    {
+        for (int64_t i = 0; i != 1'000'000; ++i)
+            hll.add(i);
+        CHECK(hll.estimate() == Approx(1'000'000).epsilon(.05));
+    }
+
+    SECTION("strings")
+    {
+        for (int i = 0; i != 10000; ++i)
+            hll.add(std::string_view(std::to_string(i % 2000)));
+        CHECK(hll.estimate() == Approx(2000).epsilon(.05));
+    }
+
+    SECTION("merge")
+    {
+        HyperLogLog<> other;
+        for (int64_t i = 0; i != 10000; ++i) {
+            hll.add(i);
+            other.add(i + 5000);
+        }
+        hll.merge(other);
+        CHECK(hll.estimate() == Approx(15000).epsilon(.05));
+    }
+}
+
+TEST_CASE("EquiDepthHistogram", "[milestone3]")
+{
+    SECTION("uniform")
+    {
+        std::vector<double> values;
+        for (int i = 0; i != 10000; ++i)
+            values.push_back(i);
+        EquiDepthHistogram H(values, values.size(), values.size(), 16);
+
+        CHECK(H.buckets().size() == 16);
+        for (auto &b : H.buckets())
+            CHECK(b.count == Approx(10000. / 16).epsilon(.01));
+
+        CHECK(H.selectivity_less(5000, false) == Approx(.5).epsilon(.01));
+        CHECK(H.selectivity_less(-1, true) == 0);
+        CHECK(H.selectivity_less(20000, true) == 1);
+        CHECK(H.selectivity_range(1000, 2999) == Approx(.2).epsilon(.01));
+        CHECK(H.selectivity_equal(42) == Approx(1. / 10000).epsilon(.01));
+        CHECK(H.selectivity_equal(-42) == 0);
+    }
+
+    SECTION("skewed")
+    {
+        /* Half of the rows have value 0, the others are distinct. */
+        std::vector<double> values(5000, 0.);
+        for (int i = 1; i <= 5000; ++i)
+            values.push_back(i);
+        EquiDepthHistogram H(values, values.size(), 5001, 10);
+
+        CHECK(H.selectivity_equal(0) == Approx(.5).epsilon(.01));
+        CHECK(H.selectivity_equal(2500) == Approx(1. / 10000).epsilon(.01));
+    }
+
+    SECTION("join")
+    {
+        /* Foreign key join: every key of `pk` is referenced 10 times by `fk`. */
+        std::vector<double> pk, fk;
+        for (int i = 0; i != 1000; ++i) {
+            pk.push_back(i);
+            for (int j = 0; j != 10; ++j)
+                fk.push_back(i);
+        }
+        EquiDepthHistogram H_pk(pk, pk.size(), 1000);
+        EquiDepthHistogram H_fk(fk, fk.size(), 1000);
+
+        CHECK(EquiDepthHistogram::estimate_join(H_pk, H_fk) == Approx(10000).epsilon(.1));
+    }
+}
+
+TEST_CASE("ColumnStatistics", "[milestone3]")
+{
+    ColumnStatistics stats;
+    for (int i = 0; i != 100'000; ++i) {
+        if (i % 10 == 0)
+            stats.add_null();
+        else
+            stats.add(double(i % 500));
+    }
+    stats.finalize();
+
+    CHECK(stats.num_rows == 100'000);
+    CHECK(stats.num_nulls == 10'000);
+    CHECK(stats.num_distinct() == Approx(450).epsilon(.05)); // multiples of 10 are always NULL
+    REQUIRE_FALSE(stats.histogram.empty());
+    CHECK(stats.histogram.num_rows() == 90'000);
+    CHECK(stats.histogram.selectivity_less(250, false) == Approx(.5).epsilon(.05));
+
+    SECTION("sample unbiased by NULLs")
+    {
+        /* A quarter of the values precede a long run of NULLs, which must not keep the later values out of the
+         * sample. */
+        ColumnStatistics column;
+        for (int i = 0; i != 1 << 15; ++i)
+            column.add(double(i % 1000));
+        for (int i = 0; i != 1'000'000; ++i)
+            column.add_null();
+        for (int i = 0; i != 3 << 15; ++i)
+            column.add(double(1000 + i % 1000));
+        column.finalize();
+
+        CHECK(column.histogram.num_rows() == 4 << 15);
+        CHECK(column.histogram.selectivity_less(1000, false) == Approx(.25).margin(.02));
+    }
+}
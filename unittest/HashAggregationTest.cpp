@@ -0,0 +1,89 @@
+#include "catch2/catch.hpp"
+
+#include "HashAggregation.hpp"
+#include "ThreadPool.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+
+using namespace m;
+
+
+TEST_CASE("HashAggregation", "[milestone3]")
+{
+    Catalog::Clear();
+    auto &C = Catalog::Get();
+    auto register_layout = [&C](const char *name, std::unique_ptr<storage::DataLayoutFactory> factory) {
+        try {
+            C.register_data_layout(name, std::move(factory), name);
+        } catch (std::invalid_argument) { } // registered by an earlier test
+    };
+    register_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>());
+    register_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>());
+    register_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>());
+    NullStream devnull;
+    Diagnostic diag(false, devnull, std::cerr);
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("name"),  Type::Get_Char(Type::TY_Vector, 8));
+    table.push_back(C.pool("id"),    Type::Get_Integer(Type::TY_Vector, 2));
+    table.push_back(C.pool("value"), Type::Get_Integer(Type::TY_Vector, 8));
+
+    const char *layout = GENERATE("row_naive", "row_optimized", "PAX4k");
+    table.store(C.create_store(table));
+    table.layout(C.data_layout(layout));
+
+    /* Row `i` is named after `i % 100`, has id `i % 7` and value `i - 1000`.  Beyond row 2000, every other name,
+     * every third id and every fifth value is NULL. */
+    using Aggregates = std::tuple<uint64_t, uint64_t, int64_t>; // COUNT(*), the number of values, SUM(value)
+    std::map<std::string, Aggregates> by_name, by_id;
+    std::ostringstream insert;
+    insert << "INSERT INTO test VALUES ";
+    for (int64_t i = 0; i != 2100; ++i) {
+        const bool null_name = i >= 2000 and i % 2, null_id = i >= 2000 and i % 3 == 0,
+                   null_value = i >= 2000 and i % 5 == 0;
+        const std::string name = null_name ? "NULL" : "n" + std::to_string(i % 100);
+        const std::string id = null_id ? "NULL" : std::to_string(i % 7);
+        insert << (i ? ", " : "") << '(' << (null_name ? name : '"' + name + '"') << ", " << id << ", "
+               << (null_value ? "NULL" : std::to_string(i - 1000)) << ')';
+        for (auto [groups, key] : { std::pair(&by_name, name), std::pair(&by_id, id) }) {
+            auto &[count, num_values, sum] = (*groups)[key];
+            ++count;
+            if (not null_value) {
+                ++num_values;
+                sum += i - 1000;
+            }
+        }
+    }
+    insert << ';';
+    C.set_database_in_use(DB);
+    m::execute_statement(diag, *m::statement_from_string(diag, insert.str()));
+    REQUIRE(table.store().num_rows() == 2100);
+
+    /* Tiny pre-aggregation tables spill repeatedly, with more groups than slots per worker. */
+    ThreadPool pool(4);
+    HashAggregation aggregation;
+    aggregation.preaggregation_slots = 64;
+    aggregation.partition_bits = 3;
+    aggregation.morsel_size = 1000;
+
+    for (auto [key, expected] : { std::pair("name", &by_name), std::pair("id", &by_id) }) {
+        const auto groups = aggregation(pool, table, key, "value");
+        std::map<std::string, Aggregates> actual;
+        for (auto &group : groups) {
+            CHECK(group.is_null == group.key.empty());
+            const std::string key = group.is_null ? "NULL" : group.key;
+            CHECK(actual.emplace(key, Aggregates(group.count, group.num_values, group.sum)).second);
+        }
+        CHECK(actual == *expected);
+    }
+}
@@ -0,0 +1,142 @@
+#include "catch2/catch.hpp"
+
+#include "HistogramCardinalityEstimator.hpp"
+#include "milestone3_utils.hpp"
+#include "nullstream.hpp"
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+
+using namespace m;
+
+
+namespace {
+
+void run(Diagnostic &diag, const std::string &sql)
+{
+    auto stmt = statement_from_string(diag, sql);
+    REQUIRE(stmt);
+    execute_statement(diag, *stmt);
+}
+
+/** Inserts the values `value_of(i)` for `i` in `[0, num_rows)` into the single attribute of table \p table. */
+template<typename Fn>
+void insert(Diagnostic &diag, const char *table, std::size_t num_rows, Fn value_of)
+{
+    std::ostringstream sql;
+    sql << "INSERT INTO " << table << " VALUES ";
+    for (std::size_t i = 0; i != num_rows; ++i)
+        sql << (i ? ", (" : "(") << value_of(i) << ')';
+    sql << ';';
+    run(diag, sql.str());
+}
+
+const DataSource * source(const QueryGraph &G, const char *name)
+{
+    for (auto ds : G.sources()) {
+        if (std::strcmp(ds->name(), name) == 0)
+            return ds;
+    }
+    return nullptr;
+}
+
+/** Returns the statistics of a column with the values `value_of(i)` for `i` in `[0, num_rows)`. */
+template<typename Fn>
+ColumnStatistics statistics_of(std::size_t num_rows, Fn value_of)
+{
+    ColumnStatistics column;
+    for (std::size_t i = 0; i != num_rows; ++i)
+        column.add(double(value_of(i)));
+    column.finalize();
+    return column;
+}
+
+}
+
+TEST_CASE("HistogramCardinalityEstimator", "[milestone3]")
+{
+    Catalog::Clear();
+    auto &C = Catalog::Get();
+    NullStream devnull;
+    Diagnostic diag(false, devnull, std::cerr);
+
+    /* R.a is unique in [0, 1000), S.b has the values [0, 100) ten times each, and T.c has values disjoint from R.a. */
+    run(diag, "CREATE DATABASE test_db;");
+    run(diag, "USE test_db;");
+    run(diag, "CREATE TABLE R ( a INT(4) );");
+    run(diag, "CREATE TABLE S ( b INT(4) );");
+    run(diag, "CREATE TABLE T ( c INT(4) );");
+    insert(diag, "R", 1000, [](std::size_t i) { return i; });
+    insert(diag, "S", 1000, [](std::size_t i) { return i % 100; });
+    insert(diag, "T", 2000, [](std::size_t i) { return 2000 + i % 50; });
+    REQUIRE(diag.num_errors() == 0);
+
+    HistogramCardinalityEstimator CE;
+    auto &DB = C.get_database_in_use();
+    for (auto name : { "R", "S", "T" })
+        CE.add_statistics(diag, DB.get_table(C.pool(name)));
+
+    /* Returns the estimated sizes of R after its filter and of its join with \p other in the query \p sql. */
+    auto estimate = [&](const char *sql, const char *other) {
+        auto stmt = statement_from_string(diag, sql);
+        REQUIRE(stmt);
+        auto G = QueryGraph::Build(*stmt);
+        auto r = source(*G, "R"), o = source(*G, other);
+        REQUIRE(r);
+        REQUIRE(o);
+        auto scan_r = CE.estimate_scan(*G, Subproblem::Singleton(r->id()));
+        auto scan_o = CE.estimate_scan(*G, Subproblem::Singleton(o->id()));
+        CHECK(CE.predict_cardinality(*scan_r) == 1000);
+        auto filtered_r = CE.estimate_filter(*G, *scan_r, r->filter());
+        REQUIRE(G->joins().size() == 1);
+        auto joined = CE.estimate_join(*G, *filtered_r, *scan_o, G->joins()[0]->condition());
+        return std::pair(CE.predict_cardinality(*filtered_r), CE.predict_cardinality(*joined));
+    };
+
+    SECTION("filter and join")
+    {
+        /* 250 rows of R qualify and join with 10 rows of S each. */
+        auto [filtered, joined] = estimate("SELECT * FROM R, S WHERE R.a = S.b AND R.a < 250;", "S");
+        CHECK(filtered == Approx(250).epsilon(.05));
+
+        /* The join is estimated from the histograms of R.a and S.b, scaled to the filtered size of R. */
+        const auto a = statistics_of(1000, [](std::size_t i) { return i; });
+        const auto b = statistics_of(1000, [](std::size_t i) { return i % 100; });
+        const double selectivity = EquiDepthHistogram::estimate_join(a.histogram, b.histogram) / (1000. * 1000.);
+        CHECK(joined == Approx(filtered * 1000 * selectivity).epsilon(.01));
+        CHECK(joined > 0);
+        CHECK(joined <= 2500); // the actual size
+    }
+
+    SECTION("no join partners")
+    {
+        auto [filtered, joined] = estimate("SELECT * FROM R, T WHERE R.a = T.c AND R.a >= 500;", "T");
+        CHECK(filtered == Approx(500).epsilon(.05));
+        CHECK(joined == 0);
+    }
+
+    SECTION("plan table")
+    {
+        /* The plan table starts from the filtered scans, which the estimator estimates. */
+        auto stmt = statement_from_string(diag, "SELECT * FROM R, S WHERE R.a = S.b AND R.a < 250;");
+        REQUIRE(stmt);
+        auto G = QueryGraph::Build(*stmt);
+        auto r = source(*G, "R"), s = source(*G, "S");
+        REQUIRE(r);
+        REQUIRE(s);
+        auto PT = get_plan_table<PlanTableLargeAndSparse>(*G, CE);
+        CHECK(CE.predict_cardinality(*PT[Subproblem::Singleton(r->id())].model) == Approx(250).epsilon(.05));
+        CHECK(CE.predict_cardinality(*PT[Subproblem::Singleton(s->id())].model) == 1000);
+    }
+
+    SECTION("consecutive queries")
+    {
+        /* Estimates must not be reused for a different query, even if its graph happens to reuse the memory. */
+        for (int i = 0; i != 3; ++i) {
+            CHECK(estimate("SELECT * FROM R, T WHERE R.a = T.c AND R.a < 1000;", "T").second == 0);
+            CHECK(estimate("SELECT * FROM R, S WHERE R.a = S.b AND R.a < 1000;", "S").second > 100);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#include "catch2/catch.hpp"
+
+#include "JoinHashTable.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+
+TEST_CASE("JoinHashTable", "[milestone3]")
+{
+    SECTION("unique keys")
+    {
+        JoinHashTable HT(1000);
+        for (int32_t k = 0; k != 1000; ++k)
+            HT.insert(k * 7, k);
+        CHECK(HT.size() == 1000);
+
+        for (int32_t k = 0; k != 1000; ++k) {
+            std::vector<uint32_t> found;
+            HT.find(k * 7, [&](uint32_t payload) { found.push_back(payload); });
+            REQUIRE(found.size() == 1);
+            CHECK(found[0] == uint32_t(k));
+        }
+
+        std::size_t num_found = 0;
+        HT.find(3, [&](uint32_t) { ++num_found; });
+        CHECK(num_found == 0);
+    }
+
+    SECTION("duplicate keys overflow into the next buckets")
+    {
+        JoinHashTable HT(100);
+        for (uint32_t i = 0; i != 100; ++i)
+            HT.insert(42, i);
+
+        std::vector<uint32_t> found;
+        HT.find(42, [&](uint32_t payload) { found.push_back(payload); });
+        std::sort(found.begin(), found.end());
+        REQUIRE(found.size() == 100);
+        for (uint32_t i = 0; i != 100; ++i)
+            CHECK(found[i] == i);
+    }
+
+    SECTION("batched probe")
+    {
+        JoinHashTable HT(128);
+        for (int32_t k = 0; k != 64; ++k) {
+            HT.insert(k, k);
+            HT.insert(k, k + 64);
+        }
+
+        std::vector<int32_t> keys;
+        for (int32_t k = -10; k != 100; ++k)
+            keys.push_back(k);
+
+        std::size_t num_matches = 0;
+        bool correct = true;
+        HT.probe(keys.data(), keys.size(), [&](std::size_t i, uint32_t payload) {
+            ++num_matches;
+            correct = correct and (payload == uint32_t(keys[i]) or payload == uint32_t(keys[i]) + 64);
+        });
+        CHECK(num_matches == 2 * 64);
+        CHECK(correct);
+    }
+}
@@ -0,0 +1,101 @@
+#include "catch2/catch.hpp"
+
+#include "milestone3_utils.hpp"
+#include "FeedbackCardinalityEstimator.hpp"
+#include "JoinPredicates.hpp"
+#include "MyPlanEnumerator.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+
+using namespace m;
+
+
+namespace {
+
+/** Records the join condition of every join estimated, by the data sources of both sides. */
+struct RecordingCardinalityEstimator : FeedbackCardinalityEstimator
+{
+    mutable std::vector<std::tuple<uint64_t, uint64_t, std::size_t>> joins; ///< left, right, number of clauses
+
+    using FeedbackCardinalityEstimator::FeedbackCardinalityEstimator;
+
+    std::unique_ptr<DataModel> estimate_join(const QueryGraph &G, const DataModel &left, const DataModel &right,
+                                             const cnf::CNF &condition) const override
+    {
+        joins.emplace_back(as<const Model>(left).sources, as<const Model>(right).sources, condition.size());
+        return FeedbackCardinalityEstimator::estimate_join(G, left, right, condition);
+    }
+};
+
+}
+
+TEST_CASE("JoinPredicates", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    Diagnostic diag(false, devnull, std::cerr);
+
+    for (auto sql : { "CREATE DATABASE test;", "USE test;",
+                      "CREATE TABLE T ( id INT(4), fid_T1 INT(4), fid_T2 INT(4) );" })
+        execute_statement(diag, *statement_from_string(diag, sql));
+
+    /* T0, T1 and T2 form a cycle, T3 is joined to T2 only. */
+    auto query = statement_from_string(diag, "\
+                                              SELECT 1\n\
+                                              FROM T AS T0, T AS T1, T AS T2, T AS T3\n\
+                                              WHERE T0.fid_T1 = T1.id\n\
+                                                AND T1.fid_T2 = T2.id\n\
+                                                AND T0.fid_T2 = T2.id\n\
+                                                AND T3.fid_T2 = T2.id\n\
+                                              ;");
+    auto G = QueryGraph::Build(*query);
+    const JoinPredicates predicates(*G);
+
+    /* Returns the number of clauses of the conditions of all joins between `left` and `right`. */
+    auto num_clauses_between = [&G](uint64_t left, uint64_t right) {
+        std::size_t num_clauses = 0;
+        for (auto join : G->joins()) {
+            uint64_t sources = 0;
+            for (auto ds : join->sources())
+                sources |= 1UL << ds->id();
+            if ((sources & left) and (sources & right) and not (sources & ~(left | right)))
+                num_clauses += join->condition().size();
+        }
+        return num_clauses;
+    };
+
+    SECTION("between")
+    {
+        CHECK(predicates.between(0b0001, 0b0010).size() == 1);
+        CHECK(predicates.between(0b0011, 0b0100).size() == 2);
+        CHECK(predicates.between(0b0111, 0b1000).size() == 1);
+        CHECK(predicates.between(0b0001, 0b1000).empty());
+
+        /* The conjunction of several joins is built once. */
+        CHECK(&predicates.between(0b0011, 0b0100) == &predicates.between(0b0011, 0b0100));
+        CHECK(&predicates.between(0b0011, 0b0100) != &predicates.between(0b0101, 0b0010));
+        CHECK(predicates.between(0b0101, 0b0010).size() == 2);
+    }
+
+    SECTION("enumeration passes the conditions to the plan table")
+    {
+        RecordingCardinalityEstimator CE(C.get_database_in_use().cardinality_estimator());
+        MyPlanEnumerator PE;
+        PE.cardinality_estimator = &CE;
+        auto PT = get_plan_table<PlanTableLargeAndSparse>(*G, CE);
+        PE(enumerate_tag{}, PT, *G, C.cost_function());
+
+        REQUIRE_FALSE(CE.joins.empty());
+        bool has_conjunction = false;
+        for (auto [left, right, num_clauses] : CE.joins) {
+            CHECK(num_clauses == num_clauses_between(left, right));
+            has_conjunction = has_conjunction or num_clauses > 1;
+        }
+        CHECK(has_conjunction);
+    }
+}
@@ -2,6 +2,9 @@
 
 #include "milestone3_utils.hpp"
 #include "MyPlanEnumerator.hpp"
+#include "PlanSerialization.hpp"
+#include "QuerySimplification.hpp"
+#include "SmallQueryDP.hpp"
 #include "nullstream.hpp"
 #include <initializer_list>
 #include <memory>
@@ -149,6 +152,28 @@ CREATE TABLE T (\n\
         expected_cost = 20;
     }
 
+    SECTION("cross product")
+    {
+        query_str = "\
+                     SELECT 1\n\
+                     FROM T AS T0, T AS T1, T AS T2\n\
+                     WHERE T0.fid_T1 = T1.id\n\
+                     ;";
+
+        write_cardinalities(cardinalities, "test", {
+            { { "T0" }, 10 },
+            { { "T1" }, 10 },
+            { { "T2" }, 3 },
+            { { "T0", "T1" }, 50 },
+            { { "T0", "T1", "T2" }, 150 },
+        });
+
+        expected.emplace_back(PT_entry { .S = T0|T1, .size = 50, .S1 = T0, .S2 = T1 });
+        expected.emplace_back(PT_entry { .S = T0|T1|T2, .size = 150, .S1 = T2, .S2 = T0|T1 });
+
+        expected_cost = 50 + 150;
+    }
+
     SECTION("chain-3")
     {
         query_str = "\
@@ -445,4 +470,351 @@ CREATE TABLE T (\n\
             CHECK(false);
         }
     }
+
+    /* The generic enumeration must find a plan of the same cost as the kernel specialized for small queries. */
+    PE.specialize_small_queries = false;
+    auto [__, PT_generic] = O.optimize_with_plantable<PlanTable>(*G);
+    CHECK(PT_generic.get_final().cost == expected_cost);
+}
+
+TEST_CASE("enumerate_small_query", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(false, devnull, std::cerr);
+
+    run(diag, "CREATE DATABASE test;");
+    run(diag, "USE test;");
+    run(diag, "CREATE TABLE T ( id INT(4) );");
+
+    std::stringstream cardinalities;
+    write_cardinalities(cardinalities, "test", { { { "T0" }, 42 } });
+    auto &DB = C.get_database_in_use();
+    DB.cardinality_estimator(std::make_unique<InjectionCardinalityEstimator>(diag, C.pool("test"), cardinalities));
+    auto &CE = DB.cardinality_estimator();
+
+    /* The kernel for a single relation has no subproblems to join and leaves the plan table as it is. */
+    auto query = m::statement_from_string(diag, "SELECT 1 FROM T AS T0;");
+    auto G = QueryGraph::Build(*query);
+    auto PT = get_plan_table<PlanTable>(*G, CE);
+    REQUIRE(enumerate_small_query(PT, *G, CE));
+
+    const Subproblem T0(1UL);
+    REQUIRE(bool(PT[T0].model));
+    CHECK(CE.predict_cardinality(*PT[T0].model) == 42);
+    CHECK(uint64_t(PT[T0].left) == 0);
+    CHECK(uint64_t(PT[T0].right) == 0);
+}
+
+TEST_CASE("MyPlanEnumerator::reoptimize", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(false, devnull, std::cerr);
+
+    run(diag, "CREATE DATABASE test;");
+    run(diag, "USE test;");
+    run(diag, "CREATE TABLE T ( id INT(4), fid_T1 INT(4), fid_T2 INT(4) );");
+
+    const Subproblem T0(1UL << 0U);
+    const Subproblem T1(1UL << 1U);
+    const Subproblem T2(1UL << 2U);
+
+    std::stringstream cardinalities;
+    auto &DB = C.get_database_in_use();
+    auto set_cardinalities = [&](std::size_t T0_T1, std::size_t T1_T2) {
+        write_cardinalities(cardinalities, "test", {
+            { { "T0" }, 5 },
+            { { "T1" }, 20 },
+            { { "T2" }, 8 },
+            { { "T0", "T1" }, T0_T1 },
+            { { "T1", "T2" }, T1_T2 },
+            { { "T0", "T1", "T2" }, 7 },
+        });
+        DB.cardinality_estimator(std::make_unique<InjectionCardinalityEstimator>(diag, C.pool("test"), cardinalities));
+    };
+
+    auto query = m::statement_from_string(diag, "\
+                                                 SELECT 1\n\
+                                                 FROM T AS T0, T AS T1, T AS T2\n\
+                                                 WHERE T0.fid_T1 = T1.id\n\
+                                                   AND T1.fid_T2 = T2.id\n\
+                                                 ;");
+    auto G = QueryGraph::Build(*query);
+
+    MyPlanEnumerator PE;
+    auto &CF = C.cost_function();
+    Optimizer O(PE, CF);
+
+    /* Optimize for T0 ⋈  (T1 ⋈  T2). */
+    set_cardinalities(90, 4);
+    auto [_, PT] = O.optimize_with_plantable<PlanTable>(*G);
+    REQUIRE(PT.get_final().cost == 11);
+
+    /* Re-optimize for (T0 ⋈  T1) ⋈  T2. */
+    set_cardinalities(7, 110);
+    PE.reoptimize(PT, *G, CF, { T0|T1, T1|T2 });
+
+    CHECK(PT.get_final().cost == 14);
+    auto &final = PT.get_final();
+    CHECK(((final.left == (T0|T1) and final.right == T2) or (final.left == T2 and final.right == (T0|T1))));
+    CHECK(DB.cardinality_estimator().predict_cardinality(*PT[T0|T1].model) == 7);
+    CHECK(DB.cardinality_estimator().predict_cardinality(*PT[T1|T2].model) == 110);
+}
+
+TEST_CASE("MyPlanEnumerator::simplification_budget", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(false, devnull, std::cerr);
+
+    run(diag, "CREATE DATABASE test;");
+    run(diag, "USE test;");
+    run(diag, "CREATE TABLE T ( id INT(4), fid_T1 INT(4), fid_T2 INT(4), fid_T3 INT(4) );");
+
+    const Subproblem T0(1UL << 0U);
+    const Subproblem T1(1UL << 1U);
+    const Subproblem T2(1UL << 2U);
+    const Subproblem T3(1UL << 3U);
+
+    std::stringstream cardinalities;
+    write_cardinalities(cardinalities, "test", {
+        { { "T0" }, 10 },
+        { { "T1" }, 10 },
+        { { "T2" }, 10 },
+        { { "T3" }, 10 },
+        { { "T0", "T1" }, 1000 },
+        { { "T1", "T2" }, 5 },
+        { { "T2", "T3" }, 1000 },
+        { { "T0", "T1", "T2" }, 50 },
+        { { "T1", "T2", "T3" }, 50 },
+        { { "T0", "T1", "T2", "T3" }, 100 },
+    });
+    auto &DB = C.get_database_in_use();
+    DB.cardinality_estimator(std::make_unique<InjectionCardinalityEstimator>(diag, C.pool("test"), cardinalities));
+
+    auto query = m::statement_from_string(diag, "\
+                                                 SELECT 1\n\
+                                                 FROM T AS T0, T AS T1, T AS T2, T AS T3\n\
+                                                 WHERE T0.fid_T1 = T1.id\n\
+                                                   AND T1.fid_T2 = T2.id\n\
+                                                   AND T2.fid_T3 = T3.id\n\
+                                                 ;");
+    auto G = QueryGraph::Build(*query);
+    REQUIRE(UnitGraph(*G).count_ccps(100) == 10);
+
+    /* With a budget of 4 csg-cmp pairs, T1 ⋈  T2 is committed to and the remaining chain of 3 units enumerated. */
+    MyPlanEnumerator PE;
+    PE.simplification_budget = 4;
+    Optimizer O(PE, C.cost_function());
+    auto [_, PT] = O.optimize_with_plantable<PlanTable>(*G);
+
+    CHECK(PT.get_final().cost == 5 + 50 + 100);
+    CHECK(PT.has_plan(T1|T2));
+    CHECK_FALSE(PT.has_plan(T0|T1));
+    CHECK_FALSE(PT.has_plan(T2|T3));
+}
+
+TEST_CASE("MyPlanEnumerator::plan_table_budget", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(false, devnull, std::cerr);
+
+    run(diag, "CREATE DATABASE test;");
+    run(diag, "USE test;");
+    run(diag, "CREATE TABLE T ( id INT(4), fid_T1 INT(4), fid_T2 INT(4), fid_T3 INT(4) );");
+
+    /* Greedy operator ordering joins T0 ⋈  T1 first and ends up with a plan of cost 5 + 1000 + 10, whereas the
+     * optimal plan T0 ⋈  ((T1 ⋈  T2) ⋈  T3) costs 6 + 10 + 10. */
+    std::stringstream cardinalities;
+    write_cardinalities(cardinalities, "test", {
+        { { "T0" }, 10 },
+        { { "T1" }, 10 },
+        { { "T2" }, 10 },
+        { { "T3" }, 10 },
+        { { "T0", "T1" }, 5 },
+        { { "T1", "T2" }, 6 },
+        { { "T2", "T3" }, 2000 },
+        { { "T0", "T1", "T2" }, 1000 },
+        { { "T1", "T2", "T3" }, 10 },
+        { { "T0", "T1", "T2", "T3" }, 10 },
+    });
+    auto &DB = C.get_database_in_use();
+    DB.cardinality_estimator(std::make_unique<InjectionCardinalityEstimator>(diag, C.pool("test"), cardinalities));
+
+    auto query = m::statement_from_string(diag, "\
+                                                 SELECT 1\n\
+                                                 FROM T AS T0, T AS T1, T AS T2, T AS T3\n\
+                                                 WHERE T0.fid_T1 = T1.id\n\
+                                                   AND T1.fid_T2 = T2.id\n\
+                                                   AND T2.fid_T3 = T3.id\n\
+                                                 ;");
+    auto G = QueryGraph::Build(*query);
+
+    MyPlanEnumerator PE;
+    Optimizer O(PE, C.cost_function());
+
+    SECTION("within budget")
+    {
+        PE.plan_table_budget = 1UL << 20;
+        auto [_, PT] = O.optimize_with_plantable<PlanTable>(*G);
+
+        CHECK(PE.bounded_result.exact);
+        CHECK(PE.bounded_result.upper_bound == 5 + 1000 + 10);
+        CHECK(PE.bounded_result.peak_bytes <= PE.plan_table_budget);
+        CHECK(PT.get_final().cost == 6 + 10 + 10);
+    }
+
+    SECTION("budget exceeded")
+    {
+        PE.plan_table_budget = BoundedPlanTable::ENTRY_BYTES;
+        auto [_, PT] = O.optimize_with_plantable<PlanTable>(*G);
+
+        CHECK_FALSE(PE.bounded_result.exact);
+        CHECK(PE.bounded_result.peak_bytes <= PE.plan_table_budget);
+        CHECK(PT.get_final().cost == 5 + 1000 + 10);
+    }
+}
+
+TEST_CASE("BoundedPlanTable", "[milestone3]")
+{
+    const std::size_t budget = 1000 * BoundedPlanTable::ENTRY_BYTES;
+    BoundedPlanTable T(budget);
+    CHECK(T.bytes() > 0); // the reserved bucket array
+    CHECK(T.peak_bytes() == T.bytes());
+
+    /* Fill the table to its budget.  It never rehashes, so the bucket array counts from the start. */
+    uint64_t S = 0;
+    while (T.insert(++S, { 0, 0, nullptr }))
+        CHECK(T.bytes() <= budget);
+    CHECK(T.size() == S - 1);
+    CHECK(T.size() < 1000);
+    CHECK(T.bytes() + BoundedPlanTable::ENTRY_BYTES > budget);
+    CHECK(T.peak_bytes() <= budget);
+
+    /* Replacing a plan is always possible. */
+    CHECK(T.insert(1, { 0, 1, nullptr }));
+    CHECK(T.find(1)->cost == 1);
+}
+
+TEST_CASE("ParetoSet", "[milestone3]")
+{
+    auto plan = [](double cost, order_type order) {
+        return OrderedPlan { Subproblem(), Subproblem(), cost, order, NO_ORDER, NO_ORDER, PhysicalOperator::Scan };
+    };
+
+    ParetoSet set;
+
+    SECTION("one plan per order")
+    {
+        CHECK(set.insert(plan(10, NO_ORDER), false));
+        CHECK(set.insert(plan(15, 0), false));
+        CHECK(set.insert(plan(12, 1), false));
+        CHECK(set.plans.size() == 3);
+
+        CHECK_FALSE(set.insert(plan(16, 0), false)); // dominated by same order
+        CHECK_FALSE(set.insert(plan(11, NO_ORDER), false)); // dominated by cheaper unordered plan
+        CHECK(set.insert(plan(14, 0), false)); // replaces the plan of order 0
+        CHECK(set.plans.size() == 3);
+        CHECK(set.find(0)->cost == 14);
+
+        CHECK(set.cheapest().cost == 10);
+    }
+
+    SECTION("ordered plans dominate unordered plans")
+    {
+        CHECK(set.insert(plan(10, NO_ORDER), false));
+        CHECK(set.insert(plan(9, 0), false));
+        CHECK(set.plans.size() == 1);
+        CHECK(set.find(NO_ORDER) == nullptr);
+        CHECK(set.cheapest().order == 0);
+    }
+
+    SECTION("cheapest only")
+    {
+        CHECK(set.insert(plan(10, NO_ORDER), true));
+        CHECK_FALSE(set.insert(plan(15, 0), true));
+        CHECK(set.insert(plan(5, 1), true));
+        CHECK(set.plans.size() == 1);
+        CHECK(set.cheapest().order == 1);
+    }
+}
+
+TEST_CASE("SerializedPlan", "[milestone3]")
+{
+    SerializedPlan plan;
+    plan.fingerprint = plan_fingerprint("SELECT 1 FROM T;", "{}");
+    plan.num_sources = 3;
+    plan.joins.push_back({ 0b010, 0b100, 4, 4 });
+    plan.joins.push_back({ 0b001, 0b110, 11, 7 });
+
+    std::stringstream ss;
+    plan.write(ss);
+
+    SECTION("round trip")
+    {
+        auto read = SerializedPlan::read(ss);
+        REQUIRE(read.has_value());
+        CHECK(read->fingerprint == plan.fingerprint);
+        CHECK(read->num_sources == 3);
+        REQUIRE(read->joins.size() == 2);
+        CHECK(read->joins[1].left == 0b001);
+        CHECK(read->joins[1].right == 0b110);
+        CHECK(read->joins[1].cost == 11);
+        CHECK(read->joins[1].cardinality == 7);
+    }
+
+    SECTION("other version")
+    {
+        std::string bytes = ss.str();
+        bytes[sizeof(SerializedPlan::MAGIC)] ^= 0xff;
+        std::istringstream in(bytes);
+        CHECK_FALSE(SerializedPlan::read(in).has_value());
+    }
+
+    SECTION("truncated")
+    {
+        std::istringstream in(ss.str().substr(0, ss.str().size() - 1));
+        CHECK_FALSE(SerializedPlan::read(in).has_value());
+    }
+
+    SECTION("number of joins")
+    {
+        SerializedPlan other = plan;
+        other.joins.pop_back();
+        std::stringstream out;
+        other.write(out);
+        CHECK_FALSE(SerializedPlan::read(out).has_value());
+    }
+
+    SECTION("check against the query graph")
+    {
+        Catalog::Clear();
+        NullStream devnull;
+        m::Diagnostic diag(false, devnull, std::cerr);
+        run(diag, "CREATE DATABASE test;");
+        run(diag, "USE test;");
+        run(diag, "CREATE TABLE T ( id INT(4), fid INT(4) );");
+        auto query = m::statement_from_string(diag, "SELECT 1 FROM T AS T0, T AS T1, T AS T2 "
+                                                    "WHERE T0.fid = T1.id AND T1.fid = T2.id;");
+        auto G = QueryGraph::Build(*query);
+
+        CHECK_FALSE(plan.check(*G).has_value());
+
+        SerializedPlan other = plan;
+        SECTION("data sources") { other.num_sources = 4; other.joins.push_back({ 0b0111, 0b1000, 12, 7 }); }
+        SECTION("outside the query") { other.joins[0].right = 0b1100; }
+        SECTION("empty side") { other.joins[0].left = 0; }
+        SECTION("overlapping sides") { other.joins[1].right = 0b111; }
+        SECTION("not bottom up") { std::swap(other.joins[0], other.joins[1]); }
+        SECTION("subproblem joined twice") { other.joins[1] = { 0b010, 0b101, 11, 7 }; }
+        CHECK(other.check(*G).has_value());
+    }
+
+    CHECK(plan_fingerprint("SELECT 1 FROM T;", "{}") != plan_fingerprint("SELECT 1 FROM T;", "{ }"));
 }
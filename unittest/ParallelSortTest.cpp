@@ -0,0 +1,85 @@
+#include "catch2/catch.hpp"
+
+#include "ParallelSort.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+
+TEST_CASE("ParallelSort", "[milestone3]")
+{
+    /* Rows of a PAX layout with blocks of 100 tuples: a CHAR(12) name, an INT(4) group and an INT(8) size. */
+    constexpr std::size_t NUM_ROWS = 20'000, TUPLES_PER_BLOCK = 100, BLOCK_SIZE = 100 * (12 + 4 + 8);
+    std::vector<uint8_t> memory((NUM_ROWS + TUPLES_PER_BLOCK - 1) / TUPLES_PER_BLOCK * BLOCK_SIZE);
+    const LayoutColumn name{ memory.data(), TUPLES_PER_BLOCK, BLOCK_SIZE, 0, 12, 12, true };
+    const LayoutColumn group{ memory.data(), TUPLES_PER_BLOCK, BLOCK_SIZE, 1200, 4, 4, false };
+    const LayoutColumn size{ memory.data(), TUPLES_PER_BLOCK, BLOCK_SIZE, 1600, 8, 8, false };
+
+    std::vector<std::string> names(NUM_ROWS);
+    std::vector<int32_t> groups(NUM_ROWS);
+    std::vector<int64_t> sizes(NUM_ROWS);
+    std::mt19937_64 g(42);
+    for (std::size_t row = 0; row != NUM_ROWS; ++row) {
+        names[row] = "pkg" + std::to_string(g() % 5000);
+        groups[row] = int32_t(g() % 21) - 10;
+        sizes[row] = int64_t(g() % 2'000'000) - 1'000'000;
+        std::memcpy(const_cast<uint8_t*>(name.at(row)), names[row].data(), names[row].size());
+        std::memcpy(const_cast<uint8_t*>(group.at(row)), &groups[row], sizeof(int32_t));
+        std::memcpy(const_cast<uint8_t*>(size.at(row)), &sizes[row], sizeof(int64_t));
+    }
+
+    auto expected = [&](auto less) {
+        std::vector<uint32_t> rows(NUM_ROWS);
+        std::iota(rows.begin(), rows.end(), 0);
+        std::stable_sort(rows.begin(), rows.end(), less);
+        return rows;
+    };
+
+    ThreadPool pool(4);
+    ParallelSort sort;
+    sort.morsel_size = 1000;
+
+    SECTION("integer descending")
+    {
+        const auto rows = expected([&](uint32_t l, uint32_t r) { return sizes[l] > sizes[r]; });
+        CHECK(sort(pool, { SortKey{ size, true } }, NUM_ROWS) == rows);
+        const auto top = sort.top_k(pool, { SortKey{ size, true } }, NUM_ROWS, 10);
+        CHECK(top == std::vector<uint32_t>(rows.begin(), rows.begin() + 10));
+    }
+
+    SECTION("string")
+    {
+        const auto rows = expected([&](uint32_t l, uint32_t r) { return names[l] < names[r]; });
+        CHECK(sort(pool, { SortKey{ name } }, NUM_ROWS) == rows);
+        const auto top = sort.top_k(pool, { SortKey{ name } }, NUM_ROWS, 100);
+        CHECK(top == std::vector<uint32_t>(rows.begin(), rows.begin() + 100));
+    }
+
+    SECTION("several keys")
+    {
+        const auto rows = expected([&](uint32_t l, uint32_t r) {
+            if (groups[l] != groups[r])
+                return groups[l] < groups[r];
+            return names[l] > names[r];
+        });
+        CHECK(sort(pool, { SortKey{ group }, SortKey{ name, true } }, NUM_ROWS) == rows);
+        CHECK(sort.top_k(pool, { SortKey{ group }, SortKey{ name, true } }, NUM_ROWS, NUM_ROWS) == rows);
+    }
+
+    SECTION("few rows")
+    {
+        const auto rows = expected([&](uint32_t l, uint32_t r) { return sizes[l] < sizes[r]; });
+        const auto sorted = sort(pool, { SortKey{ size } }, 10);
+        std::vector<uint32_t> first(10);
+        std::iota(first.begin(), first.end(), 0);
+        std::stable_sort(first.begin(), first.end(), [&](uint32_t l, uint32_t r) { return sizes[l] < sizes[r]; });
+        CHECK(sorted == first);
+        CHECK(sort.top_k(pool, { SortKey{ size } }, NUM_ROWS, 0).empty());
+        CHECK(sort.top_k(pool, { SortKey{ size } }, NUM_ROWS, 1).front() == rows.front());
+    }
+}
@@ -0,0 +1,168 @@
+#include "catch2/catch.hpp"
+
+#include "milestone3_utils.hpp"
+#include "FeedbackCardinalityEstimator.hpp"
+#include "MyPlanEnumerator.hpp"
+#include "PipelineExecutor.hpp"
+#include "PlanExecutor.hpp"
+#include "ThreadPool.hpp"
+#include "nullstream.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+using namespace m;
+
+
+TEST_CASE("PipelineExecutor", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    m::Diagnostic diag(false, devnull, std::cerr);
+
+    for (auto sql : { "CREATE DATABASE test;", "USE test;",
+                      "CREATE TABLE T ( id INT(4), fid_T1 INT(4), fid_T2 INT(4) );" })
+        m::execute_statement(diag, *m::statement_from_string(diag, sql));
+
+    /* T0 has 100 rows, T1 has 20 and T2 has 10.  Row `i` of T0 references row `i % 20` of T1, row `i` of T1
+     * references row `i % 10` of T2. */
+    auto make_table = [](std::size_t num_rows) {
+        ColumnarTable table;
+        table.num_rows = num_rows;
+        std::vector<int64_t> id, fid_T1, fid_T2;
+        for (int64_t i = 0; i != int64_t(num_rows); ++i) {
+            id.push_back(i);
+            fid_T1.push_back(i % 20);
+            fid_T2.push_back(i % 10);
+        }
+        table.generate(0, std::move(id));
+        table.generate(1, std::move(fid_T1));
+        table.generate(2, std::move(fid_T2));
+        return table;
+    };
+    const ColumnarTable T0 = make_table(100), T1 = make_table(20), T2 = make_table(10);
+
+    ThreadPool pool(4);
+    MyPlanEnumerator PE;
+    Optimizer O(PE, C.cost_function());
+
+    SECTION("joins only")
+    {
+        auto query = m::statement_from_string(diag, "\
+                                                     SELECT 1\n\
+                                                     FROM T AS T0, T AS T1, T AS T2\n\
+                                                     WHERE T0.fid_T1 = T1.id\n\
+                                                       AND T1.fid_T2 = T2.id\n\
+                                                     ;");
+        auto G = QueryGraph::Build(*query);
+        auto [_, PT] = O.optimize_with_plantable<PlanTableLargeAndSparse>(*G);
+
+        PipelineExecutor pipelined(*G, { &T0, &T1, &T2 });
+        PlanExecutor materialized(*G, { &T0, &T1, &T2 });
+        const auto result = pipelined(pool, PT, C.get_database_in_use().cardinality_estimator());
+        const auto expected = materialized(PT);
+
+        CHECK(pipelined.num_pipelines() == 3);
+        CHECK(result.num_tuples == 100);
+        CHECK(result.num_tuples == expected.num_tuples);
+        CHECK(result.checksum == expected.checksum);
+    }
+
+    SECTION("adaptive")
+    {
+        auto query = m::statement_from_string(diag, "\
+                                                     SELECT 1\n\
+                                                     FROM T AS T0, T AS T1, T AS T2\n\
+                                                     WHERE T0.fid_T1 = T1.id\n\
+                                                       AND T1.fid_T2 = T2.id\n\
+                                                     ;");
+        auto G = QueryGraph::Build(*query);
+        auto [_, PT_expected] = O.optimize_with_plantable<PlanTableLargeAndSparse>(*G);
+        PlanExecutor materialized(*G, { &T0, &T1, &T2 });
+        const auto expected = materialized(PT_expected);
+
+        /* The tables of the database are empty, hence every build side is larger than estimated. */
+        FeedbackCardinalityEstimator feedback(C.get_database_in_use().cardinality_estimator());
+        MyPlanEnumerator adaptive_PE;
+        adaptive_PE.cardinality_estimator = &feedback;
+        auto PT = get_plan_table<PlanTableLargeAndSparse>(*G, feedback);
+        adaptive_PE(enumerate_tag{}, PT, *G, C.cost_function());
+
+        PipelineExecutor adaptive(*G, { &T0, &T1, &T2 });
+        const auto result = adaptive(pool, PT, feedback, adaptive_PE, C.cost_function());
+
+        CHECK(adaptive.num_replans >= 1);
+        CHECK(feedback.num_observations() >= 1);
+        CHECK(result.num_tuples == 100);
+        CHECK(result.num_tuples == expected.num_tuples);
+        CHECK(result.checksum == expected.checksum);
+    }
+
+    SECTION("filter and cycle")
+    {
+        auto query = m::statement_from_string(diag, "\
+                                                     SELECT 1\n\
+                                                     FROM T AS T0, T AS T1, T AS T2\n\
+                                                     WHERE T0.fid_T1 = T1.id\n\
+                                                       AND T1.fid_T2 = T2.id\n\
+                                                       AND T0.fid_T2 = T2.id\n\
+                                                       AND T0.id < 50\n\
+                                                     ;");
+        auto G = QueryGraph::Build(*query);
+        auto [_, PT] = O.optimize_with_plantable<PlanTableLargeAndSparse>(*G);
+
+        PipelineExecutor pipelined(*G, { &T0, &T1, &T2 });
+        const auto result = pipelined(pool, PT, C.get_database_in_use().cardinality_estimator());
+
+        /* Row `i` of T0 joins row `i % 20` of T1 and row `i % 10` of T2, which also satisfies the cycle. */
+        uint64_t checksum = 0;
+        for (uint64_t i = 0; i != 50; ++i)
+            checksum += i + i % 20 + i % 10;
+        CHECK(result.num_tuples == 50);
+        CHECK(result.checksum == checksum);
+
+        /* The materializing executor does not support filters and rejects them instead of ignoring them. */
+        CHECK_THROWS_AS(PlanExecutor(*G, { &T0, &T1, &T2 }), std::invalid_argument);
+    }
+
+    SECTION("store with 64 bit values and NULL")
+    {
+        /* 705032704 is 5000000000 truncated to 32 bits. */
+        for (auto sql : { "CREATE TABLE U ( id INT(8), fid INT(8) );",
+                          "INSERT INTO U VALUES (5000000000, 5000000001), (5000000001, NULL), (NULL, 5000000000), "
+                          "(705032704, 5000000000), (5000000002, 705032704);" })
+            m::execute_statement(diag, *m::statement_from_string(diag, sql));
+        const ColumnarTable U = ColumnarTable::Of(C.get_database_in_use().get_table(C.pool("U")));
+        REQUIRE(U.num_rows == 5);
+
+        /* Row 0 joins row 1, row 3 joins row 0 and row 4 joins row 3, none of them by truncated values. */
+        auto join = m::statement_from_string(diag, "SELECT 1 FROM U AS U0, U AS U1 WHERE U0.fid = U1.id;");
+        auto G_join = QueryGraph::Build(*join);
+        auto PT_join = O.optimize_with_plantable<PlanTableLargeAndSparse>(*G_join).second;
+        PipelineExecutor pipelined_join(*G_join, { &U, &U });
+        PlanExecutor materialized_join(*G_join, { &U, &U });
+        const auto result_join = pipelined_join(pool, PT_join, C.get_database_in_use().cardinality_estimator());
+        const auto expected_join = materialized_join(PT_join);
+        CHECK(result_join.num_tuples == 3);
+        CHECK(result_join.checksum == 0 + 1 + 3 + 0 + 4 + 3);
+        CHECK(expected_join.num_tuples == 3);
+        CHECK(expected_join.checksum == result_join.checksum);
+
+        /* The filter selects rows 0, 1 and 4, of which row 1 joins nothing by its NULL. */
+        auto query = m::statement_from_string(diag, "\
+                                                     SELECT 1\n\
+                                                     FROM U AS U0, U AS U1\n\
+                                                     WHERE U0.fid = U1.id\n\
+                                                       AND U0.id >= 5000000000\n\
+                                                     ;");
+        auto G = QueryGraph::Build(*query);
+        auto [_, PT] = O.optimize_with_plantable<PlanTableLargeAndSparse>(*G);
+        PipelineExecutor pipelined(*G, { &U, &U });
+        const auto result = pipelined(pool, PT, C.get_database_in_use().cardinality_estimator());
+        CHECK(result.num_tuples == 2);
+        CHECK(result.checksum == 0 + 1 + 4 + 3);
+    }
+}
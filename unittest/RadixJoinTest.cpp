@@ -0,0 +1,72 @@
+#include "catch2/catch.hpp"
+
+#include "RadixJoin.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+namespace {
+
+std::vector<std::pair<uint32_t, uint32_t>> sorted_pairs(const JoinMatches &matches)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    for (std::size_t i = 0; i != matches.size(); ++i)
+        pairs.emplace_back(matches.build[i], matches.probe[i]);
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+}
+
+TEST_CASE("RadixJoinConfig::passes", "[milestone3]")
+{
+    RadixJoinConfig config;
+    config.cache_bytes = 4096;
+    config.llc_bytes = 1UL << 20;
+    config.max_bits_per_pass = 3;
+
+    CHECK(config.passes(100).empty()); // fits into the LLC
+
+    /* The hash table of 100000 entries takes 32768 buckets of 65 bytes, i.e. 2^10 partitions fit into 4096 bytes. */
+    const auto passes = config.passes(100'000);
+    REQUIRE(passes.size() == 4);
+    CHECK(passes[0] + passes[1] + passes[2] + passes[3] == 10);
+    CHECK(passes[0] >= passes[1]);
+    CHECK(passes[1] >= passes[2]);
+    CHECK(passes[2] >= passes[3]);
+    CHECK(passes[0] - passes[3] <= 1);
+    CHECK(passes[0] <= 3);
+}
+
+TEST_CASE("radix_join", "[milestone3]")
+{
+    RadixJoinConfig config;
+    config.cache_bytes = 4096;
+    config.llc_bytes = 0; // always partition
+    config.max_bits_per_pass = 3;
+
+    /* A foreign key join of 10000 unique keys with 30000 references, some of which are dangling. */
+    std::vector<int32_t> build(10'000), probe(30'000);
+    for (std::size_t i = 0; i != build.size(); ++i)
+        build[i] = i;
+    std::shuffle(build.begin(), build.end(), std::mt19937(42));
+    std::mt19937 g(1337);
+    std::uniform_int_distribution<int32_t> dist(-100, 10'099);
+    for (auto &key : probe)
+        key = dist(g);
+
+    REQUIRE(config.passes(build.size()).size() > 1);
+
+    const JoinMatches expected = hash_join(build.data(), build.size(), probe.data(), probe.size());
+    for (std::size_t num_threads : { 1, 4 }) {
+        ThreadPool pool(num_threads);
+        const JoinMatches actual = radix_join(pool, config, build.data(), build.size(), probe.data(), probe.size());
+        CHECK(sorted_pairs(actual) == sorted_pairs(expected));
+    }
+
+    for (std::size_t i = 0; i != expected.size(); ++i)
+        CHECK(build[expected.build[i]] == probe[expected.probe[i]]);
+}
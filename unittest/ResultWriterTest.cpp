@@ -0,0 +1,83 @@
+#include "catch2/catch.hpp"
+
+#include "ResultWriter.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+
+namespace {
+
+/** Returns everything written to \p file so far. */
+std::string contents(std::FILE *file)
+{
+    std::string result;
+    std::rewind(file);
+    char buffer[4096];
+    for (std::size_t n; (n = std::fread(buffer, 1, sizeof(buffer), file)) != 0; )
+        result.append(buffer, n);
+    return result;
+}
+
+}
+
+TEST_CASE("ResultWriter", "[milestone3]")
+{
+    std::FILE *file = std::tmpfile();
+    REQUIRE(file);
+    const int fd = fileno(file);
+
+    SECTION("text")
+    {
+        {
+            ResultWriter writer(fd);
+            writer << "Package with id " << 42 << " is " << int64_t(-1234567890123) << " bytes.\n";
+            writer.row(1, "a,b", 2.5);
+            CHECK(contents(file).empty()); // nothing is written before flushing
+        }
+        CHECK(contents(file) == "Package with id 42 is -1234567890123 bytes.\n1,\"a,b\",2.5\n");
+    }
+
+    SECTION("CSV")
+    {
+        ResultWriter writer(fd, ResultWriter::Format::CSV);
+        writer.row(int32_t(7), "plain", "with \"quotes\", and a comma");
+        writer.flush();
+        CHECK(contents(file) == "7,plain,\"with \"\"quotes\"\", and a comma\"\n");
+    }
+
+    SECTION("binary")
+    {
+        ResultWriter writer(fd, ResultWriter::Format::Binary);
+        writer.row(int32_t(-1), "ab");
+        writer.flush();
+        const std::string bytes = contents(file);
+        REQUIRE(bytes.size() == sizeof(int64_t) + sizeof(uint32_t) + 2);
+        int64_t value;
+        uint32_t length;
+        std::memcpy(&value, bytes.data(), sizeof(value));
+        std::memcpy(&length, bytes.data() + sizeof(value), sizeof(length));
+        CHECK(value == -1);
+        CHECK(length == 2);
+        CHECK(bytes.substr(sizeof(value) + sizeof(length)) == "ab");
+    }
+
+    SECTION("small buffer")
+    {
+        /* Strings larger than the buffer are written directly, everything else is buffered up to its capacity. */
+        std::string expected;
+        {
+            ResultWriter writer(fd, ResultWriter::Format::Text, 64);
+            const std::string large(100, 'x');
+            for (int i = 0; i != 100; ++i) {
+                writer << i << ' ' << large << '\n';
+                expected += std::to_string(i) + ' ' + large + '\n';
+            }
+        }
+        CHECK(contents(file) == expected);
+    }
+
+    std::fclose(file);
+}
@@ -0,0 +1,203 @@
+#include "catch2/catch.hpp"
+
+#include "ResultWriter.hpp"
+#include "SecondaryIndex.hpp"
+#include "ThreadPool.hpp"
+#include "data_layouts.hpp"
+#include "nullstream.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+using namespace m;
+
+
+TEST_CASE("SecondaryIndex", "[milestone3]")
+{
+    Catalog::Clear();
+    auto &C = Catalog::Get();
+    auto register_layout = [&C](const char *name, std::unique_ptr<storage::DataLayoutFactory> factory) {
+        try {
+            C.register_data_layout(name, std::move(factory), name);
+        } catch (std::invalid_argument) { } // registered by an earlier test
+    };
+    register_layout("row_naive", std::make_unique<MyNaiveRowLayoutFactory>());
+    register_layout("row_optimized", std::make_unique<MyOptimizedRowLayoutFactory>());
+    register_layout("PAX4k", std::make_unique<MyPAX4kLayoutFactory>());
+    NullStream devnull;
+    Diagnostic diag(false, devnull, std::cerr);
+
+    auto &DB = C.add_database(C.pool("test_db"));
+    auto &table = DB.add_table(C.pool("test"));
+    table.push_back(C.pool("name"),  Type::Get_Char(Type::TY_Vector, 8));
+    table.push_back(C.pool("id"),    Type::Get_Integer(Type::TY_Vector, 2));
+    table.push_back(C.pool("value"), Type::Get_Integer(Type::TY_Vector, 8));
+
+    const char *layout = GENERATE("row_naive", "row_optimized", "PAX4k");
+    table.store(C.create_store(table));
+    table.layout(C.data_layout(layout));
+
+    /* Row `i` is named after `i % 100`, has id `i % 7` and value `(i * 37) % 1000 - 500`, i.e. every value twice. */
+    auto value_of = [](int64_t i) { return (i * 37) % 1000 - 500; };
+    std::ostringstream insert;
+    insert << "INSERT INTO test VALUES ";
+    for (int64_t i = 0; i != 2000; ++i)
+        insert << (i ? ", " : "") << "(\"n" << i % 100 << "\", " << i % 7 << ", " << value_of(i) << ')';
+    insert << ';';
+    C.set_database_in_use(DB);
+    execute_statement(diag, *statement_from_string(diag, insert.str()));
+    REQUIRE(table.store().num_rows() == 2000);
+
+    ThreadPool pool(4);
+    IndexRegistry indexes;
+    indexes.add(table, C.pool("value"));
+    CHECK_THROWS_AS(indexes.add(table, C.pool("name")), std::invalid_argument);
+    indexes.sync(pool);
+
+    std::vector<std::unique_ptr<ast::Stmt>> statements; // outlive the scans referring to their expressions
+    auto route = [&](const char *sql) {
+        auto &stmt = statements.emplace_back(statement_from_string(diag, sql));
+        REQUIRE(stmt);
+        return indexes.route(as<const ast::SelectStmt>(*stmt));
+    };
+    /* Returns the text \p write writes to a `ResultWriter`. */
+    auto capture = [](auto &&write) {
+        std::FILE *file = std::tmpfile();
+        REQUIRE(file);
+        {
+            ResultWriter out(fileno(file));
+            write(out);
+        }
+        std::string text;
+        std::rewind(file);
+        char buffer[4096];
+        for (std::size_t n; (n = std::fread(buffer, 1, sizeof(buffer), file)) != 0; )
+            text.append(buffer, n);
+        std::fclose(file);
+        return text;
+    };
+    /* Runs \p scan and returns the number of rows and their text written. */
+    auto run = [&capture](const IndexRangeScan &scan) {
+        std::size_t num_rows;
+        auto text = capture([&](ResultWriter &out) { num_rows = scan(out); });
+        return std::pair(num_rows, text);
+    };
+
+    SECTION("range scan")
+    {
+        auto scan = route("SELECT id, name, value * 2, \"x\" FROM test WHERE value >= 10 - 20 AND 5 > value;");
+        REQUIRE(scan);
+        CHECK(scan->lo == -10);
+        CHECK(scan->hi == 4);
+
+        /* The rows in range in ascending order of their values, and of their row ids for equal values. */
+        std::string expected;
+        for (int64_t value = -10; value <= 4; ++value) {
+            for (int64_t i = 0; i != 2000; ++i) {
+                if (value_of(i) == value)
+                    expected += std::to_string(i % 7) + ",\"n" + std::to_string(i % 100) + "\"," +
+                                std::to_string(2 * value) + ",\"x\"\n";
+            }
+        }
+        CHECK(run(*scan) == std::pair<std::size_t, std::string>(30, expected));
+    }
+
+    SECTION("empty range")
+    {
+        auto scan = route("SELECT id FROM test WHERE value > 3 AND value < 2;");
+        REQUIRE(scan);
+        CHECK(run(*scan).first == 0);
+    }
+
+    SECTION("not routed")
+    {
+        CHECK_FALSE(route("SELECT id FROM test WHERE id < 3;"));
+        CHECK_FALSE(route("SELECT id FROM test WHERE value < 3 OR value > 10;"));
+        CHECK_FALSE(route("SELECT id FROM test WHERE value < 3 AND id = 1;"));
+        CHECK_FALSE(route("SELECT id FROM test WHERE value < 3 ORDER BY id;"));
+        CHECK_FALSE(route("SELECT * FROM test WHERE value < 3;"));
+        CHECK_FALSE(route("SELECT id / value FROM test WHERE value < 3;"));
+        CHECK_FALSE(route("SELECT id FROM test;"));
+    }
+
+    SECTION("in sync after insert")
+    {
+        execute_statement(diag, *statement_from_string(diag, "INSERT INTO test VALUES (\"new\", 1, 100000);"));
+        CHECK_FALSE(route("SELECT id FROM test WHERE value > 99999;")); // the index is stale
+        indexes.sync(pool);
+        auto scan = route("SELECT id FROM test WHERE value > 99999;");
+        REQUIRE(scan);
+        CHECK(run(*scan) == std::pair<std::size_t, std::string>(1, "1\n"));
+    }
+
+    SECTION("in sync after many inserts")
+    {
+        /* Insert more rows one by one than fit in the delta, such that it is merged into the tree. */
+        for (int64_t i = 2000; i != 2400; ++i) {
+            std::ostringstream sql;
+            sql << "INSERT INTO test VALUES (\"n" << i % 100 << "\", " << i % 7 << ", " << value_of(i) << ");";
+            execute_statement(diag, *statement_from_string(diag, sql.str()));
+            indexes.sync(pool);
+        }
+        REQUIRE(indexes.find(table.at(C.pool("value")))->num_rows() == 2400);
+
+        auto scan = route("SELECT id, value FROM test WHERE value >= -3 AND value <= 3;");
+        REQUIRE(scan);
+        std::string expected;
+        std::size_t num_expected = 0;
+        for (int64_t value = -3; value <= 3; ++value) {
+            for (int64_t i = 0; i != 2400; ++i) {
+                if (value_of(i) == value) {
+                    expected += std::to_string(i % 7) + ',' + std::to_string(value) + '\n';
+                    ++num_expected;
+                }
+            }
+        }
+        CHECK(run(*scan) == std::pair(num_expected, expected));
+    }
+
+    SECTION("NULL")
+    {
+        execute_statement(diag, *statement_from_string(diag, "INSERT INTO test VALUES (\"a\", 1, NULL), (NULL, 2, 3), "
+                                                             "(\"b\", NULL, 3), (NULL, NULL, -4), (\"c\", 3, NULL);"));
+        indexes.sync(pool);
+
+        /* Returns the lines of \p text in ascending order, as a scan orders rows by value rather than by row id. */
+        auto sorted_lines = [](const std::string &text) {
+            std::vector<std::string> lines;
+            std::istringstream in(text);
+            for (std::string line; std::getline(in, line); )
+                lines.push_back(line);
+            std::sort(lines.begin(), lines.end());
+            return lines;
+        };
+
+        /* The scan must produce the rows mutable produces for the same query, NULL included. */
+        for (auto sql : { "SELECT id, name, value * 2, \"x\" FROM test WHERE value >= -10 AND value < 5;",
+                          "SELECT name, id + value FROM test WHERE value = 3;",
+                          "SELECT value FROM test WHERE value > -1000;" })
+        {
+            auto scan = route(sql);
+            REQUIRE(scan);
+            auto [num_rows, text] = run(*scan);
+
+            std::size_t num_expected = 0;
+            auto expected = capture([&](ResultWriter &out) {
+                auto op = std::make_unique<CallbackOperator>([&](const Schema &S, const Tuple &t) {
+                    ++num_expected;
+                    out.tuple(S, t);
+                });
+                execute_query(diag, as<const ast::SelectStmt>(*statements.back()), std::move(op));
+            });
+            CHECK(num_rows == num_expected);
+            CHECK(sorted_lines(text) == sorted_lines(expected));
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include "catch2/catch.hpp"
+
+#include "SortedRuns.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+
+
+TEST_CASE("SortedRuns", "[milestone3]")
+{
+    ThreadPool pool(4);
+
+    SECTION("empty")
+    {
+        SortedRuns<int64_t, int32_t> runs(pool, 16);
+        runs.finish();
+        CHECK(runs.size() == 0);
+        CHECK(runs.num_runs() == 0);
+        CHECK(runs.begin() == runs.end());
+    }
+
+    auto check_merge = [&pool](std::size_t num_pairs, std::size_t chunk_size) {
+        std::vector<std::pair<int64_t, int32_t>> expected;
+        SortedRuns<int64_t, int32_t> runs(pool, chunk_size);
+        std::mt19937_64 g(42);
+        for (std::size_t i = 0; i != num_pairs; ++i) {
+            const int64_t key = int64_t(g() % 1000) - 500; // many duplicates
+            runs.push_back(key, int32_t(i));
+            expected.emplace_back(key, int32_t(i));
+        }
+        runs.finish();
+        std::sort(expected.begin(), expected.end());
+
+        CHECK(runs.size() == num_pairs);
+        CHECK(runs.num_runs() == (num_pairs + chunk_size - 1) / chunk_size);
+        std::vector<std::pair<int64_t, int32_t>> merged;
+        for (auto it = runs.begin(), end = runs.end(); it != end; ++it)
+            merged.push_back(*it);
+        CHECK(merged == expected);
+    };
+
+    SECTION("one partial chunk") { check_merge(100, 1000); }
+    SECTION("full chunks") { check_merge(20'000, 1000); }
+    SECTION("last chunk partial") { check_merge(20'500, 1000); }
+    SECTION("chunks of one pair") { check_merge(500, 1); }
+}
@@ -0,0 +1,101 @@
+#include "catch2/catch.hpp"
+
+#include "milestone3_utils.hpp"
+#include "MyPlanEnumerator.hpp"
+#include "SubplanCache.hpp"
+#include "nullstream.hpp"
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <sstream>
+
+
+using namespace m;
+
+using PlanTable = m::PlanTableLargeAndSparse;
+
+
+TEST_CASE("SubplanCache", "[milestone3]")
+{
+    Catalog::Clear();
+    Catalog &C = Catalog::Get();
+    NullStream devnull;
+    Diagnostic diag(false, devnull, std::cerr);
+
+    for (auto sql : { "CREATE DATABASE test;", "USE test;",
+                      "CREATE TABLE T ( id INT(4), fid INT(4) );",
+                      "CREATE TABLE U ( id INT(4), fid INT(4) );" })
+        execute_statement(diag, *statement_from_string(diag, sql));
+    auto &CE = C.get_database_in_use().cardinality_estimator();
+    auto &CF = C.cost_function();
+
+    auto optimize = [&](const QueryGraph &G) {
+        MyPlanEnumerator PE;
+        auto PT = get_plan_table<PlanTable>(G, CE);
+        PE(enumerate_tag{}, PT, G, CF);
+        return PT;
+    };
+
+    /* A chain T0 - T1 - T2 - T3. */
+    auto chain = statement_from_string(diag, "SELECT 1 FROM T AS T0, T AS T1, T AS T2, T AS T3 "
+                                             "WHERE T0.fid = T1.id AND T1.fid = T2.id AND T2.fid = T3.id;");
+    auto G_chain = QueryGraph::Build(*chain);
+    const PlanTable PT_chain = optimize(*G_chain);
+
+    SubplanCache cache;
+    cache.add(PT_chain, *G_chain, "cardinalities");
+    CHECK(cache.size() == 3); // one subplan per join of the plan
+
+    SECTION("canonical form")
+    {
+        auto reordered = statement_from_string(diag, "SELECT 1 FROM T AS T3, T AS T2, T AS T1, T AS T0 "
+                                                     "WHERE T2.fid = T3.id AND T1.fid = T2.id AND T0.fid = T1.id;");
+        auto G_reordered = QueryGraph::Build(*reordered);
+        const CanonicalSubproblem a(*G_chain, 0b1111), b(*G_reordered, 0b1111);
+        CHECK_FALSE(a.key.empty());
+        CHECK(a.key == b.key);
+        CHECK(b.from_canonical(b.to_canonical(0b0101)) == 0b0101);
+        CHECK(a.key != CanonicalSubproblem(*G_chain, 0b0111).key);
+
+        /* Replaying the plan for the reordered query yields a plan of the same cost. */
+        auto PT = get_plan_table<PlanTable>(*G_reordered, CE);
+        REQUIRE(cache.replay(PT, *G_reordered, "cardinalities", CE, CF));
+        CHECK(PT.get_final().cost == PT_chain.get_final().cost);
+    }
+
+    SECTION("common subexpression")
+    {
+        /* Query one input of the final join of the chain with at least two data sources, a range of the chain, in
+         * reverse order. */
+        auto &final = PT_chain[SmallBitset(0b1111)];
+        const uint64_t S = std::popcount(uint64_t(final.left)) > 1 ? uint64_t(final.left) : uint64_t(final.right);
+        const int first = std::countr_zero(S), last = 63 - std::countl_zero(S);
+        std::ostringstream sql;
+        sql << "SELECT 1 FROM ";
+        for (int i = last; i >= first; --i)
+            sql << (i == last ? "" : ", ") << "T AS T" << i;
+        for (int i = last - 1; i >= first; --i)
+            sql << (i == last - 1 ? " WHERE " : " AND ") << 'T' << i << ".fid = T" << i + 1 << ".id";
+        sql << ';';
+        auto sub = statement_from_string(diag, sql.str());
+        auto G_sub = QueryGraph::Build(*sub);
+
+        auto PT = get_plan_table<PlanTable>(*G_sub, CE);
+        REQUIRE(cache.replay(PT, *G_sub, "cardinalities", CE, CF));
+        CHECK(PT.get_final().cost == optimize(*G_sub).get_final().cost);
+    }
+
+    SECTION("not shared")
+    {
+        /* Other tables, other join conditions or other cardinalities. */
+        for (auto sql : { "SELECT 1 FROM U AS T0, T AS T1 WHERE T0.fid = T1.id;",
+                          "SELECT 1 FROM T AS T0, T AS T1 WHERE T0.id = T1.id;" }) {
+            auto stmt = statement_from_string(diag, sql);
+            auto G = QueryGraph::Build(*stmt);
+            auto PT = get_plan_table<PlanTable>(*G, CE);
+            CHECK_FALSE(cache.replay(PT, *G, "cardinalities", CE, CF));
+        }
+        auto PT = get_plan_table<PlanTable>(*G_chain, CE);
+        CHECK_FALSE(cache.replay(PT, *G_chain, "other cardinalities", CE, CF));
+    }
+}